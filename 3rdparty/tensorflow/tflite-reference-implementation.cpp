@@ -340,8 +340,8 @@ inline void Conv(const ConvParams& params, const RuntimeShape& input_shape,
   const int dilation_height_factor = params.dilation_height_factor;
   const int pad_width = params.padding_values.width;
   const int pad_height = params.padding_values.height;
-  //const float output_activation_min = params.float_activation_min;
-  //const float output_activation_max = params.float_activation_max;
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
@@ -393,13 +393,9 @@ inline void Conv(const ConvParams& params, const RuntimeShape& input_shape,
             bias_value = bias_data[out_channel];
           }
           output_data[Offset(output_shape, batch, out_y, out_x, out_channel)] =
-              // DISABLE ActivationFunctionWithMinMax
-              //ActivationFunctionWithMinMax(total + bias_value,
-              //                             output_activation_min,
-              //                             output_activation_max);
-
-	      // INSTEAD
-	      total + bias_value;
+              ActivationFunctionWithMinMax(total + bias_value,
+                                           output_activation_min,
+                                           output_activation_max);
         }
       }
     }
@@ -420,8 +416,8 @@ inline void DepthwiseConv(
   const int pad_width = params.padding_values.width;
   const int pad_height = params.padding_values.height;
   const int depth_multiplier = params.depth_multiplier;
-  //const float output_activation_min = params.float_activation_min;
-  //const float output_activation_max = params.float_activation_max;
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
@@ -469,13 +465,9 @@ inline void DepthwiseConv(
               bias_value = bias_data[oc];
             }
             output_data[Offset(output_shape, b, out_y, out_x, oc)] =
-              // DISABLE ActivationFunctionWithMinMax
-              //  ActivationFunctionWithMinMax(total + bias_value,
-              //                               output_activation_min,
-              //                               output_activation_max);
-
-	      // INSTEAD
-	      total + bias_value;
+                ActivationFunctionWithMinMax(total + bias_value,
+                                             output_activation_min,
+                                             output_activation_max);
           }
         }
       }
@@ -490,8 +482,8 @@ inline void FullyConnected(
     const float* weights_data, const RuntimeShape& bias_shape,
     const float* bias_data, const RuntimeShape& output_shape,
     float* output_data) {
-//  const float output_activation_min = params.float_activation_min;
-//  const float output_activation_max = params.float_activation_max;
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
   // TODO(benoitjacob): This really should be:
   //     const int batches = ArraySize(output_dims, 1);
   // but the current --variable_batch hack consists in overwriting the 3rd
@@ -514,13 +506,8 @@ inline void FullyConnected(
       if (bias_data) {
         bias_value = bias_data[out_c];
       }
-
-      // DISABLE ActivationFunctionWithMinMax
-      //output_data[out_c + output_depth * b] = ActivationFunctionWithMinMax(
-      //    total + bias_value, output_activation_min, output_activation_max);
-
-      // INSTEAD
-      output_data[out_c + output_depth * b] = total + bias_value;
+      output_data[out_c + output_depth * b] = ActivationFunctionWithMinMax(
+          total + bias_value, output_activation_min, output_activation_max);
     }
   }
 }
@@ -568,12 +555,8 @@ inline void MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
             }
           }
           output_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-              // DISABLE ActivationFunctionWithMinMax
-              //ActivationFunctionWithMinMax(max, params.float_activation_min,
-              //                             params.float_activation_max);
-
-	      // INSTEAD
-	      max;
+              ActivationFunctionWithMinMax(max, params.float_activation_min,
+                                           params.float_activation_max);
         }
       }
     }
@@ -626,12 +609,8 @@ inline void AveragePool(const PoolParams& params,
           }
           const float average = total / filter_count;
           output_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-              // DISABLE ActivationFunctionWithMinMax
-              //ActivationFunctionWithMinMax(average, params.float_activation_min,
-              //                             params.float_activation_max);
-
-	      // INSTEAD
-	      average;
+              ActivationFunctionWithMinMax(average, params.float_activation_min,
+                                           params.float_activation_max);
         }
       }
     }
@@ -1016,18 +995,20 @@ inline void PadImageStyle(const tflite::PadParams& op_params,
 // exporting this functionality by wrapping it in our API
 //
 
+#include "../../nn-operators.h"
 #include "../../tensor.h"
 
-namespace NnOperators {
+namespace NnOperators::Reference {
 
 void Conv2D(
 	const TensorShape &inputShape, const float *inputData,
 	const TensorShape &filterShape, const float *filterData,
 	const TensorShape &biasShape, const float *biasData,
 	const TensorShape &outputShape, float *outputData,
-	unsigned paddingWidth, unsigned paddingHeight,
+	int paddingWidth, int paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
-	unsigned dilationWidthFactor, unsigned dilationHeightFactor
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	float activationMin, float activationMax
 ) {
 	tflite::ConvParams params;
 	params.padding_values.width = paddingWidth;
@@ -1036,6 +1017,8 @@ void Conv2D(
 	params.stride_height = strideHeight;
 	params.dilation_width_factor = dilationWidthFactor;
 	params.dilation_height_factor = dilationHeightFactor;
+	params.float_activation_min = activationMin;
+	params.float_activation_max = activationMax;
 
 	tflite::Conv(params,
 		tflite::RuntimeShape(inputShape),  inputData,
@@ -1052,10 +1035,11 @@ void DepthwiseConv2D(
 	const TensorShape &filterShape, const float *filterData,
 	const TensorShape &biasShape, const float *biasData,
 	const TensorShape &outputShape, float *outputData,
-	unsigned paddingWidth, unsigned paddingHeight,
+	int paddingWidth, int paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
 	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
-	unsigned depthMultiplier
+	unsigned depthMultiplier,
+	float activationMin, float activationMax
 ) {
 	tflite::DepthwiseParams params;
 	params.padding_values.width = paddingWidth;
@@ -1065,6 +1049,8 @@ void DepthwiseConv2D(
 	params.dilation_width_factor = dilationWidthFactor;
 	params.dilation_height_factor = dilationHeightFactor;
 	params.depth_multiplier = depthMultiplier;
+	params.float_activation_min = activationMin;
+	params.float_activation_max = activationMax;
 
 	tflite::DepthwiseConv(params,
 		tflite::RuntimeShape(inputShape),  inputData,
@@ -1078,9 +1064,12 @@ void FullyConnected(
 	const TensorShape &inputShape, const float *inputData,
 	const TensorShape &filterShape, const float *filterData,
 	const TensorShape &biasShape, const float *biasData,
-	const TensorShape &outputShape, float *outputData
+	const TensorShape &outputShape, float *outputData,
+	float activationMin, float activationMax
 ) {
 	tflite::FullyConnectedParams params;
+	params.float_activation_min = activationMin;
+	params.float_activation_max = activationMax;
 
 	tflite::FullyConnected(params,
 		tflite::RuntimeShape(inputShape),  inputData,
@@ -1093,9 +1082,10 @@ void FullyConnected(
 void MaxPool(
 	const TensorShape &inputShape, const float *inputData,
 	const TensorShape &outputShape, float *outputData,
-	unsigned paddingWidth, unsigned paddingHeight,
+	int paddingWidth, int paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
-	unsigned filterWidth, unsigned filterHeight
+	unsigned filterWidth, unsigned filterHeight,
+	float activationMin, float activationMax
 ) {
 	tflite::PoolParams params;
 	params.padding_values.width = paddingWidth;
@@ -1104,6 +1094,8 @@ void MaxPool(
 	params.stride_height = strideHeight;
 	params.filter_width = filterWidth;
 	params.filter_height = filterHeight;
+	params.float_activation_min = activationMin;
+	params.float_activation_max = activationMax;
 
 	tflite::MaxPool(params,
 		tflite::RuntimeShape(inputShape),  inputData,
@@ -1114,9 +1106,10 @@ void MaxPool(
 void AveragePool(
 	const TensorShape &inputShape, const float *inputData,
 	const TensorShape &outputShape, float *outputData,
-	unsigned paddingWidth, unsigned paddingHeight,
+	int paddingWidth, int paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
-	unsigned filterWidth, unsigned filterHeight
+	unsigned filterWidth, unsigned filterHeight,
+	float activationMin, float activationMax
 ) {
 	tflite::PoolParams params;
 	params.padding_values.width = paddingWidth;
@@ -1125,6 +1118,8 @@ void AveragePool(
 	params.stride_height = strideHeight;
 	params.filter_width = filterWidth;
 	params.filter_height = filterHeight;
+	params.float_activation_min = activationMin;
+	params.float_activation_max = activationMax;
 
 	tflite::AveragePool(params,
 		tflite::RuntimeShape(inputShape),  inputData,
@@ -1238,4 +1233,4 @@ void Pad(
 	);
 }
 
-} // NnOperators
+} // NnOperators::Reference
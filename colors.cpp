@@ -46,6 +46,7 @@ QColor getOperatorColor(PluginInterface::OperatorKind okind) {
 	case PluginInterface::KindSign:
 		return QColor(110,10,240);
 	case PluginInterface::KindDequantize:
+	case PluginInterface::KindQuantize:
 		return QColor(170,170,240); // light blue
 	case PluginInterface::KindArgMax:
 	case PluginInterface::KindArgMin:
@@ -0,0 +1,111 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "compute-thread.h"
+#include "misc.h"
+#include "util.h"
+
+#include <assert.h>
+
+ComputeThread::ComputeThread(QObject *parent
+	, const PluginInterface::Model *model_
+	, std::unique_ptr<Compute::Plan> &plan_
+	, std::map<PluginInterface::TensorId, std::shared_ptr<const float>> inputs
+	, bool keepAllIntermediates_
+	, const std::vector<PluginInterface::TensorId> &retainedTensors_
+	, Compute::Scheduling scheduling_
+	, bool compareQuantized_
+	, int shownTensorId_)
+: QThread(parent)
+, model(model_)
+, plan(plan_)
+, keepAllIntermediates(keepAllIntermediates_)
+, retainedTensors(retainedTensors_)
+, scheduling(scheduling_)
+, compareQuantized(compareQuantized_)
+, recomputeOnly(false)
+, shownTensorId(shownTensorId_)
+, tensorData(new std::vector<std::shared_ptr<const float>>(model_->numTensors()))
+, cancelFlag(false)
+, succ(false)
+{
+	// inputs are filled on the calling thread, before the computation starts
+	Compute::fillInputs(inputs, tensorData);
+}
+
+ComputeThread::ComputeThread(QObject *parent
+	, const PluginInterface::Model *model_
+	, std::unique_ptr<Compute::Plan> &plan_
+	, const std::vector<std::shared_ptr<const float>> &tensorData_
+	, int shownTensorId_)
+: QThread(parent)
+, model(model_)
+, plan(plan_)
+, keepAllIntermediates(false)
+, scheduling(Compute::Scheduling::Parallel)
+, compareQuantized(false)
+, recomputeOnly(true)
+, shownTensorId(shownTensorId_)
+, tensorData(new std::vector<std::shared_ptr<const float>>(tensorData_)) // the GUI thread keeps using its own results meanwhile
+, cancelFlag(false)
+, succ(false)
+{
+	assert(plan && plan->recomputable);
+}
+
+void ComputeThread::cancel() {
+	cancelFlag = true;
+}
+
+std::shared_ptr<const float> ComputeThread::getTensorData(PluginInterface::TensorId tensorId) const {
+	// every computed tensor is written once before it is reported, kept ones aren't released and their memory isn't reused
+	return (*tensorData)[tensorId];
+}
+
+void ComputeThread::run() {
+	auto cbWarningMessage = [this](const std::string &msg) {
+		emit warningMessage(S2Q(msg)); // channel warnings through the signal that crosses threads
+	};
+
+	// the tensor on screen is recomputed when the retention policy has discarded it
+	auto recomputeShownTensor = [this,cbWarningMessage]() {
+		if (shownTensorId < 0 || !plan->recomputable || (*tensorData)[shownTensorId] || !model->isTensorComputed(shownTensorId))
+			return true;
+		if (!Compute::recompute(*plan, tensorData, shownTensorId, cbWarningMessage))
+			return false;
+		emit tensorRecomputed(shownTensorId);
+		return true;
+	};
+	if (recomputeOnly) {
+		succ = recomputeShownTensor();
+		return;
+	}
+
+	// compile the model into the execution plan once, it is reused by subsequent computations
+	if (!plan)
+		plan.reset(Compute::compile(model, keepAllIntermediates, 1/*batchSize*/, true/*integerKernels*/, keepAllIntermediates ? nullptr : &retainedTensors));
+
+	// progress is measured in computed tensors
+	unsigned numTotal = 0, numComputed = 0;
+	for (auto &op : plan->operators)
+		numTotal += op.outputs.size();
+	auto cbTensorComputed = [this,numTotal,&numComputed](PluginInterface::TensorId tensorId) {
+		emit tensorComputed(tensorId, ++numComputed, numTotal);
+	};
+
+	// compute
+	succ = Compute::run(*plan, tensorData, cbTensorComputed, cbWarningMessage, scheduling, &cancelFlag, &profile) && recomputeShownTensor();
+	if (!succ)
+		return;
+
+	// accuracy of integer kernels compared to the float32 computation
+	if (compareQuantized && plan->numQuantizedOperators > 0) {
+		std::map<PluginInterface::TensorId, std::shared_ptr<const float>> inputs;
+		for (auto tid : model->getInputs())
+			inputs[tid] = (*tensorData)[tid];
+		std::vector<Compute::QuantizationError> errors;
+		if (Compute::compareWithFloatReference(model, inputs, errors, cbWarningMessage))
+			for (auto &error : errors)
+				PRINT("quantized model: output tensor#" << error.tensorId << " differs from the float32 reference by " << error.maxError <<
+				      " at most and by " << error.meanError << " on average, the range of the reference is " << error.range)
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "compute.h"
+#include "plugin-interface.h"
+
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+//
+// ComputeThread: computes the model off the GUI thread, computed tensors are reported one by one as they are produced
+//                it also recomputes the tensor on screen when the retention policy has discarded it
+//
+
+class ComputeThread : public QThread {
+	Q_OBJECT
+
+	const PluginInterface::Model                                 *model;
+	std::unique_ptr<Compute::Plan>                               &plan; // compiled by the first computation, only this thread touches it while it runs
+	bool                                                          keepAllIntermediates; // how the plan is compiled: all computed tensors are kept,
+	std::vector<PluginInterface::TensorId>                        retainedTensors;      // or these ones besides model outputs, others are recomputable
+	Compute::Scheduling                                           scheduling;
+	bool                                                          compareQuantized; // also compare the quantized model with the float32 reference
+	bool                                                          recomputeOnly;    // the model was computed by an earlier thread, only shownTensorId is recomputed
+	int                                                           shownTensorId;    // the tensor on screen, recomputed after the run when it is discarded, or -1
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>>    tensorData; // owned by this thread while it runs
+	std::atomic<bool>                                             cancelFlag;
+	Compute::Profile                                              profile;
+	bool                                                          succ;
+
+public:
+	ComputeThread(QObject *parent
+		, const PluginInterface::Model *model_
+		, std::unique_ptr<Compute::Plan> &plan_
+		, std::map<PluginInterface::TensorId, std::shared_ptr<const float>> inputs
+		, bool keepAllIntermediates_
+		, const std::vector<PluginInterface::TensorId> &retainedTensors_
+		, Compute::Scheduling scheduling_
+		, bool compareQuantized_
+		, int shownTensorId_);
+	ComputeThread(QObject *parent // recomputes a tensor of the finished computation with these results, that the thread copies
+		, const PluginInterface::Model *model_
+		, std::unique_ptr<Compute::Plan> &plan_
+		, const std::vector<std::shared_ptr<const float>> &tensorData_
+		, int shownTensorId_);
+
+public: // iface
+	void cancel(); // operators that are running finish, no other operators are started
+	bool succeeded() const {return succ;} // only after the thread has finished
+	bool recomputesOnly() const {return recomputeOnly;}
+	std::shared_ptr<const float> getTensorData(PluginInterface::TensorId tensorId) const; // only for tensors reported by tensorComputed that the run keeps,
+	                                                                                      // and for the tensor reported by tensorRecomputed
+	const Compute::Profile& getProfile() const {return profile;} // only after the thread has finished
+
+protected:
+	void run() override;
+
+signals: // delivered to the GUI thread through queued connections
+	void tensorComputed(PluginInterface::TensorId tensorId, unsigned numComputed, unsigned numTotal);
+	void tensorRecomputed(PluginInterface::TensorId tensorId); // it has memory of its own, unlike discarded tensors reported by tensorComputed
+	void warningMessage(const QString &msg);
+};
@@ -1,14 +1,23 @@
 // Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
 
 #include "compute.h"
+#include "memory-planner.h"
+#include "model-functions.h"
 #include "plugin-interface.h"
 #include "nn-types.h"
 #include "tensor.h"
+#include "tensor-view.h"
 #include "nn-operators.h"
+#include "kernels/conv.h"
+#include "kernels/elementwise.h"
+#include "kernels/quantized.h"
+#include "kernels/winograd.h"
+#include "thread-pool.h"
 #include "image.h"
 #include "misc.h"
 #include "util.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <array>
@@ -16,8 +25,15 @@
 #include <functional>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
 #include <assert.h>
+#include <half.hpp>
 
 #if defined(DEBUG)
 #define PRINT_OPTS(opts...) PRINT(opts)
@@ -58,27 +74,24 @@ static float computeLossMeanSquareError(const float *src1, const float *src2, un
 // helper for operators Concatenate and Split
 template<typename OneFloat, typename ManyFloat>
 void CopyTensorSlices(
-	const PI::Model *model
-	, PI::TensorId one
-	, const std::vector<PI::TensorId> &many
+	const TensorShape &oneShape
+	, const std::vector<TensorShape> &manyShapes
 	, OneFloat *oneTensorData
-	, std::shared_ptr<ManyFloat> *manyTensorData
+	, ManyFloat **manyTensorData
 	, int axis
 	, std::function<void(OneFloat* &one, ManyFloat* &split, unsigned num)> fnCopy)
 {
 	// compute inside and outside tensor sizes
-	TensorShape oneShape = model->getTensorShape(one);
 	unsigned outsideTensorSize = Tensor::sizeBetweenDims(oneShape, 0, axis-1);
 	unsigned insideTensorSize  = Tensor::sizeBetweenDims(oneShape, axis+1, oneShape.size()-1);
 
 	// create output data
-	unsigned manySize = many.size();
+	unsigned manySize = manyShapes.size();
 	ManyFloat* manyDataPtr[manySize];
 	unsigned outputSliceSize[manySize];
 	for (unsigned o = 0; o < manySize; o++) {
-		TensorShape manyShape = model->getTensorShape(many[o]);
-		outputSliceSize[o] = manyShape[axis]*insideTensorSize;
-		manyDataPtr[o] = manyTensorData[o].get();
+		outputSliceSize[o] = manyShapes[o][axis]*insideTensorSize;
+		manyDataPtr[o] = manyTensorData[o];
 	}
 
 	OneFloat *oneDataPtr0 = oneTensorData, *oneDataPtr = oneDataPtr0;
@@ -88,6 +101,990 @@ void CopyTensorSlices(
 	assert(oneDataPtr == oneDataPtr0+Tensor::flatSize(oneShape));
 }
 
+//
+// run-time state and kernels bound into plans
+//
+
+static const size_t NoOffset = std::numeric_limits<size_t>::max(); // the tensor isn't in the arena
+
+struct Execution {
+	const Plan                                      &plan;
+	std::shared_ptr<uint8_t>                         arena;
+	std::vector<std::shared_ptr<const float>>       &tensorData;
+	std::vector<TensorView>                         &views; // strided outputs of view operators, tensorData is empty for them
+	std::vector<const void*>                        &integerData; // integer values that integer kernels computed in this run, in the arena
+	std::vector<std::shared_ptr<const float>>       &staticData; // float32 data of static inputs by tensor, held by the run
+	std::function<void(PI::TensorId)>               &cbTensorComputed;
+	std::function<void(const std::string&)>         &cbWarningMessage;
+	const std::atomic<bool>                         *cancel = nullptr; // set by another thread to stop the run between operators
+	std::vector<double>                             *operatorTimes = nullptr; // by operator index in the plan, when the run is profiled
+
+	bool cancelled() const {
+		return cancel && cancel->load(std::memory_order_relaxed);
+	}
+	const float* input(const OperatorPlan &op, unsigned idx) const { // dynamic or static input
+		auto &dynamic = tensorData[op.inputs[idx]];
+		assert(dynamic || op.inputStaticData[idx]); // at least one of dynamic and static should be available
+		assert(!(dynamic && op.inputStaticData[idx])); // both dynamic and static can't be available
+		if (dynamic)
+			return dynamic.get();
+		if (auto &data = staticData[op.inputs[idx]])
+			return data.get();
+		return static_cast<const float*>(op.inputStaticData[idx]); // expanded by the plan
+	}
+	TensorView inputView(const OperatorPlan &op, unsigned idx) const { // strided view, or the whole packed input
+		auto tid = op.inputs[idx];
+		if (!tensorData[tid] && views[tid].base)
+			return views[tid];
+		auto &data = tensorData[tid] ? tensorData[tid] : staticData[tid]; // views of it can outlive the run
+		return TensorView(data ? data : std::shared_ptr<const float>(std::shared_ptr<const float>(), input(op, idx)), op.inputShapes[idx]);
+	}
+	void materializeInputs(const OperatorPlan &op) { // kernels need packed inputs: strided views are copied by their only consumer into its arena space
+		for (unsigned i = 0, ie = op.inputs.size(); i < ie; i++) {
+			auto tid = op.inputs[i];
+			if (!tensorData[tid] && views[tid].base) {
+				assert(i < op.viewInputOffsets.size() && op.viewInputOffsets[i] != NoOffset); // planned for inputs that are lazy views
+				auto data = reinterpret_cast<float*>(arena.get() + op.viewInputOffsets[i]);
+				views[tid].copyTo(data);
+				tensorData[tid] = std::shared_ptr<const float>(arena, data); // shares the ownership of the arena
+				views[tid] = TensorView();
+			}
+		}
+	}
+	float* allocateOutput(const OperatorPlan &op, unsigned idx) { // outputs are placed in the arena according to the memory plan
+		auto offset = plan.tensorOffsets[op.outputs[idx]];
+		assert(offset != NoOffset);
+		auto data = reinterpret_cast<float*>(arena.get() + offset);
+		tensorData[op.outputs[idx]] = std::shared_ptr<const float>(arena, data); // shares the ownership of the arena
+		return data;
+	}
+	void outputsComputed(const OperatorPlan &op) { // notify the caller
+		for (auto output : op.outputs)
+			cbTensorComputed(output);
+	}
+	bool fail(const OperatorPlan &op, const std::string &msg) {
+		cbWarningMessage(STR("Computation didn't succeed: operator #" << (op.oid+1) << ": " << op.kind << " " << msg));
+		return false; // failed to compute the model to the end
+	}
+};
+
+// activation functions are fused into kernels: they are applied when the output values are stored
+static Kernels::Activation toActivation(PI::ActivationFunction activationFunction) {
+	switch (activationFunction) {
+	case PI::ActivationFunction_RELU:
+		return Kernels::Activation::clamp(0, std::numeric_limits<float>::infinity());
+	case PI::ActivationFunction_RELU_N1_TO_1:
+		return Kernels::Activation::clamp(-1, 1);
+	case PI::ActivationFunction_RELU6:
+		return Kernels::Activation::clamp(0, 6);
+	case PI::ActivationFunction_TANH:
+		return Kernels::Activation::tanh();
+	case PI::ActivationFunction_SIGN_BIT:
+		return Kernels::Activation::signBit();
+	case PI::ActivationFunction_NONE:
+		break;
+	}
+	return Kernels::Activation();
+}
+
+static bool runUnsupported(const OperatorPlan &op, Execution &ex) {
+	return ex.fail(op, "isn't yet implemented");
+}
+
+static bool runNotBatchable(const OperatorPlan &op, Execution &ex) {
+	return ex.fail(op, STR("can't be computed on a batch of " << ex.plan.batchSize << " samples"));
+}
+
+static std::shared_ptr<const Kernels::Winograd::Filter> getWinogradFilter(const Execution &ex, const OperatorPlan &op) {
+	auto &plan = ex.plan;
+	std::unique_lock<std::mutex> lock(plan.winogradFiltersLock);
+	auto &filter = plan.winogradFilters[{op.inputs[1], op.winogradTileSize}];
+	if (!filter) {
+		if (op.float16Filter) { // the transformed filter is float32 anyway, the widened copy is only needed for the transform
+			auto size = Tensor::flatSize(op.inputShapes[1]);
+			auto halfFilter = static_cast<const half_float::half*>(op.inputStaticData[1]);
+			std::unique_ptr<float[]> widened(new float[size]);
+			std::copy(halfFilter, halfFilter + size, widened.get());
+			filter = Kernels::Winograd::transformFilter(op.inputShapes[1], widened.get(), op.winogradTileSize);
+		} else
+			filter = Kernels::Winograd::transformFilter(op.inputShapes[1], ex.input(op, 1), op.winogradTileSize);
+	}
+	return filter;
+}
+
+static std::shared_ptr<const Kernels::Gemm::PackedWeights> getPackedFilter(const Execution &ex, const OperatorPlan &op) {
+	auto &plan = ex.plan;
+	std::unique_lock<std::mutex> lock(plan.packedFiltersLock);
+	auto &filter = plan.packedFilters[op.inputs[1]];
+	if (!filter) {
+		auto &shape = op.inputShapes[1];
+		std::shared_ptr<Kernels::Gemm::PackedWeights> packed(new Kernels::Gemm::PackedWeights);
+		if (op.float16Filter) // widened once, panels are float32 like those of float32 filters
+			Kernels::Gemm::packWeights(static_cast<const half_float::half*>(op.inputStaticData[1]), shape[0], Tensor::sizeBetweenDims(shape, 1, 3), *packed);
+		else
+			Kernels::Gemm::packWeights(ex.input(op, 1), shape[0], Tensor::sizeBetweenDims(shape, 1, 3), *packed);
+		filter = packed;
+	}
+	return filter;
+}
+
+static bool runConv2D(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	if (op.winogradTileSize) {
+		Kernels::Winograd::Conv2D(
+			op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+			*getWinogradFilter(ex, op), // filter - static, transformed once
+			ex.input(op, 2), // bias
+			op.outputShapes[0], output, // output
+			p.paddingWidth, p.paddingHeight,
+			toActivation(p.activationFunction),
+			op.outputStride
+		);
+	} else if (op.inputStaticData[1]) {
+		Kernels::Conv2D(
+			op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+			op.inputShapes[1], *getPackedFilter(ex, op), // filter - static float32 or float16, packed once
+			op.inputShapes[2], ex.input(op, 2), // bias - assume that it is always a static tensor
+			op.outputShapes[0], output, // output
+			p.paddingWidth, p.paddingHeight,
+			p.strideWidth, p.strideHeight,
+			p.dilationWidth, p.dilationHeight,
+			toActivation(p.activationFunction),
+			op.outputStride
+		);
+	} else {
+		NnOperators::Conv2D(
+			op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+			op.inputShapes[1], ex.input(op, 1), // filter - computed, packed by every run
+			op.inputShapes[2], ex.input(op, 2), // bias - assume that it is always a static tensor
+			op.outputShapes[0], output, // output
+			p.paddingWidth, p.paddingHeight,
+			p.strideWidth, p.strideHeight,
+			p.dilationWidth, p.dilationHeight,
+			toActivation(p.activationFunction),
+			op.outputStride
+		);
+	}
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runDepthwiseConv2D(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	NnOperators::DepthwiseConv2D(
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.inputShapes[1], ex.input(op, 1), // filter
+		op.inputShapes[2], ex.input(op, 2), // bias
+		op.outputShapes[0], output, // output
+		p.paddingWidth, p.paddingHeight,
+		p.strideWidth, p.strideHeight,
+		p.dilationWidth, p.dilationHeight,
+		p.depthMultiplier,
+		toActivation(p.activationFunction)
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runPad(const OperatorPlan &op, Execution &ex) {
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	NnOperators::Pad(
+		static_cast<const std::array<int32_t,2>*>(op.inputStaticData[1]),
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.outputShapes[0], output // output
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runFullyConnected(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	if (p.weightsFormat != 0)
+		return ex.fail(op, "option weights_format isn't zero");
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	auto &biasShape = op.inputShapes[2];
+	if (op.float16Filter)
+		NnOperators::FullyConnected(
+			op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+			op.inputShapes[1], static_cast<const half_float::half*>(op.inputStaticData[1]), // filter - static float16, widened as it is streamed
+			biasShape, biasShape.size()==1 ? ex.input(op, 2) : nullptr, // bias
+			op.outputShapes[0], output, // output
+			toActivation(p.activationFunction)
+		);
+	else
+		NnOperators::FullyConnected(
+			op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+			op.inputShapes[1], ex.input(op, 1), // filter
+			biasShape, biasShape.size()==1 ? ex.input(op, 2) : nullptr, // bias
+			op.outputShapes[0], output, // output
+			toActivation(p.activationFunction)
+		);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runLocalResponseNormalization(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	NnOperators::LocalResponseNormalization(
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.outputShapes[0], output, // output
+		p.radius, p.alpha, p.beta, p.bias
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runPool(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	(op.kind==PI::KindMaxPool ? NnOperators::MaxPool : NnOperators::AveragePool)(
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.outputShapes[0], output, // output
+		p.paddingWidth, p.paddingHeight,
+		p.strideWidth, p.strideHeight,
+		p.filterWidth, p.filterHeight,
+		toActivation(p.activationFunction)
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+template<float(*fn)(float f)>
+static bool runSingleOperator(const OperatorPlan &op, Execution &ex) {
+	assert(op.inputShapes[0]==op.outputShapes[0]);
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	auto input = ex.tensorData[op.inputs[0]].get();
+	for (auto inpute = input+Tensor::flatSize(op.inputShapes[0]); input<inpute; input++, output++)
+		*output = fn(*input);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static float computeTanh(float x) {
+	return std::tanh(x);
+}
+
+static float computeLogistic(float x) {
+	return 1./(1. + std::exp(x));
+}
+
+static float computeHardSwish(float x) {
+	// defined in the "Searching for MobileNet3" paper (https://arxiv.org/pdf/1905.02244.pdf)
+	// h-swish(x) = x*(ReLU6(x+3)/6)
+	if (x>=3)
+		return x;
+	else if (x<=-3)
+		return (float)0;
+	else
+		return x*(x+3)/6;
+}
+
+static float computeRSqrt(float x) {
+	return 1./std::sqrt(x);
+}
+
+static float computeRelu(float x) {
+	if (x >= 0)
+		return x;
+	else
+		return 0;
+}
+
+static float computeSign(float x) {
+	if (x > 0)
+		return +1;
+	if (x < 0)
+		return -1;
+	return 0;
+}
+
+static bool runReshape(const OperatorPlan &op, Execution &ex) {
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// just share the data array
+	ex.tensorData[op.outputs[0]] = ex.tensorData[op.inputs[0]];
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+template<Kernels::Elementwise::Op Op>
+static bool runElementwise(const OperatorPlan &op, Execution &ex) {
+	auto &input1Shape = op.inputShapes[0];
+	auto &input2Shape = op.inputShapes[1];
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	if (!Kernels::Elementwise::compute(Op,
+		input1Shape, ex.input(op, 0),
+		input2Shape, ex.input(op, 1),
+		op.outputShapes[0], output,
+		toActivation(op.params.activationFunction)))
+	{
+		return ex.fail(op, STR("can't broadcast shapes " << input1Shape << " and " << input2Shape << " to " << op.outputShapes[0]));
+	}
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runSoftmax(const OperatorPlan &op, Execution &ex) {
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	NnOperators::Softmax(
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.outputShapes[0], output, // output
+		op.params.beta
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runConcatenation(const OperatorPlan &op, Execution &ex) {
+	// in place: the output is already in the arena where its producers wrote its inputs
+	if (op.inPlace) {
+		ex.allocateOutput(op, 0);
+		ex.outputsComputed(op);
+		return true;
+	}
+
+	// input tensors
+	const float* inputTensorData[op.inputs.size()];
+	for (unsigned o = 0, oe = op.inputs.size(); o < oe; o++)
+		inputTensorData[o] = ex.tensorData[op.inputs[o]].get();
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	auto activation = toActivation(op.params.activationFunction);
+	CopyTensorSlices<float,const float>(op.outputShapes[0], op.inputShapes, output, inputTensorData, op.params.axis,
+		[&activation](float* &one, const float* &split, unsigned num) {
+			if (activation.isNone())
+				std::memcpy(one, split, num*sizeof(float));
+			else
+				for (unsigned i = 0; i < num; i++)
+					one[i] = activation(split[i]);
+			one += num;
+			split += num;
+		}
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+// Split, StridedSlice and Transpose select elements of their input: their outputs are views of the input
+static unsigned viewInputIndex(const OperatorPlan &op) {
+	return op.kind == PI::KindSplit ? 1 : 0;
+}
+
+static TensorView outputView(const OperatorPlan &op, const TensorView &input, unsigned idx) {
+	auto &p = op.params;
+	switch (op.kind) {
+	case PI::KindSplit: {
+		unsigned axis = p.axis < 0 ? p.axis + (int)input.shape.size() : p.axis;
+		auto size = op.outputShapes[idx][axis];
+		return input.slice(axis, idx*size, size);
+	} case PI::KindStridedSlice: {
+		auto view = input;
+		for (unsigned d = 0; d < p.sliceBegin.size(); d++)
+			view = view.slice(d, p.sliceBegin[d], p.sliceSize[d], p.sliceStep[d]);
+		for (int d = (int)view.shape.size() - 1; d >= 0; d--)
+			if (p.shrinkAxisMask & (1 << d))
+				view = view.removeDim(d);
+		return view;
+	} case PI::KindTranspose:
+		return input.transpose(p.perm);
+	default:
+		assert(false);
+		return input;
+	}
+}
+
+static bool runView(const OperatorPlan &op, Execution &ex) {
+	auto input = ex.inputView(op, viewInputIndex(op));
+
+	for (unsigned o = 0, oe = op.outputs.size(); o < oe; o++) {
+		auto view = outputView(op, input, o);
+		assert(Tensor::flatSize(view.shape) == Tensor::flatSize(op.outputShapes[o]));
+		switch (op.viewOutputs[o]) {
+		case OperatorPlan::ViewOutput::Copy:
+			view.copyTo(ex.allocateOutput(op, o));
+			break;
+		case OperatorPlan::ViewOutput::Alias:
+			ex.tensorData[op.outputs[o]] = view.contiguousData();
+			break;
+		case OperatorPlan::ViewOutput::Lazy:
+			ex.views[op.outputs[o]] = view;
+			break;
+		}
+	}
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runMean(const OperatorPlan &op, Execution &ex) {
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	NnOperators::Mean(
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.outputShapes[0], output, // output
+		static_cast<const int32_t*>(op.inputStaticData[1]), Tensor::flatSize(op.inputShapes[1])
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+template<bool Max>
+static bool runArgMxx(const OperatorPlan &op, Execution &ex) {
+	auto batches = Tensor::flatSize(op.outputShapes[0]);
+	assert(batches == ex.plan.batchSize || batches == 1);
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0); // always return one number per sample
+
+	// compute
+	auto input = ex.tensorData[op.inputs[0]].get();
+	for (unsigned b = 0; b < batches; b++) {
+		float v0 = Max ? std::numeric_limits<float>::lowest() : std::numeric_limits<float>::max();
+		int idx = -1;
+		for (unsigned i = 0, ie = Tensor::flatSize(op.inputShapes[0])/batches; i < ie; i++) {
+			auto v = *input++;
+			if (Max ? v > v0 : v < v0) {
+				idx = i;
+				v0 = v;
+			}
+		}
+		output[b] = idx;
+	}
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runResize(const OperatorPlan &op, Execution &ex) {
+	assert(ex.tensorData[op.inputs[0]]); // need to have the input data present
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	(op.kind==PI::KindResizeBilinear ? NnOperators::ResizeBilinear : NnOperators::ResizeNearestNeighbor)(
+		op.inputShapes[0], ex.tensorData[op.inputs[0]].get(), // input
+		op.outputShapes[0], output, // output
+		op.params.alignCorners
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runOuterProduct(const OperatorPlan &op, Execution &ex) {
+	auto &input1Shape = op.inputShapes[0];
+	auto &input2Shape = op.inputShapes[1];
+	assert(input1Shape.size()==2 && input1Shape[0]==1 && input2Shape.size()==2 && input2Shape[0]==1);
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	auto computeOuterProduct = [](const float *left, unsigned Nleft, const float *right, unsigned Nright, float *result) {
+		auto righte = right + Nright;
+		for (auto lefte = left+Nleft; left < lefte; left++)
+			for (auto r = right; r < righte; r++)
+				*result++ = *left * *r;
+	};
+	computeOuterProduct(
+		ex.input(op, 0), input1Shape[1],
+		ex.input(op, 1), input2Shape[1],
+		output
+	);
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool runLoss(const OperatorPlan &op, Execution &ex) {
+	assert(Tensor::flatSize(op.outputShapes[0])==1);
+	assert(op.inputShapes[0] == op.inputShapes[1]);
+
+	auto sz = Tensor::flatSize(op.inputShapes[0]);
+	auto input1 = ex.tensorData[op.inputs[0]].get();
+	auto input2 = ex.tensorData[op.inputs[1]].get();
+
+	// create output data
+	auto output = ex.allocateOutput(op, 0);
+
+	// compute
+	if (op.kind == PI::KindLossMeanSquareError)
+		output[0] = computeLossMeanSquareError(input1, input2, sz);
+	else if (sz==1) // a simplified computation in a 1D case
+		output[0] = std::abs(input1[0] - input2[0]);
+	else
+		output[0] = std::sqrt(computeLossMeanSquareError(input1, input2, sz));
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+/// quantized operators: integer kernels pass integer values to each other through the arena, real values of inputs
+/// are quantized when their producers are float kernels, real values of outputs are computed when anybody needs them
+
+struct QuantizedOperator {
+	PI::DataType                                  type;   // Int8 or UInt8
+	std::vector<Kernels::Quantized::Quantization> inputs; // of dynamic inputs
+	Kernels::Quantized::Quantization              output;
+	int32_t                                       filterZeroPoint = 0;
+	std::unique_ptr<int16_t[]>                    filter; // static filter values relative to the zero point, refreshed by runIncremental
+	Kernels::Quantized::Requantization            requantization; // multipliers of accumulators, the output range narrowed by the activation function
+};
+
+static void offsetFilter(const OperatorPlan &op, const QuantizedOperator &q) { // called when the operator is bound and when the filter changes
+	auto size = Tensor::flatSize(op.inputShapes[1]);
+	if (q.type == PI::DataType_Int8)
+		Kernels::Quantized::offsetValues(static_cast<const int8_t*>(op.inputStaticData[1]), size, q.filterZeroPoint, q.filter.get());
+	else
+		Kernels::Quantized::offsetValues(static_cast<const uint8_t*>(op.inputStaticData[1]), size, q.filterZeroPoint, q.filter.get());
+}
+
+template<typename T>
+static const T* integerInput(const OperatorPlan &op, Execution &ex, unsigned idx) {
+	auto tid = op.inputs[idx];
+	if (ex.integerData[tid])
+		return static_cast<const T*>(ex.integerData[tid]);
+	assert(op.scratchOffsets[idx] != NoOffset); // planned for inputs that can come without integer values
+	auto input = reinterpret_cast<T*>(ex.arena.get() + op.scratchOffsets[idx]);
+	Kernels::Quantized::quantize(ex.tensorData[tid].get(), Tensor::flatSize(op.inputShapes[idx]), op.quantized->inputs[idx], input);
+	return input;
+}
+
+template<typename T>
+static T* integerOutput(const OperatorPlan &op, Execution &ex) {
+	auto tid = op.outputs[0];
+	auto output = reinterpret_cast<T*>(ex.arena.get() + ex.plan.integerOffsets[tid]);
+	ex.integerData[tid] = output;
+	return output;
+}
+
+template<typename T>
+static void integerOutputComputed(const OperatorPlan &op, Execution &ex, const T *output) {
+	if (ex.plan.tensorOffsets[op.outputs[0]] != NoOffset) // real values are needed
+		Kernels::Quantized::dequantize(output, Tensor::flatSize(op.outputShapes[0]), op.quantized->output, ex.allocateOutput(op, 0));
+	ex.outputsComputed(op);
+}
+
+template<typename T>
+static bool runQuantizedConv2D(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	auto &q = *op.quantized;
+	auto input = integerInput<T>(op, ex, 0);
+	auto output = integerOutput<T>(op, ex);
+
+	if (op.kind == PI::KindConv2D)
+		Kernels::Quantized::Conv2D<T>(
+			op.inputShapes[0], input, q.inputs[0].zeroPoint, // input
+			op.inputShapes[1], q.filter.get(), // filter
+			static_cast<const int32_t*>(op.inputStaticData[2]), // bias
+			op.outputShapes[0], output, q.requantization, // output
+			p.paddingWidth, p.paddingHeight,
+			p.strideWidth, p.strideHeight,
+			p.dilationWidth, p.dilationHeight
+		);
+	else
+		Kernels::Quantized::DepthwiseConv2D<T>(
+			op.inputShapes[0], input, q.inputs[0].zeroPoint, // input
+			op.inputShapes[1], q.filter.get(), // filter
+			static_cast<const int32_t*>(op.inputStaticData[2]), // bias
+			op.outputShapes[0], output, q.requantization, // output
+			p.paddingWidth, p.paddingHeight,
+			p.strideWidth, p.strideHeight,
+			p.dilationWidth, p.dilationHeight,
+			p.depthMultiplier
+		);
+
+	integerOutputComputed(op, ex, output);
+	return true;
+}
+
+template<typename T>
+static bool runQuantizedFullyConnected(const OperatorPlan &op, Execution &ex) {
+	auto &q = *op.quantized;
+	if (op.params.weightsFormat != 0)
+		return ex.fail(op, "option weights_format isn't zero");
+	auto input = integerInput<T>(op, ex, 0);
+	auto output = integerOutput<T>(op, ex);
+
+	Kernels::Quantized::FullyConnected<T>(
+		op.inputShapes[0], input, q.inputs[0].zeroPoint, reinterpret_cast<int16_t*>(ex.arena.get() + op.scratchOffsets[1]), // input
+		op.inputShapes[1], q.filter.get(), // filter
+		op.inputShapes.size() > 2 && op.inputShapes[2].size()==1 ? static_cast<const int32_t*>(op.inputStaticData[2]) : nullptr, // bias
+		op.outputShapes[0], output, q.requantization // output
+	);
+
+	integerOutputComputed(op, ex, output);
+	return true;
+}
+
+template<typename T>
+static bool runQuantizedAdd(const OperatorPlan &op, Execution &ex) {
+	auto &q = *op.quantized;
+	auto input1 = integerInput<T>(op, ex, 0), input2 = integerInput<T>(op, ex, 1);
+	auto size = Tensor::flatSize(op.outputShapes[0]);
+	auto output = integerOutput<T>(op, ex);
+
+	// one of the inputs can be a single value
+	bool swap = Tensor::flatSize(op.inputShapes[0]) != size;
+	Kernels::Quantized::Add<T>(
+		size, swap ? input2 : input1, q.inputs[swap ? 1 : 0],
+		Tensor::flatSize(op.inputShapes[swap ? 0 : 1]), swap ? input1 : input2, q.inputs[swap ? 0 : 1],
+		output, q.output, q.requantization.min, q.requantization.max
+	);
+
+	integerOutputComputed(op, ex, output);
+	return true;
+}
+
+template<typename T>
+static bool runQuantizedPool(const OperatorPlan &op, Execution &ex) {
+	auto &p = op.params;
+	auto &q = *op.quantized;
+	auto input = integerInput<T>(op, ex, 0);
+	auto output = integerOutput<T>(op, ex);
+
+	(op.kind==PI::KindMaxPool ? Kernels::Quantized::MaxPool<T> : Kernels::Quantized::AveragePool<T>)(
+		op.inputShapes[0], input, // input
+		op.outputShapes[0], output, // output
+		p.paddingWidth, p.paddingHeight,
+		p.strideWidth, p.strideHeight,
+		p.filterWidth, p.filterHeight,
+		q.requantization.min, q.requantization.max
+	);
+
+	integerOutputComputed(op, ex, output);
+	return true;
+}
+
+template<typename T>
+static bool runQuantizedSoftmax(const OperatorPlan &op, Execution &ex) {
+	auto &q = *op.quantized;
+	auto input = integerInput<T>(op, ex, 0);
+	auto output = integerOutput<T>(op, ex);
+
+	Kernels::Quantized::Softmax<T>(op.inputShapes[0], input, q.inputs[0].scale, op.params.beta, output, q.output);
+
+	integerOutputComputed(op, ex, output);
+	return true;
+}
+
+// Quantize: real values are rounded to the nearest values that the output can represent
+template<typename T>
+static bool runQuantize(const OperatorPlan &op, Execution &ex) {
+	auto output = integerOutput<T>(op, ex);
+	Kernels::Quantized::quantize(ex.input(op, 0), Tensor::flatSize(op.outputShapes[0]), op.quantized->output, output);
+
+	integerOutputComputed(op, ex, output);
+	return true;
+}
+
+// Dequantize, and Quantize computed by float kernels: computed inputs already have real values,
+// static ones are dequantized during compilation
+static bool runCopy(const OperatorPlan &op, Execution &ex) {
+	auto output = ex.allocateOutput(op, 0);
+	std::memcpy(output, ex.input(op, 0), Tensor::flatSize(op.outputShapes[0])*sizeof(float));
+
+	ex.outputsComputed(op);
+	return true;
+}
+
+static bool isBatchable(const OperatorPlan &op, const std::vector<bool> &batchedTensors) {
+	// all outputs should have the batch dimension
+	for (auto tid : op.outputs)
+		if (!batchedTensors[tid])
+			return false;
+
+	// operators that reduce or rearrange along the batch dimension
+	auto isBatchAxis = [&op](int axis) {
+		return axis == 0 || axis == -(int)op.inputShapes[op.kind==PI::KindSplit ? 1 : 0].size();
+	};
+	switch (op.kind) {
+	case PI::KindOuterProduct:
+	case PI::KindLossMeanSquareError:
+	case PI::KindLossMeanAbsoluteError:
+		return false;
+	case PI::KindConcatenation:
+	case PI::KindSplit:
+		return !isBatchAxis(op.params.axis);
+	case PI::KindMean: {
+		auto axes = static_cast<const int32_t*>(op.inputStaticData[1]);
+		return !std::any_of(axes, axes + Tensor::flatSize(op.inputShapes[1]), isBatchAxis);
+	} case PI::KindPad: {
+		auto paddings = static_cast<const std::array<int32_t,2>*>(op.inputStaticData[1]);
+		return paddings[0][0] == 0 && paddings[0][1] == 0;
+	} case PI::KindStridedSlice:
+		return op.params.sliceSize.empty() || (op.params.sliceSize[0] == (int)op.inputShapes[0][0] && op.params.sliceStep[0] == 1 && !(op.params.shrinkAxisMask & 1));
+	case PI::KindTranspose:
+		return op.params.perm.empty() || op.params.perm[0] == 0;
+	default:
+		return true;
+	}
+}
+
+static unsigned translatePadding(unsigned stride, unsigned dilationRate,
+                                 WidthHeight wh, const TensorShape &inputShape, const TensorShape &filterShape, const TensorShape &outputShape)
+{
+	//return filterShape[wh==WIDTH ? 2:1]/2;
+	unsigned shapeIdx = wh==WIDTH ? 2:1;
+	return std::get<0>(computePaddingValues(stride, dilationRate, inputShape[shapeIdx], filterShape[shapeIdx], outputShape[shapeIdx]));
+}
+
+// quantization with one scale for the whole tensor
+static bool getTensorQuantization(const PI::Model *model, PI::TensorId tid, Kernels::Quantized::Quantization &quantization) {
+	PI::TensorQuantization q;
+	if (!model->getTensorQuantization(tid, q) || q.scales.size() != 1)
+		return false;
+	quantization = {q.scales[0], (int32_t)q.zeroPoints[0]};
+	return true;
+}
+
+// binds the integer kernel when the operator computes an int8/uint8 tensor from tensors of the same type,
+// returns false when the operator should be computed by its float kernel
+static bool bindQuantizedKernel(const PI::Model *model, OperatorPlan &op) {
+	auto type = model->getTensorType(op.outputs[0]);
+	if (type != PI::DataType_Int8 && type != PI::DataType_UInt8)
+		return false;
+	bool isInt8 = type == PI::DataType_Int8;
+	std::shared_ptr<QuantizedOperator> q(new QuantizedOperator);
+	q->type = type;
+	if (!getTensorQuantization(model, op.outputs[0], q->output))
+		return false;
+
+	// computed inputs
+	unsigned numInputs = op.kind == PI::KindAdd ? 2 : op.kind == PI::KindQuantize ? 0 : 1;
+	for (unsigned i = 0; i < numInputs; i++) {
+		Kernels::Quantized::Quantization quantization;
+		if (op.inputStaticData[i] || model->getTensorType(op.inputs[i]) != type || !getTensorQuantization(model, op.inputs[i], quantization))
+			return false;
+		q->inputs.push_back(quantization);
+	}
+
+	// the output range narrowed by the activation function
+	float min = -std::numeric_limits<float>::infinity(), max = std::numeric_limits<float>::infinity();
+	switch (op.params.activationFunction) {
+	case PI::ActivationFunction_NONE:
+		break;
+	case PI::ActivationFunction_RELU:
+		min = 0;
+		break;
+	case PI::ActivationFunction_RELU_N1_TO_1:
+		min = -1;
+		max = 1;
+		break;
+	case PI::ActivationFunction_RELU6:
+		min = 0;
+		max = 6;
+		break;
+	default:
+		return false; // not a clamp
+	}
+	(isInt8 ? Kernels::Quantized::activationRange<int8_t> : Kernels::Quantized::activationRange<uint8_t>)(
+		q->output, min, max, q->requantization.min, q->requantization.max);
+	q->requantization.zeroPoint = q->output.zeroPoint;
+
+	switch (op.kind) {
+	case PI::KindConv2D:
+	case PI::KindDepthwiseConv2D:
+	case PI::KindFullyConnected: {
+		// filters are static, with one scale or with a scale per output channel, and with one zero point
+		PI::TensorQuantization filterQuantization;
+		if (!op.inputStaticData[1] || model->getTensorType(op.inputs[1]) != type || !model->getTensorQuantization(op.inputs[1], filterQuantization))
+			return false;
+		unsigned channelDim = op.kind == PI::KindDepthwiseConv2D ? 3 : 0;
+		auto &scales = filterQuantization.scales;
+		auto &zeroPoints = filterQuantization.zeroPoints;
+		if (scales.size() != 1 && (scales.size() != op.inputShapes[1][channelDim] || filterQuantization.quantizedDimension != channelDim))
+			return false;
+		if (std::any_of(zeroPoints.begin(), zeroPoints.end(), [&zeroPoints](int64_t zeroPoint) {return zeroPoint != zeroPoints[0];}))
+			return false;
+		q->filterZeroPoint = zeroPoints[0];
+		q->filter.reset(new int16_t[Tensor::flatSize(op.inputShapes[1])]);
+		offsetFilter(op, *q);
+
+		// biases are static int32 values with the scale inputScale*filterScale
+		bool hasBias = op.inputShapes.size() > 2 && (op.kind != PI::KindFullyConnected || op.inputShapes[2].size() == 1);
+		if (hasBias && (!op.inputStaticData[2] || model->getTensorType(op.inputs[2]) != PI::DataType_Int32))
+			return false;
+
+		for (auto scale : scales)
+			q->requantization.multipliers.push_back(Kernels::Quantized::Multiplier((double)q->inputs[0].scale*scale/q->output.scale));
+		if (op.kind == PI::KindFullyConnected)
+			op.exec = isInt8 ? runQuantizedFullyConnected<int8_t> : runQuantizedFullyConnected<uint8_t>;
+		else
+			op.exec = isInt8 ? runQuantizedConv2D<int8_t> : runQuantizedConv2D<uint8_t>;
+		break;
+	} case PI::KindAdd: {
+		// one of the inputs can be a single value
+		auto size = Tensor::flatSize(op.outputShapes[0]);
+		auto size1 = Tensor::flatSize(op.inputShapes[0]), size2 = Tensor::flatSize(op.inputShapes[1]);
+		if (!(size1 == size && (size2 == size || size2 == 1)) && !(size2 == size && size1 == 1))
+			return false;
+		op.exec = isInt8 ? runQuantizedAdd<int8_t> : runQuantizedAdd<uint8_t>;
+		break;
+	} case PI::KindMaxPool:
+	  case PI::KindAveragePool:
+		// pools keep the quantization
+		if (q->inputs[0].scale != q->output.scale || q->inputs[0].zeroPoint != q->output.zeroPoint)
+			return false;
+		op.exec = isInt8 ? runQuantizedPool<int8_t> : runQuantizedPool<uint8_t>;
+		break;
+	case PI::KindSoftmax:
+		op.exec = isInt8 ? runQuantizedSoftmax<int8_t> : runQuantizedSoftmax<uint8_t>;
+		break;
+	case PI::KindQuantize:
+		if (op.inputStaticData[0] && model->getTensorType(op.inputs[0]) != PI::DataType_Float32)
+			return false;
+		op.exec = isInt8 ? runQuantize<int8_t> : runQuantize<uint8_t>;
+		break;
+	default:
+		return false;
+	}
+
+	op.quantized = q;
+	return true;
+}
+
+// real values of a static quantized tensor, with one scale or with a scale per slice along the quantized dimension
+template<typename T>
+static void dequantizeStatic(const T *data, const TensorShape &shape, const PI::TensorQuantization &quantization, float *output) {
+	size_t inner = 1; // elements in one slice along the quantized dimension
+	for (auto d = quantization.quantizedDimension + 1; d < shape.size(); d++)
+		inner *= shape[d];
+	for (size_t i = 0, ie = Tensor::flatSize(shape); i < ie; i++) {
+		auto s = quantization.scales.size() == 1 ? 0 : (i/inner)%shape[quantization.quantizedDimension];
+		output[i] = quantization.scales[s]*(float)((int64_t)data[i] - quantization.zeroPoints[s]);
+	}
+}
+
+// float32 values of a static float16 or quantized tensor
+static void dequantizeStaticTensor(const PI::Model *model, PI::TensorId tid, float *output) {
+	auto type = model->getTensorType(tid);
+	auto shape = model->getTensorShape(tid);
+	auto input = model->getTensorData(tid);
+	PI::TensorQuantization quantization;
+	switch (model->getTensorQuantization(tid, quantization) ? type : PI::DataType_Float16) {
+	case PI::DataType_Float16:
+		for (size_t e = 0, ee = Tensor::flatSize(shape); e < ee; e++)
+			output[e] = static_cast<const half_float::half*>(input)[e];
+		break;
+	case PI::DataType_Int8:
+		dequantizeStatic(static_cast<const int8_t*>(input), shape, quantization, output);
+		break;
+	case PI::DataType_UInt8:
+		dequantizeStatic(static_cast<const uint8_t*>(input), shape, quantization, output);
+		break;
+	case PI::DataType_Int16:
+		dequantizeStatic(static_cast<const int16_t*>(input), shape, quantization, output);
+		break;
+	case PI::DataType_Int32:
+		dequantizeStatic(static_cast<const int32_t*>(input), shape, quantization, output);
+		break;
+	case PI::DataType_Int64:
+		dequantizeStatic(static_cast<const int64_t*>(input), shape, quantization, output);
+		break;
+	default:
+		FAIL("can't dequantize the tensor #" << tid << " of the type " << type)
+	}
+}
+
+// float kernels take float32 static inputs: quantized and float16 ones are expanded once, and shared by operators,
+// except float16 filters of Conv2D and FullyConnected, which are widened by their kernels: packed once, or as they are streamed
+static void dequantizeStaticInputs(const PI::Model *model, Plan &plan, OperatorPlan &op) {
+	for (unsigned i = 0; i < op.inputs.size(); i++) {
+		auto tid = op.inputs[i];
+		auto type = model->getTensorType(tid);
+		PI::TensorQuantization quantization;
+		if (!op.inputStaticData[i] || type == PI::DataType_Float32)
+			continue;
+		bool quantized = model->getTensorQuantization(tid, quantization);
+		if (!quantized && type != PI::DataType_Float16)
+			continue; // integer values like shapes and indexes
+		if (!quantized && i == 1 && (op.kind == PI::KindConv2D || op.kind == PI::KindFullyConnected)) {
+			op.float16Filter = true; // the largest weights stay float16 in the model
+			continue;
+		}
+		auto &data = plan.dequantizedTensors[tid];
+		if (!data) {
+			data.reset(new float[Tensor::flatSize(model->getTensorShape(tid))]);
+			dequantizeStaticTensor(model, tid, data.get());
+		}
+		op.inputStaticData[i] = data.get();
+	}
+}
+
+// static float32 data by tensor: model views produce it on demand, and can evict it when nobody holds it
+static void requestStaticData(const Plan &plan, std::vector<std::shared_ptr<const float>> &staticData) {
+	staticData.resize(plan.numTensors);
+	ThreadPool::parallelFor(plan.staticTensors.size(), 1, [&](size_t begin, size_t end) { // evicted data is converted again, in parallel
+		for (auto i = begin; i < end; i++)
+			staticData[plan.staticTensors[i]] = plan.model->getTensorDataF32Shared(plan.staticTensors[i]);
+	});
+}
+
 //
 // exported functions
 //
@@ -122,14 +1119,11 @@ bool buildComputeInputs(
 
 		/// resize the source image
 
+		unsigned batchSize = 1; // models with B>1 get the image in every sample
 		{
 			// adjust the required shape to the form [H,W,C]
 			if (requiredShape.size() == 4) { // assume [B,H,W,C]
-				if (requiredShape[0] != 1) {
-					cbWarningMessage(STR("Model's required shape " << requiredShape << " has 4 elements but doesn't begin with B=1,"
-					                     " don't know how to adjust the image for it"));
-					return false;
-				}
+				batchSize = requiredShape[0];
 				requiredShape = Tensor::getLastDims(requiredShape, 3);
 			} else if (requiredShape.size() == 3) {
 				if (requiredShape[0] == 1) { // assume [B=1,H,W], remove B and add C=1 for monochrome image
@@ -244,6 +1238,16 @@ bool buildComputeInputs(
 			}
 		}
 
+		/// replicate the image into all samples
+
+		if (batchSize > 1) {
+			auto sampleSize = Tensor::flatSize(requiredShape);
+			auto batch = new float[batchSize*sampleSize];
+			for (unsigned b = 0; b < batchSize; b++)
+				std::memcpy(batch + b*sampleSize, inputImage.get(), sampleSize*sizeof(float));
+			inputImage.reset(batch);
+		}
+
 		return true;
 	};
 	auto convertInputFromJsonFile = [](PI::TensorId tensorId, const TensorShape &requiredShape, std::shared_ptr<const float> &inputTensor) {
@@ -283,6 +1287,30 @@ bool buildComputeInputs(
 	return true;
 }
 
+void stackInputs(
+	const Plan &plan,
+	const std::vector<std::map<PI::TensorId, std::shared_ptr<const float>>> &samples,
+	std::map<PI::TensorId, std::shared_ptr<const float>> &inputs)
+{
+	assert(samples.size() == plan.batchSize);
+
+	for (auto &sampleInput : samples[0]) {
+		auto tid = sampleInput.first;
+		if (!plan.batchedTensors[tid]) {
+			inputs[tid] = sampleInput.second; // the same for all samples
+			continue;
+		}
+		auto sampleSize = Tensor::flatSize(plan.tensorShapes[tid])/plan.batchSize;
+		auto stacked = new float[sampleSize*plan.batchSize];
+		inputs[tid].reset(stacked, [](const float *p) {delete [] p;});
+		for (auto &sample : samples) {
+			assert(sample.find(tid) != sample.end());
+			std::memcpy(stacked, sample.find(tid)->second.get(), sampleSize*sizeof(float));
+			stacked += sampleSize;
+		}
+	}
+}
+
 void fillInputs(
 	std::map<PI::TensorId, std::shared_ptr<const float>> &inputs,
 	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData)
@@ -292,1107 +1320,1162 @@ void fillInputs(
 		
 }
 
-bool compute(
-	const PI::Model *model,
-	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
-	std::function<void(PI::TensorId)> cbTensorComputed,
-	std::function<void(const std::string&)> cbWarningMessage)
-{
-	/// compute operators
 
-	for (PI::OperatorId oid = 0, oide = (PI::OperatorId)model->numOperators(); oid<oide; oid++) {
-		// get operator's inputs/outputs
-		std::vector<PI::TensorId> inputs, outputs;
-		model->getOperatorIo(oid, inputs, outputs);
+static size_t sizeOfElement(PI::DataType type) {
+	switch (type) {
+	case PI::DataType_Float16:
+	case PI::DataType_Int16:
+		return 2;
+	case PI::DataType_Float32:
+	case PI::DataType_Int32:
+		return 4;
+	case PI::DataType_Float64:
+	case PI::DataType_Int64:
+		return 8;
+	case PI::DataType_Int8:
+	case PI::DataType_UInt8:
+		return 1;
+	}
+	return 4;
+}
 
-		// get operator options from the model
-		std::unique_ptr<PI::OperatorOptionsList> opts(model->getOperatorOptions(oid));
+// computed tensors are float32 for float kernels and int8/uint8 for integer kernels, static ones keep the type of the model
+// unless they were expanded to float32 for float kernels
+static size_t operatorBytesTouched(const PI::Model *model, const Plan &plan, const OperatorPlan &op) {
+	size_t computedElement = op.quantized ? 1 : sizeof(float);
+	size_t bytes = 0;
+	for (unsigned i = 0; i < op.inputs.size(); i++) {
+		auto size = Tensor::flatSize(op.inputShapes[i]);
+		bool expanded = plan.dequantizedTensors.find(op.inputs[i]) != plan.dequantizedTensors.end();
+		bytes += size*(!op.inputStaticData[i] ? computedElement : expanded ? sizeof(float) : sizeOfElement(model->getTensorType(op.inputs[i])));
+	}
+	for (auto &shape : op.outputShapes)
+		bytes += Tensor::flatSize(shape)*computedElement;
+	return bytes;
+}
 
-		// helpers
-		auto getTensorDataDynamicOrStatic = [model,&tensorData](PI::TensorId tensorId) -> const float* {
-			auto &dynamic = (*tensorData)[tensorId];
-			assert(dynamic || model->getTensorHasData(tensorId)); // at least one of dynamic and static should be available
-			assert(!(dynamic && model->getTensorHasData(tensorId))); // both dynamic and static can't be available
-			return dynamic ? dynamic.get() : model->getTensorDataF32(tensorId);
-		};
-		auto translatePadding = [](unsigned stride, unsigned dilationRate,
-		                           WidthHeight wh, const TensorShape &inputShape, const TensorShape &filterShape, const TensorShape &outputShape) {
-			//return filterShape[wh==WIDTH ? 2:1]/2;
-			unsigned shapeIdx = wh==WIDTH ? 2:1;
-			return std::get<0>(computePaddingValues(stride, dilationRate, inputShape[shapeIdx], filterShape[shapeIdx], outputShape[shapeIdx]));
-		};
-		auto computeSingleOperator = [&](float(*fn)(float f)) {
-			assert(inputs.size()==1 && outputs.size()==1);
-			assert(!opts || opts->empty()); // h-swish has no options
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			// tensors
-			auto inputShape = model->getTensorShape(inputs[0]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto inputShapeSize = Tensor::flatSize(inputShape);
-			assert(inputShape==outputShape);
-			UNUSED(outputShape)
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[inputShapeSize]);
-
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			auto output = outputData.get();
-			for (auto inpute = input+inputShapeSize; input<inpute; input++, output++)
-				*output = fn(*input);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-		};
-		auto computeDualOperator = [](
-			const float *input1, const TensorShape &input1Shape,
-			const float *input2, const TensorShape &input2Shape,
-			float *output, const TensorShape &outputShape,
-			float(*fn)(float i1, float i2)
-		) {
-			// by type of inputs
-			if (input1Shape==input2Shape) { // Large vs. Large
-				const float *input1e = input1+Tensor::flatSize(input1Shape);
-				// input2 can only be dynamic here
-				for (; input1<input1e; )
-					*output++ = fn(*input1++, *input2++);
-				return true;
-			} else if (input1Shape.size()==0 || (input1Shape.size()==1 && input1Shape[0]==1)) { //  Const vs. Large
-				auto input2ShapeSize = Tensor::flatSize(input2Shape);
-				const float *input2e = input2+input2ShapeSize;
-				auto Const = input1[0];
-				for (; input2<input2e; )
-					*output++ = fn(Const,*input2++);
-				return true;
-			} else if (input2Shape.size()==01 || (input2Shape.size()==1 && input2Shape[0]==1)) { // Large vs. Const
-				const float *input1e = input1+Tensor::flatSize(input1Shape);
-				auto Const = input2[0];
-				for (; input1<input1e; )
-					*output++ = fn(*input1++, Const);
-				return true;
-			} else if (Tensor::isSubset(input1Shape, input2Shape)) { // Large vs. Small
-				auto input1e = input1+Tensor::flatSize(input1Shape);
-				auto input2b = input2;
-				auto input2e = input2+Tensor::flatSize(input2Shape);
-				for (; input1<input1e; input1++, output++) {
-					*output = fn(*input1, *input2);
-					if (++input2 >= input2e)
-						input2 = input2b;
-				}
-				return true;
-			} else {
-				return false;
-			}
-		};
-		auto applyActivationFunction = [](size_t size, float *data, PI::ActivationFunction activationFunction) {
-			auto applyRELU = [](float &val) {
-				if (val < 0)
-					val = 0;
-			};
-			auto applyRELU_N1_TO_1 = [](float &val) {
-				if (val < -1)
-					val = -1;
-				else if (val > 1)
-					val = 1;
-			};
-			auto applyRELU6 = [](float &val) {
-				if (val < 0)
-					val = 0;
-				else if (val > 6)
-					val = 6;
-			};
-			auto applyTANH = [](float &val) {
-				val = std::tanh(val);
-			};
-			auto applySIGN_BIT = [](float &val) {
-				val = std::signbit(val) ? 1 : 0;
-			};
-			switch (activationFunction) {
-			case PI::ActivationFunction_RELU:
-				for (auto e = data+size; data<e; data++)
-					applyRELU(*data);
-				return;
-			case PI::ActivationFunction_RELU_N1_TO_1:
-				for (auto e = data+size; data<e; data++)
-					applyRELU_N1_TO_1(*data);
-				return;
-			case PI::ActivationFunction_RELU6:
-				for (auto e = data+size; data<e; data++)
-					applyRELU6(*data);
-				return;
-			case PI::ActivationFunction_TANH:
-				for (auto e = data+size; data<e; data++)
-					applyTANH(*data);
-				return;
-			case PI::ActivationFunction_SIGN_BIT:
-				for (auto e = data+size; data<e; data++)
-					applySIGN_BIT(*data);
-				return;
-			case PI::ActivationFunction_NONE:
-				return;
-			}
-		};
-		auto doArgMxx = [&](float v0, std::function<bool(float,float)> cmp) {
-			assert(inputs.size()==1);
-			assert(outputs.size()==1);
-			assert(opts); // need to have options present // TODO check the output_type operator option
+// Concatenation can be computed in place when every input is only computed to be concatenated: producers write
+// into their parts of the output. Along the last dimension parts are strided, only Conv2D can write them.
+static bool canConcatenateInPlace(const Plan &plan, const OperatorPlan &op, const std::vector<int> &tensorProducers, const std::vector<PI::TensorId> &modelOutputs) {
+	if (op.params.activationFunction != PI::ActivationFunction_NONE)
+		return false;
 
-			auto inputShape = model->getTensorShape(inputs[0]);
-			assert(Tensor::flatSize(model->getTensorShape(outputs[0])) == 1);
+	auto &outputShape = op.outputShapes[0];
+	unsigned axis = op.params.axis < 0 ? op.params.axis + (int)outputShape.size() : op.params.axis;
+	bool strided = Tensor::sizeBetweenDims(outputShape, 0, (int)axis - 1) > 1;
+	if (strided && axis != outputShape.size() - 1)
+		return false;
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[1]); // always return one number
+	for (auto tid : op.inputs) {
+		if (tensorProducers[tid] == -1 || plan.tensorConsumers[tid].size() != 1 ||
+		    std::count(op.inputs.begin(), op.inputs.end(), tid) != 1 ||
+		    std::find(modelOutputs.begin(), modelOutputs.end(), tid) != modelOutputs.end())
+			return false;
+		auto &producer = plan.operators[tensorProducers[tid]];
+		if (producer.outputs.size() != 1 || producer.exec == runNotBatchable)
+			return false;
+		if (strided ? (producer.kind != PI::KindConv2D || producer.quantized) : (producer.kind == PI::KindReshape || producer.kind == PI::KindConcatenation || !producer.viewOutputs.empty()))
+			return false;
+	}
+
+	return true;
+}
 
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			int idx = -1;
-			for (unsigned i = 0, ie = Tensor::flatSize(inputShape); i < ie; i++) {
-				auto v = *input++;
-				if (cmp(v, v0)) {
-					idx = i;
-					v0 = v;
+Plan* compile(const PI::Model *model, bool keepAllIntermediates, unsigned batchSize, bool integerKernels, const std::vector<PI::TensorId> *retainedTensors) { // returns ownership
+	assert(batchSize >= 1);
+	assert(!(keepAllIntermediates && retainedTensors)); // nothing to retain when everything is kept
+	std::unique_ptr<Plan> plan(new Plan);
+	plan->model = model;
+	plan->numTensors = model->numTensors();
+	plan->numQuantizedOperators = 0;
+
+	// shapes: model inputs and tensors computed from them are batched when they begin with B=1
+	plan->batchSize = batchSize;
+	plan->batchedTensors.resize(plan->numTensors, false);
+	for (PI::TensorId tid = 0; tid < plan->numTensors; tid++)
+		plan->tensorShapes.push_back(model->getTensorShape(tid));
+	auto batchTensor = [&plan](PI::TensorId tid) {
+		auto &shape = plan->tensorShapes[tid];
+		if (plan->batchSize > 1 && !shape.empty() && shape[0] == 1) {
+			shape[0] = plan->batchSize;
+			plan->batchedTensors[tid] = true;
+		}
+	};
+	for (auto tid : model->getInputs())
+		batchTensor(tid);
+
+	// static float32 data: model views can produce it on demand (dequantized weights), compiling holds it like runs do
+	{
+		std::vector<bool> seen(plan->numTensors, false);
+		for (PI::OperatorId oid = 0, oide = (PI::OperatorId)model->numOperators(); oid<oide; oid++) {
+			std::vector<PI::TensorId> inputs, outputs;
+			model->getOperatorIo(oid, inputs, outputs);
+			for (auto tid : inputs)
+				if (!seen[tid] && model->getTensorHasData(tid) && model->getTensorType(tid)==PI::DataType_Float32) {
+					seen[tid] = true;
+					plan->staticTensors.push_back(tid);
 				}
-			}
-			outputData.get()[0] = idx;
+		}
+	}
+	std::vector<std::shared_ptr<const float>> staticData;
+	requestStaticData(*plan, staticData);
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+	for (PI::OperatorId oid = 0, oide = (PI::OperatorId)model->numOperators(); oid<oide; oid++) {
+		plan->operators.push_back(OperatorPlan{});
+		auto &op = *plan->operators.rbegin();
+		auto &p = op.params;
+		op.oid = oid;
+		op.kind = model->getOperatorKind(oid);
+
+		// get operator's inputs/outputs, their shapes and static data
+		model->getOperatorIo(oid, op.inputs, op.outputs);
+		bool batched = std::any_of(op.inputs.begin(), op.inputs.end(), [&plan](PI::TensorId tid) {return plan->batchedTensors[tid];});
+		if (batched)
+			for (auto tid : op.outputs)
+				batchTensor(tid);
+		for (auto tid : op.inputs) {
+			op.inputShapes.push_back(plan->tensorShapes[tid]);
+			op.inputStaticData.push_back(
+				!model->getTensorHasData(tid) ? nullptr :
+				model->getTensorType(tid)==PI::DataType_Float32 ? (const void*)staticData[tid].get() : model->getTensorData(tid));
+		}
+		for (auto tid : op.outputs)
+			op.outputShapes.push_back(plan->tensorShapes[tid]);
+		auto &inputs = op.inputs;
+		auto &outputs = op.outputs;
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-		};
+		// get operator options from the model
+		std::unique_ptr<PI::OperatorOptionsList> opts(model->getOperatorOptions(oid));
 
-		// by operator kind
-		auto operatorKind = model->getOperatorKind(oid);
-		switch (operatorKind) {
-		case PI::KindConv2D: {
+		// parse options and bind the kernel, by operator kind
+		switch (op.kind) {
+		case PI::KindConv2D:
+		case PI::KindDepthwiseConv2D: {
 			assert(inputs.size()==3 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
 
-			// operator options required to run this operator
-			int strideWidth=0, strideHeight=0;
-			int dilationWidth=0, dilationHeight=0;
+			// parse the operator options supplied by the model
 			PI::PaddingType paddingType;
-			PI::ActivationFunction activationFunction = PI::ActivationFunction_NONE;
-
-			// parse the operator options supplied by the model into the above variables
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_W,            PI::OperatorOption_TypeInt,int>(*opts, &strideWidth)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_H,          PI::OperatorOption_TypeInt,int>(*opts, &strideHeight)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_DILATION_W_FACTOR, PI::OperatorOption_TypeInt,int>(*opts, &dilationWidth)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_DILATION_H_FACTOR, PI::OperatorOption_TypeInt,int>(*opts, &dilationHeight)
+				OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_W,            PI::OperatorOption_TypeInt,int>(*opts, &p.strideWidth)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_H,          PI::OperatorOption_TypeInt,int>(*opts, &p.strideHeight)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_DILATION_W_FACTOR, PI::OperatorOption_TypeInt,int>(*opts, &p.dilationWidth)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_DILATION_H_FACTOR, PI::OperatorOption_TypeInt,int>(*opts, &p.dilationHeight)
 				+ OperatorOptions::GetOption1<PI::OperatorOption_PADDING, PI::OperatorOption_TypePaddingType,PI::PaddingType>(*opts, &paddingType)
 				+ OperatorOptions::GetOption1<PI::OperatorOption_FUSED_ACTIVATION_FUNCTION,
-					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &activationFunction);
-			assert(numParsed==6); // need to have 6 options
+					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &p.activationFunction);
+			if (op.kind == PI::KindDepthwiseConv2D)
+				numParsed += OperatorOptions::GetOption1<PI::OperatorOption_DEPTH_MULTIPLIER, PI::OperatorOption_TypeInt,int>(*opts, &p.depthMultiplier);
+			assert(numParsed==(op.kind==PI::KindConv2D ? 6 : 7)); // need to have 6 or 7 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
-			PRINT_OPTS("KindConv2D: have " << opts->size() << " options:"
-			           " strideWidth=" << strideWidth <<
-			           " strideHeight=" << strideHeight <<
-			           " dilationWidth=" << dilationWidth <<
-			           " strideHeight=" << strideHeight <<
+			PRINT_OPTS(op.kind << ": have " << opts->size() << " options:"
+			           " depthMultiplier=" << p.depthMultiplier <<
+			           " strideWidth=" << p.strideWidth <<
+			           " strideHeight=" << p.strideHeight <<
+			           " dilationWidth=" << p.dilationWidth <<
+			           " dilationHeight=" << p.dilationHeight <<
 			           " paddingType=" << paddingType <<
-			           " activationFunction=" << activationFunction
+			           " activationFunction=" << p.activationFunction
 			)
 
-			// tensors
-			auto inputShape  = model->getTensorShape(inputs[0]);
-			auto filterShape = model->getTensorShape(inputs[1]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto outputShapeSize = Tensor::flatSize(outputShape);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[outputShapeSize]);
-
-			// compute
-			NnOperators::Conv2D(
-				inputShape, (*tensorData)[inputs[0]].get(), // input
-				filterShape, model->getTensorDataF32(inputs[1]), // filter - assume that it is always a static tensor
-				model->getTensorShape(inputs[2]), model->getTensorDataF32(inputs[2]), // bias - assume that it is always a static tensor
-				outputShape, outputData.get(), // output
-				translatePadding(strideWidth,  dilationWidth,  WIDTH,  inputShape, filterShape, outputShape),
-				translatePadding(strideHeight, dilationHeight, HEIGHT, inputShape, filterShape, outputShape),
-				strideWidth, strideHeight,
-				dilationWidth, dilationHeight
-			);
+			// padding values
+			auto &inputShape = op.inputShapes[0], &filterShape = op.inputShapes[1], &outputShape = op.outputShapes[0];
+			p.paddingWidth  = translatePadding(p.strideWidth,  p.dilationWidth,  WIDTH,  inputShape, filterShape, outputShape);
+			p.paddingHeight = translatePadding(p.strideHeight, p.dilationHeight, HEIGHT, inputShape, filterShape, outputShape);
 
-			// activation function
-			applyActivationFunction(outputShapeSize, outputData.get(), activationFunction);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
-			break;
-		} case PI::KindDepthwiseConv2D: {
-			assert(inputs.size()==3 && outputs.size()==1);
-			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			// operator options required to run this operator
-			int depthMultiplier=0;
-			int strideWidth=0, strideHeight=0;
-			int dilationWidth=0, dilationHeight=0;
-			PI::PaddingType paddingType;
-			PI::ActivationFunction activationFunction = PI::ActivationFunction_NONE;
-
-			// parse the operator options supplied by the model into the above variables
-			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_DEPTH_MULTIPLIER,    PI::OperatorOption_TypeInt,int>(*opts, &depthMultiplier)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_W,          PI::OperatorOption_TypeInt,int>(*opts, &strideWidth)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_H,          PI::OperatorOption_TypeInt,int>(*opts, &strideHeight)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_DILATION_W_FACTOR, PI::OperatorOption_TypeInt,int>(*opts, &dilationWidth)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_DILATION_H_FACTOR, PI::OperatorOption_TypeInt,int>(*opts, &dilationHeight)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_PADDING, PI::OperatorOption_TypePaddingType,PI::PaddingType>(*opts, &paddingType)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_FUSED_ACTIVATION_FUNCTION,
-					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &activationFunction);
-			assert(numParsed==7); // need to have 7 options
-			assert(numParsed==opts->size()); // all options are parsed
-			UNUSED(numParsed)
-
-			PRINT_OPTS("KindDepthwiseConv2D: have " << opts->size() << " options:"
-			           " depthMultiplier=" << depthMultiplier <<
-			           " strideWidth=" << strideWidth <<
-			           " strideHeight=" << strideHeight <<
-			           " dilationWidth=" << dilationWidth <<
-			           " strideHeight=" << strideHeight <<
-			           " paddingType=" << paddingType <<
-			           " activationFunction=" << activationFunction
-			)
-
-			// tensors
-			auto inputShape  = model->getTensorShape(inputs[0]);
-			auto filterShape = model->getTensorShape(inputs[1]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto outputShapeSize = Tensor::flatSize(outputShape);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[outputShapeSize]);
-
-			// compute
-			NnOperators::DepthwiseConv2D(
-				inputShape, (*tensorData)[inputs[0]].get(), // input
-				filterShape, model->getTensorDataF32(inputs[1]), // filter
-				model->getTensorShape(inputs[2]), model->getTensorDataF32(inputs[2]), // bias
-				outputShape, outputData.get(), // output
-				translatePadding(strideWidth,  dilationWidth,  WIDTH,  inputShape, filterShape, outputShape),
-				translatePadding(strideHeight, dilationHeight, HEIGHT, inputShape, filterShape, outputShape),
-				strideWidth, strideHeight,
-				dilationWidth, dilationHeight,
-				depthMultiplier
-			);
-
-			// activation function
-			applyActivationFunction(outputShapeSize, outputData.get(), activationFunction);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			// Winograd convolution for 3x3 stride-1 layers with static float weights
+			if (op.kind==PI::KindConv2D && op.inputStaticData[1] &&
+			    (model->getTensorType(inputs[1])==PI::DataType_Float32 || model->getTensorType(inputs[1])==PI::DataType_Float16) &&
+			    Kernels::Winograd::applicable(filterShape, p.strideWidth, p.strideHeight, p.dilationWidth, p.dilationHeight))
+				op.winogradTileSize = Kernels::Winograd::chooseTileSize(outputShape);
 
+			op.exec = op.kind==PI::KindConv2D ? runConv2D : runDepthwiseConv2D;
 			break;
 		} case PI::KindPad: {
-			// tensors
-			auto inputDataShape = model->getTensorShape(inputs[0]);
-			auto inputPaddingsShape = model->getTensorShape(inputs[1]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-
 			// check that shapes are consistent
+			auto &inputDataShape = op.inputShapes[0], &inputPaddingsShape = op.inputShapes[1];
 			assert(inputDataShape.size() <= 4); // TfLite has max=4 hardcoded in PadParams
 			assert(inputPaddingsShape.size()==2 && inputPaddingsShape[0]==inputDataShape.size() && inputPaddingsShape[1]==2);
-
-			// inputs
 			assert(model->getTensorType(inputs[1]) == PI::DataType_Int32);
-			auto paddings = static_cast<const std::array<int32_t,2>*>(model->getTensorData(inputs[1]));
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[Tensor::flatSize(outputShape)]);
-
-			// compute
-			NnOperators::Pad(
-				paddings,
-				inputDataShape, (*tensorData)[inputs[0]].get(), // input
-				outputShape, outputData.get() // output
-			);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			UNUSED(inputDataShape)
+			UNUSED(inputPaddingsShape)
 
+			op.exec = runPad;
 			break;
 		} case PI::KindFullyConnected: {
 			assert(inputs.size()==3 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
 
-			// operator options required to run this operator
-			bool keepNumDims = false;
-			int  weightsFormat = 0;
-			PI::ActivationFunction activationFunction = PI::ActivationFunction_NONE;
-
-			// parse the operator options supplied by the model into the above variables
+			// parse the operator options supplied by the model
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_KEEP_NUM_DIMS,    PI::OperatorOption_TypeBool,bool>(*opts, &keepNumDims)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_WEIGHTS_FORMAT, PI::OperatorOption_TypeInt, int> (*opts, &weightsFormat)
+				OperatorOptions::GetOption1<PI::OperatorOption_KEEP_NUM_DIMS,    PI::OperatorOption_TypeBool,bool>(*opts, &p.keepNumDims)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_WEIGHTS_FORMAT, PI::OperatorOption_TypeInt, int> (*opts, &p.weightsFormat)
 				+ OperatorOptions::GetOption1<PI::OperatorOption_FUSED_ACTIVATION_FUNCTION,
-					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &activationFunction);
+					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &p.activationFunction);
 			assert(numParsed==3); // need to have 3 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
-			if (weightsFormat != 0) {
-				cbWarningMessage(STR("Computation didn't succeed: operator #" << (oid+1) << ": " << operatorKind << " option weights_format isn't zero"));
-				return false; // failed to compute the model to the end
-			}
-
 			PRINT_OPTS("FullyConnected: have " << opts->size() << " options:"
-			           " keepNumDims=" << keepNumDims <<
-			           " weightsFormat=" << weightsFormat <<
-			           " activationFunction=" << activationFunction
+			           " keepNumDims=" << p.keepNumDims <<
+			           " weightsFormat=" << p.weightsFormat <<
+			           " activationFunction=" << p.activationFunction
 			)
 
-			// tensors
-			auto inputShape  = model->getTensorShape(inputs[0]);
-			auto filterShape = model->getTensorShape(inputs[1]);
-			auto biasShape   = model->getTensorShape(inputs[2]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto outputShapeSize = Tensor::flatSize(outputShape);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[outputShapeSize]);
-
-			// compute
-			NnOperators::FullyConnected(
-				inputShape, (*tensorData)[inputs[0]].get(), // input
-				filterShape, model->getTensorDataF32(inputs[1]), // filter
-				biasShape, biasShape.size()==1 ? model->getTensorDataF32(inputs[2]) : nullptr, // bias
-				outputShape, outputData.get() // output
-			);
-
-			// activation function
-			applyActivationFunction(outputShapeSize, outputData.get(), activationFunction);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
+			op.exec = runFullyConnected;
 			break;
 		} case PI::KindLocalResponseNormalization: {
 			assert(inputs.size()==1 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
 
-			// operator options required to run this operator
-			int radius = 0;
-			float alpha = 0, beta = 0, bias = 0;
-
-			// parse the operator options supplied by the model into the above variables
+			// parse the operator options supplied by the model
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_RADIUS,    PI::OperatorOption_TypeInt,int>(*opts, &radius)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_ALPHA,   PI::OperatorOption_TypeFloat,float> (*opts, &alpha)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_BETA,    PI::OperatorOption_TypeFloat,float> (*opts, &beta)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_BIAS,    PI::OperatorOption_TypeFloat,float> (*opts, &bias);
+				OperatorOptions::GetOption1<PI::OperatorOption_RADIUS,    PI::OperatorOption_TypeInt,int>(*opts, &p.radius)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_ALPHA,   PI::OperatorOption_TypeFloat,float> (*opts, &p.alpha)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_BETA,    PI::OperatorOption_TypeFloat,float> (*opts, &p.beta)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_BIAS,    PI::OperatorOption_TypeFloat,float> (*opts, &p.bias);
 			assert(numParsed==4); // need to have 4 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
 			PRINT_OPTS("LocalResponseNormalization: have " << opts->size() << " options:"
-			           " radius=" << radius <<
-			           " alpha=" << alpha <<
-			           " beta=" << beta <<
-			           " bias=" << bias
+			           " radius=" << p.radius <<
+			           " alpha=" << p.alpha <<
+			           " beta=" << p.beta <<
+			           " bias=" << p.bias
 			)
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[Tensor::flatSize(model->getTensorShape(outputs[0]))]);
-
-			// compute
-			NnOperators::LocalResponseNormalization(
-				model->getTensorShape(inputs[0]), (*tensorData)[inputs[0]].get(), // input
-				model->getTensorShape(outputs[0]), outputData.get(), // output
-				radius, alpha, beta, bias
-			);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
+			op.exec = runLocalResponseNormalization;
 			break;
 		} case PI::KindMaxPool:
 		  case PI::KindAveragePool: {
 			assert(inputs.size()==1 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
 
-			// operator options required to run this operator
-			int strideWidth=0, strideHeight=0;
-			int filterWidth=0, filterHeight=0;
+			// parse the operator options supplied by the model
 			PI::PaddingType paddingType;
-			PI::ActivationFunction activationFunction = PI::ActivationFunction_NONE;
-
-			// parse the operator options supplied by the model into the above variables
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_W,            PI::OperatorOption_TypeInt,int>(*opts, &strideWidth)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_H,          PI::OperatorOption_TypeInt,int>(*opts, &strideHeight)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_FILTER_WIDTH,      PI::OperatorOption_TypeInt,int>(*opts, &filterWidth)
-				+ OperatorOptions::GetOption1<PI::OperatorOption_FILTER_HEIGHT,     PI::OperatorOption_TypeInt,int>(*opts, &filterHeight)
+				OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_W,            PI::OperatorOption_TypeInt,int>(*opts, &p.strideWidth)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_STRIDE_H,          PI::OperatorOption_TypeInt,int>(*opts, &p.strideHeight)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_FILTER_WIDTH,      PI::OperatorOption_TypeInt,int>(*opts, &p.filterWidth)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_FILTER_HEIGHT,     PI::OperatorOption_TypeInt,int>(*opts, &p.filterHeight)
 				+ OperatorOptions::GetOption1<PI::OperatorOption_PADDING, PI::OperatorOption_TypePaddingType,PI::PaddingType>(*opts, &paddingType)
 				+ OperatorOptions::GetOption1<PI::OperatorOption_FUSED_ACTIVATION_FUNCTION,
-					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &activationFunction);
+					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &p.activationFunction);
 			assert(numParsed==6); // need to have 6 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
-			PRINT_OPTS(operatorKind << ": have " << opts->size() << " options:"
-			           " strideHeight=" << strideHeight <<
-			           " strideHeight=" << strideHeight <<
-			           " filterWidth=" << filterWidth <<
-			           " filterHeight=" << filterHeight <<
+			PRINT_OPTS(op.kind << ": have " << opts->size() << " options:"
+			           " strideWidth=" << p.strideWidth <<
+			           " strideHeight=" << p.strideHeight <<
+			           " filterWidth=" << p.filterWidth <<
+			           " filterHeight=" << p.filterHeight <<
 			           " paddingType=" << paddingType <<
-			           " activationFunction=" << activationFunction
+			           " activationFunction=" << p.activationFunction
 			)
 
-			// tensors
-			auto inputShape  = model->getTensorShape(inputs[0]);
-			TensorShape filterShape = {0,(unsigned)filterHeight,(unsigned)filterWidth,0};
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto outputShapeSize = Tensor::flatSize(outputShape);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[outputShapeSize]);
-
-			// compute
-			(operatorKind==PI::KindMaxPool ? NnOperators::MaxPool : NnOperators::AveragePool)(
-				inputShape, (*tensorData)[inputs[0]].get(), // input
-				outputShape, outputData.get(), // output
-				translatePadding(strideWidth,  1/*dilationWidth*/,  WIDTH,  inputShape, filterShape, outputShape),
-				translatePadding(strideHeight, 1/*dilationHeight*/, HEIGHT, inputShape, filterShape, outputShape),
-				strideWidth, strideHeight,
-				filterWidth, filterHeight
-			);
-
-			// activation function
-			applyActivationFunction(outputShapeSize, outputData.get(), activationFunction);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			// padding values
+			TensorShape filterShape = {0,(unsigned)p.filterHeight,(unsigned)p.filterWidth,0};
+			p.paddingWidth  = translatePadding(p.strideWidth,  1/*dilationWidth*/,  WIDTH,  op.inputShapes[0], filterShape, op.outputShapes[0]);
+			p.paddingHeight = translatePadding(p.strideHeight, 1/*dilationHeight*/, HEIGHT, op.inputShapes[0], filterShape, op.outputShapes[0]);
 
+			op.exec = runPool;
 			break;
-		} case PI::KindTanh: {
+		} case PI::KindTanh:
+		  case PI::KindLogistic:
+		  case PI::KindHardSwish:
+		  case PI::KindRSqrt: {
 			assert(inputs.size()==1 && outputs.size()==1);
-			assert(!opts || opts->empty()); // tanh has no options
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			PRINT_OPTS("Tanh: activation function")
-
-			// tensors
-			auto inputShape = model->getTensorShape(inputs[0]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto inputShapeSize = Tensor::flatSize(inputShape);
-			assert(inputShape==outputShape);
-			UNUSED(outputShape)
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[inputShapeSize]);
-
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			auto output = outputData.get();
-			for (auto inpute = input+inputShapeSize; input<inpute; input++, output++)
-				*output = std::tanh(*input);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			assert(!opts || opts->empty()); // these operators have no options
 
+			op.exec =
+				op.kind==PI::KindTanh      ? runSingleOperator<computeTanh> :
+				op.kind==PI::KindLogistic  ? runSingleOperator<computeLogistic> :
+				op.kind==PI::KindHardSwish ? runSingleOperator<computeHardSwish> :
+				                             runSingleOperator<computeRSqrt>;
 			break;
-		} case PI::KindLogistic: {
+		} case PI::KindRelu:
+		  case PI::KindSign: {
 			assert(inputs.size()==1 && outputs.size()==1);
-			assert(!opts || opts->empty()); // tanh has no options
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			PRINT_OPTS("Logistic: activation function")
-
-			// tensors
-			auto inputShape = model->getTensorShape(inputs[0]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto inputShapeSize = Tensor::flatSize(inputShape);
-			assert(inputShape==outputShape);
-			UNUSED(outputShape)
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[inputShapeSize]);
-
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			auto output = outputData.get();
-			for (auto inpute = input+inputShapeSize; input<inpute; input++, output++)
-				*output = 1./(1. + std::exp(*input));
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			assert(!opts); // these operators have no options
+			assert(op.inputShapes[0] == op.outputShapes[0]); // produces the same shape as consumes TODO should be in the model validation stage
 
+			op.exec = op.kind==PI::KindRelu ? runSingleOperator<computeRelu> : runSingleOperator<computeSign>;
 			break;
 		} case PI::KindReshape: {
 			assert((inputs.size()==1 || inputs.size()==2) && outputs.size()==1); // XXX now sure why the 'new_shape' is in both input[1] and 'new_shape' option
 			assert(opts); // need to have options present, but we ignore them for now ...
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-			assert(Tensor::flatSize(model->getTensorShape(outputs[0])) == Tensor::flatSize(model->getTensorShape(inputs[0])));
+			assert(Tensor::flatSize(op.outputShapes[0]) == Tensor::flatSize(op.inputShapes[0]));
 
 			PRINT_OPTS("Reshape: have " << opts->size() << " options, but we ignored them for now")
 
-			// just share the data array
-			(*tensorData)[outputs[0]] = (*tensorData)[inputs[0]];
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
-			break;
-		} case PI::KindHardSwish: {
-			assert(inputs.size()==1 && outputs.size()==1);
-			assert(!opts || opts->empty()); // h-swish has no options
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			PRINT_OPTS("HardSwish: activation function")
-
-			// tensors
-			auto inputShape = model->getTensorShape(inputs[0]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto inputShapeSize = Tensor::flatSize(inputShape);
-			assert(inputShape==outputShape);
-			UNUSED(outputShape)
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[inputShapeSize]);
-
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			auto output = outputData.get();
-			auto hardSwish = [](float x) {
-				// defined in the "Searching for MobileNet3" paper (https://arxiv.org/pdf/1905.02244.pdf)
-				// h-swish(x) = x*(ReLU6(x+3)/6)
-				if (x>=3)
-					return x;
-				else if (x<=-3)
-					return (float)0;
-				else
-					return x*(x+3)/6;
-			};
-			for (auto inpute = input+inputShapeSize; input<inpute; input++, output++)
-				*output = hardSwish(*input);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
-			break;
-		} case PI::KindRSqrt: {
-			computeSingleOperator([](float f) -> float {return 1./std::sqrt(f);});
+			op.exec = runReshape;
 			break;
 		} case PI::KindAdd:
 		  case PI::KindSub:
-		  case PI::KindMul: {
+		  case PI::KindMul:
+		  case PI::KindDiv: {
 			assert(inputs.size()==2 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert(model->getTensorShape(inputs[0])==model->getTensorShape(outputs[0]) || model->getTensorShape(inputs[1])==model->getTensorShape(outputs[0])); // produces the same shape as consumes TODO should be in the model validation stage
-
-			// operator options required to run this operator
-			PI::ActivationFunction activationFunction = PI::ActivationFunction_NONE;
 
+			// parse the operator options supplied by the model
 			unsigned numParsed =
 				OperatorOptions::GetOption1<PI::OperatorOption_FUSED_ACTIVATION_FUNCTION,
-					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &activationFunction);
+					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &p.activationFunction);
 			assert(numParsed==1); // need to have 1 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
-			PRINT_OPTS(operatorKind << ": have " << opts->size() << " options:"
-			           " activationFunction=" << activationFunction)
-
-			// tensors
-			auto input1Shape = model->getTensorShape(inputs[0]);
-			auto input2Shape = model->getTensorShape(inputs[1]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto input1ShapeSize = Tensor::flatSize(input1Shape);
-			auto input2ShapeSize = Tensor::flatSize(input2Shape);
-			auto maxInputShapeSize = std::max(input1ShapeSize,input2ShapeSize);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[maxInputShapeSize]);
-
-			// compute
-			bool succ = operatorKind==PI::KindAdd ?
-				computeDualOperator( // KindAdd
-					getTensorDataDynamicOrStatic(inputs[0]), model->getTensorShape(inputs[0]),
-					getTensorDataDynamicOrStatic(inputs[1]), model->getTensorShape(inputs[1]),
-					outputData.get(), outputShape,
-					[](float f1, float f2) {return f1+f2;})
-				: operatorKind==PI::KindSub ?
-				computeDualOperator( // KindSub
-					getTensorDataDynamicOrStatic(inputs[0]), model->getTensorShape(inputs[0]),
-					getTensorDataDynamicOrStatic(inputs[1]), model->getTensorShape(inputs[1]),
-					outputData.get(), outputShape,
-					[](float f1, float f2) {return f1-f2;})
-				:
-				computeDualOperator( // KindMul
-					getTensorDataDynamicOrStatic(inputs[0]), model->getTensorShape(inputs[0]),
-					getTensorDataDynamicOrStatic(inputs[1]), model->getTensorShape(inputs[1]),
-					outputData.get(), outputShape,
-					[](float f1, float f2) {return f1*f2;});
-			if (!succ) {
-				cbWarningMessage(STR("Computation didn't succeed: operator #" << (oid+1) <<
-				                     ": " << operatorKind << " isn't yet implemented for shapes " << input1Shape << " and " << input2Shape));
-				return false; // failed to compute the model to the end
-			}
-
-			// activation function
-			applyActivationFunction(maxInputShapeSize, outputData.get(), activationFunction);
+			PRINT_OPTS(op.kind << ": have " << opts->size() << " options:"
+			           " activationFunction=" << p.activationFunction)
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+			op.exec =
+				op.kind==PI::KindAdd ? runElementwise<Kernels::Elementwise::Add> :
+				op.kind==PI::KindSub ? runElementwise<Kernels::Elementwise::Sub> :
+				op.kind==PI::KindMul ? runElementwise<Kernels::Elementwise::Mul> :
+				                       runElementwise<Kernels::Elementwise::Div>;
+			break;
+		} case PI::KindMaximum:
+		  case PI::KindMinimum:
+		  case PI::KindSquaredDifference: {
+			assert(inputs.size()==2 && outputs.size()==1);
+			assert(!opts || opts->size() == 0); // all options are parsed
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			PRINT_OPTS(op.kind << ": have " << (opts ? opts->size() : 0) << " options")
 
+			op.exec =
+				op.kind==PI::KindMaximum ? runElementwise<Kernels::Elementwise::Maximum> :
+				op.kind==PI::KindMinimum ? runElementwise<Kernels::Elementwise::Minimum> :
+				                           runElementwise<Kernels::Elementwise::SquaredDifference>;
 			break;
 		} case PI::KindSoftmax: {
 			assert(inputs.size()==1 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			// operator options required to run this operator
-			float beta=0;
 
+			// parse the operator options supplied by the model
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_BETA,    PI::OperatorOption_TypeFloat,float>(*opts, &beta);
+				OperatorOptions::GetOption1<PI::OperatorOption_BETA,    PI::OperatorOption_TypeFloat,float>(*opts, &p.beta);
 			assert(numParsed==1); // need to have 1 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
 			PRINT_OPTS("Softmax: have " << opts->size() << " options:"
-			           " beta=" <<  beta)
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[Tensor::flatSize(model->getTensorShape(outputs[0]))]);
-
-			// compute
-			NnOperators::Softmax(
-				model->getTensorShape(inputs[0]), (*tensorData)[inputs[0]].get(), // input
-				model->getTensorShape(outputs[0]), outputData.get(), // output
-				beta
-			);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			           " beta=" <<  p.beta)
 
+			op.exec = runSoftmax;
 			break;
 		} case PI::KindConcatenation: {
 			assert(outputs.size()==1);
 			assert(opts); // need to have options present
 
-			// operator options required to run this operator
-			int axis = 0;
-			PI::ActivationFunction activationFunction = PI::ActivationFunction_NONE;
-
-			// parse the operator options supplied by the model into the above variables
+			// parse the operator options supplied by the model
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_AXIS, PI::OperatorOption_TypeInt,int>(*opts, &axis)
+				OperatorOptions::GetOption1<PI::OperatorOption_AXIS, PI::OperatorOption_TypeInt,int>(*opts, &p.axis)
 				+ OperatorOptions::GetOption1<PI::OperatorOption_FUSED_ACTIVATION_FUNCTION,
-					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &activationFunction);
+					PI::OperatorOption_TypeActivationFunction,PI::ActivationFunction>(*opts, &p.activationFunction);
 			assert(numParsed==2); // need to have 2 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
-			// input tensors
-			std::shared_ptr<const float> inputTensorData[inputs.size()];
-			for (unsigned o = 0, oe = sizeof(inputTensorData)/sizeof(inputTensorData[0]); o < oe; o++)
-				inputTensorData[o] = (*tensorData)[inputs[o]];
-
-			// input buffers and sizes array
-			std::tuple<const float*,unsigned> ins[inputs.size()];
-			for (unsigned i = 0, ie = inputs.size(); i<ie; i++) {
-				auto inputTensorId = inputs[i];
-				auto inputShape = model->getTensorShape(inputTensorId);
-				ins[i] = {(*tensorData)[inputTensorId].get(), Tensor::flatSize(Tensor::getLastDims(inputShape, inputShape.size()-axis))};
-			}
-
-			// create output data
-			auto outputShapeSize = Tensor::flatSize(model->getTensorShape(outputs[0]));
-			std::unique_ptr<float> outputData(new float[outputShapeSize]);
-
-			// compute
-			CopyTensorSlices<float,const float>(model, outputs[0], inputs, outputData.get(), inputTensorData, axis,
-				[](float* &one, const float* &split, unsigned num) {
-					std::memcpy(one, split, num*sizeof(float));
-					one += num;
-					split += num;
-				}
-			);
-
-			// activation function
-			applyActivationFunction(outputShapeSize, outputData.get(), activationFunction);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
+			op.exec = runConcatenation;
 			break;
 		} case PI::KindSplit: {
 			assert(inputs.size()==2);
 			assert(opts); // need to have options present
 
-			// operator options required to run this operator
-			int num_splits = 0;
-
-			// parse the operator options supplied by the model into the above variables
-			unsigned numParsed = OperatorOptions::GetOption1<PI::OperatorOption_NUM_SPLITS, PI::OperatorOption_TypeInt,int>(*opts, &num_splits);
-			PRINT("numParsed=" << numParsed)
+			// parse the operator options supplied by the model
+			unsigned numParsed = OperatorOptions::GetOption1<PI::OperatorOption_NUM_SPLITS, PI::OperatorOption_TypeInt,int>(*opts, &p.numSplits);
 			assert(numParsed==1); // need to have 1 option
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
 			// checks
-			assert(num_splits == outputs.size()); // runtime check should be in the model verifier
+			assert(p.numSplits == (int)outputs.size()); // runtime check should be in the model verifier
 
 			// argument1 has the axis index
-			assert(model->getTensorShape(inputs[0]) == TensorShape({1}));
-			const int axis = model->getTensorDataF32(inputs[0])[0];
-
-			// create output data
-			std::shared_ptr<float> outputTensorData[outputs.size()];
-			for (unsigned o = 0, oe = sizeof(outputTensorData)/sizeof(outputTensorData[0]); o < oe; o++)
-				outputTensorData[o].reset(new float[Tensor::flatSize(model->getTensorShape(outputs[o]))]);
-
-			// compute
-			CopyTensorSlices<const float,float>(model, inputs[1], outputs, (*tensorData)[inputs[1]].get(), outputTensorData, axis,
-				[](const float* &one, float* &split, unsigned num) {
-					std::memcpy(split, one, num*sizeof(float));
-					one += num;
-					split += num;
-				}
-			);
-
-			// save the data and notify the caller
-			for (unsigned o = 0, oe = outputs.size(); o < oe; o++) {
-				(*tensorData)[outputs[o]] = outputTensorData[o];
-				cbTensorComputed(outputs[o]);
-			}
+			assert(op.inputShapes[0] == TensorShape({1}));
+			assert(op.inputStaticData[0]); // axis has to be static
+			p.axis = model->getTensorType(inputs[0])==PI::DataType_Int32 ?
+				static_cast<const int32_t*>(op.inputStaticData[0])[0] : (int)static_cast<const float*>(op.inputStaticData[0])[0];
 
+			op.exec = runView;
 			break;
-		} case PI::KindMean: {
-			assert(inputs.size()==2);
-			assert(outputs.size()==1);
-			assert(model->getTensorType(inputs[1]) == PI::DataType_Int32);
+		} case PI::KindStridedSlice: {
+			assert(inputs.size()==4 && outputs.size()==1);
 			assert(opts); // need to have options present
 
-			// tensors
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto outputShapeSize = Tensor::flatSize(outputShape);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[outputShapeSize]);
-
-			// compute
-			NnOperators::Mean(
-				model->getTensorShape(inputs[0]), (*tensorData)[inputs[0]].get(), // input
-				outputShape, outputData.get(), // output
-				static_cast<const int32_t*>(model->getTensorData(inputs[1])), Tensor::flatSize(model->getTensorShape(inputs[1]))
-			);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
-
-			break;
-		} case PI::KindRelu: {
-			assert(inputs.size()==1 && outputs.size()==1);
-			assert(!opts); // need to have options present
-			assert(model->getTensorShape(inputs[0]) == model->getTensorShape(outputs[0])); // produces the same shape as consumes TODO should be in the model validation stage
-
-			auto sz = Tensor::flatSize(model->getTensorShape(inputs[0]));
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[sz]);
-
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			auto output = outputData.get();
-			auto computeRelu = [](float x) -> float {
-				if (x >= 0)
-					return x;
-				else
-					return 0;
-			};
-			for (auto inpute = input+sz; input<inpute; input++, output++)
-				*output = computeRelu(*input);
+			// parse the operator options supplied by the model
+			int beginMask = 0, endMask = 0, ellipsisMask = 0, newAxisMask = 0;
+			unsigned numParsed =
+				OperatorOptions::GetOption1<PI::OperatorOption_BEGIN_MASK,         PI::OperatorOption_TypeInt,int>(*opts, &beginMask)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_END_MASK,         PI::OperatorOption_TypeInt,int>(*opts, &endMask)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_ELLIPSIS_MASK,    PI::OperatorOption_TypeInt,int>(*opts, &ellipsisMask)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_NEW_AXIS_MASK,    PI::OperatorOption_TypeInt,int>(*opts, &newAxisMask)
+				+ OperatorOptions::GetOption1<PI::OperatorOption_SHRINK_AXIS_MASK, PI::OperatorOption_TypeInt,int>(*opts, &p.shrinkAxisMask);
+			assert(numParsed==opts->size()); // all options are parsed
+			UNUSED(numParsed)
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+			// begin, end and strides should be static, ellipsis and new axes aren't supported
+			if (!op.inputStaticData[1] || !op.inputStaticData[2] || !op.inputStaticData[3] || ellipsisMask || newAxisMask) {
+				op.exec = runUnsupported; // fails when reached during the run
+				break;
+			}
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			// resolve the slice for every input dimension like TF Lite does: negative indexes count from the end, then they are clamped
+			auto &inputShape = op.inputShapes[0];
+			auto numSpecified = Tensor::flatSize(op.inputShapes[1]);
+			auto begins = static_cast<const int32_t*>(op.inputStaticData[1]);
+			auto ends = static_cast<const int32_t*>(op.inputStaticData[2]);
+			auto steps = static_cast<const int32_t*>(op.inputStaticData[3]);
+			for (unsigned d = 0; d < inputShape.size(); d++) {
+				int dim = inputShape[d];
+				int begin = d < numSpecified ? begins[d] : 0, end = d < numSpecified ? ends[d] : dim, step = d < numSpecified ? steps[d] : 1;
+				bool maskedBegin = d >= numSpecified || (beginMask & (1 << d)), maskedEnd = d >= numSpecified || (endMask & (1 << d));
+				assert(step != 0);
+				if (begin < 0)
+					begin += dim;
+				if (end < 0)
+					end += dim;
+				int size;
+				if (p.shrinkAxisMask & (1 << d)) {
+					step = 1;
+					size = 1;
+				} else if (step > 0) {
+					begin = maskedBegin ? 0 : std::clamp(begin, 0, dim);
+					end = maskedEnd ? dim : std::clamp(end, 0, dim);
+					size = end > begin ? (end - begin + step - 1)/step : 0;
+				} else {
+					begin = maskedBegin ? dim - 1 : std::clamp(begin, -1, dim - 1);
+					end = maskedEnd ? -1 : std::clamp(end, -1, dim - 1);
+					size = begin > end ? (begin - end - step - 1)/(-step) : 0;
+				}
+				p.sliceBegin.push_back(begin);
+				p.sliceSize.push_back(size);
+				p.sliceStep.push_back(step);
+			}
 
+			op.exec = runView;
 			break;
-		} case PI::KindSign: {
-			assert(inputs.size()==1 && outputs.size()==1);
-			assert(!opts); // need to have options present
-			assert(model->getTensorShape(inputs[0]) == model->getTensorShape(outputs[0])); // produces the same shape as consumes TODO should be in the model validation stage
-
-			auto sz = Tensor::flatSize(model->getTensorShape(inputs[0]));
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[sz]);
-
-			// compute
-			auto input = (*tensorData)[inputs[0]].get();
-			auto output = outputData.get();
-			auto computeSign = [](float x) -> float {
-				if (x > 0)
-					return +1;
-				if (x < 0)
-					return -1;
-				return 0;
-			};
-			for (auto inpute = input+sz; input<inpute; input++, output++)
-				*output = computeSign(*input);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+		} case PI::KindTranspose: {
+			assert(inputs.size()==2 && outputs.size()==1);
+			assert(!opts || opts->size() == 0); // all options are parsed
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			// the permutation should be static
+			if (!op.inputStaticData[1] || Tensor::flatSize(op.inputShapes[1]) != op.inputShapes[0].size()) {
+				op.exec = runUnsupported; // fails when reached during the run
+				break;
+			}
+			auto perm = static_cast<const int32_t*>(op.inputStaticData[1]);
+			p.perm.assign(perm, perm + op.inputShapes[0].size());
 
+			op.exec = runView;
 			break;
-		} case PI::KindArgMax: {
-			doArgMxx(std::numeric_limits<float>::lowest(), [](float f1,float f2) {return f1>f2;});
-			break;
-		} case PI::KindArgMin: {
-			doArgMxx(std::numeric_limits<float>::max(), [](float f1,float f2) {return f1<f2;});
-			break;
-		} case PI::KindSquaredDifference: {
-			assert(inputs.size()==2 && outputs.size()==1);
+		} case PI::KindMean: {
+			assert(inputs.size()==2);
+			assert(outputs.size()==1);
+			assert(model->getTensorType(inputs[1]) == PI::DataType_Int32);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-			assert(model->getTensorShape(inputs[0]) == model->getTensorShape(outputs[0])); // produces the same shape as consumes TODO should be in the model validation stage
-
-			assert(opts->size() == 0); // all options are parsed
-
-			PRINT_OPTS(operatorKind << ": have " << opts->size() << " options")
-
-			// tensors
-			auto input1Shape = model->getTensorShape(inputs[0]);
-			auto input2Shape = model->getTensorShape(inputs[1]);
-			auto outputShape = model->getTensorShape(outputs[0]);
-			auto input1ShapeSize = Tensor::flatSize(input1Shape);
-
-			// create output data
-			std::unique_ptr<float> outputData(new float[input1ShapeSize]);
-
-			// compute
-			if (!computeDualOperator(
-					(*tensorData)[inputs[0]].get(), model->getTensorShape(inputs[0]),
-					getTensorDataDynamicOrStatic(inputs[1]), model->getTensorShape(inputs[1]),
-					outputData.get(), outputShape,
-					[](float f1, float f2) {return (f1-f2)*(f1-f2);}))
-			{
-				cbWarningMessage(STR("Computation didn't succeed: operator #" << (oid+1) <<
-				                     ": " << operatorKind << " isn't yet implemented for shapes " << input1Shape << " and " << input2Shape));
-				return false; // failed to compute the model to the end
-			}
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
-
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			op.exec = runMean;
+			break;
+		} case PI::KindArgMax:
+		  case PI::KindArgMin: {
+			assert(inputs.size()==1);
+			assert(outputs.size()==1);
+			assert(opts); // need to have options present // TODO check the output_type operator option
 
+			op.exec = op.kind==PI::KindArgMax ? runArgMxx<true> : runArgMxx<false>;
 			break;
-		} case PI::KindResizeBilinear: {
+		} case PI::KindResizeBilinear:
+		  case PI::KindResizeNearestNeighbor: {
 			assert(inputs.size()==1 && outputs.size()==1);
 			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			// operator options required to run this operator
-			bool alignCorners = false;
 
+			// parse the operator options supplied by the model
 			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_ALIGN_CORNERS, PI::OperatorOption_TypeFloat,bool>(*opts, &alignCorners);
+				OperatorOptions::GetOption1<PI::OperatorOption_ALIGN_CORNERS, PI::OperatorOption_TypeBool,bool>(*opts, &p.alignCorners);
 			assert(numParsed==1); // need to have 1 options
 			assert(numParsed==opts->size()); // all options are parsed
 			UNUSED(numParsed)
 
-			PRINT_OPTS("ResizeBilinear: have " << opts->size() << " options:"
-			           " alignCorners=" << alignCorners)
+			PRINT_OPTS(op.kind << ": have " << opts->size() << " options:"
+			           " alignCorners=" << p.alignCorners)
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[Tensor::flatSize(model->getTensorShape(outputs[0]))]);
-
-			// compute
-			NnOperators::ResizeBilinear(
-				model->getTensorShape(inputs[0]), (*tensorData)[inputs[0]].get(), // input
-				model->getTensorShape(outputs[0]), outputData.get(), // output
-				alignCorners
-			);
-
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+			op.exec = runResize;
+			break;
+		} case PI::KindOuterProduct: {
+			assert(inputs.size()==2 && outputs.size()==1);
+			assert(!opts); // no options are defined for OuterProduct
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+			op.exec = runOuterProduct;
+			break;
+		} case PI::KindLossMeanSquareError:
+		  case PI::KindLossMeanAbsoluteError: {
+			assert(inputs.size()==2 && outputs.size()==1);
 
+			op.exec = runLoss;
 			break;
-		} case PI::KindResizeNearestNeighbor: {
+		} case PI::KindDequantize:
+		  case PI::KindQuantize: {
 			assert(inputs.size()==1 && outputs.size()==1);
-			assert(opts); // need to have options present
-			assert((*tensorData)[inputs[0]]); // need to have the input data present
-
-			// operator options required to run this operator
-			bool alignCorners = false;
 
-			unsigned numParsed =
-				OperatorOptions::GetOption1<PI::OperatorOption_ALIGN_CORNERS, PI::OperatorOption_TypeFloat,bool>(*opts, &alignCorners);
-			assert(numParsed==1); // need to have 1 options
-			assert(numParsed==opts->size()); // all options are parsed
-			UNUSED(numParsed)
-
-			PRINT_OPTS("ResizeBilinear: have " << opts->size() << " options:"
-			           " alignCorners=" << alignCorners)
+			op.exec = runCopy; // Quantize is bound to its integer kernel below
+			break;
+		} default: {
+			op.exec = runUnsupported; // fails when reached during the run
+		}}
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[Tensor::flatSize(model->getTensorShape(outputs[0]))]);
+		// quantized tensors: operators are computed by integer kernels, or by float kernels on dequantized static inputs
+		if (integerKernels && op.exec != runUnsupported && bindQuantizedKernel(model, op))
+			plan->numQuantizedOperators++;
+		else
+			dequantizeStaticInputs(model, *plan, op);
 
-			// compute
-			NnOperators::ResizeNearestNeighbor(
-				model->getTensorShape(inputs[0]), (*tensorData)[inputs[0]].get(), // input
-				model->getTensorShape(outputs[0]), outputData.get(), // output
-				alignCorners
-			);
+		// batches: operators that combine values of different samples can't be computed on batches
+		if (batched && !isBatchable(op, plan->batchedTensors))
+			op.exec = runNotBatchable; // fails when reached during the run
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+		op.bytesTouched = operatorBytesTouched(model, *plan, op);
+	}
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+	/// dependencies between operators
+
+	auto numTensors = plan->numTensors;
+	auto numSteps = (unsigned)plan->operators.size();
+	std::vector<int> tensorProducers;
+	auto &tensorConsumers = plan->tensorConsumers;
+	ModelFunctions::indexOperatorsByTensors(model, tensorProducers, tensorConsumers);
+	for (unsigned step = 0; step < numSteps; step++) { // operators are indexed by their ids
+		auto &op = plan->operators[step];
+		for (auto tid : op.outputs)
+			for (auto consumer : tensorConsumers[tid]) {
+				assert(consumer > step); // the model order is a valid order of execution
+				auto &successors = op.successors;
+				if (std::find(successors.begin(), successors.end(), consumer) == successors.end()) {
+					successors.push_back(consumer);
+					plan->operators[consumer].numPredecessors++;
+				}
+			}
+	}
+	for (unsigned step = 0; step < numSteps; step++)
+		if (plan->operators[step].numPredecessors == 0)
+			plan->roots.push_back(step);
+
+	/// plan memory
+
+	// aliases: Reshape outputs share memory with their inputs, views share memory with their inputs,
+	//          inputs of in-place concatenations are parts of their outputs
+	std::vector<PI::TensorId> source(numTensors);
+	std::vector<size_t> sourceOffset(numTensors, 0); // bytes from the beginning of the source
+	for (PI::TensorId tid = 0; tid < numTensors; tid++)
+		source[tid] = tid;
+	auto modelOutputs = model->getOutputs();
+	bool packed = keepAllIntermediates || retainedTensors; // kept and recomputed tensors should be viewable by themselves
+
+	// views: contiguous parts of packed inputs are aliases, strided ones stay views when they are only consumed once
+	std::vector<bool> lazyViews(numTensors, false);
+	unsigned numViews = 0;
+	for (auto &op : plan->operators)
+		if (op.exec == runView) {
+			auto inputTid = op.inputs[viewInputIndex(op)];
+			TensorView input(nullptr, plan->tensorShapes[inputTid]); // only the layout
+			for (unsigned o = 0, oe = op.outputs.size(); o < oe; o++) {
+				auto tid = op.outputs[o];
+				auto view = outputView(op, input, o);
+				assert(Tensor::flatSize(view.shape) == Tensor::flatSize(op.outputShapes[o]));
+				if (!lazyViews[inputTid] && view.isContiguous()) {
+					op.viewOutputs.push_back(OperatorPlan::ViewOutput::Alias);
+					sourceOffset[tid] = view.offset*sizeof(float);
+				} else if (!packed && plan->tensorConsumers[tid].size() == 1 &&
+				           std::find(modelOutputs.begin(), modelOutputs.end(), tid) == modelOutputs.end()) {
+					op.viewOutputs.push_back(OperatorPlan::ViewOutput::Lazy);
+					lazyViews[tid] = true;
+				} else {
+					op.viewOutputs.push_back(OperatorPlan::ViewOutput::Copy);
+					continue;
+				}
+				numViews++;
+			}
+		}
 
-			break;
-		} case PI::KindOuterProduct: {
-			assert(inputs.size()==2 && outputs.size()==1);
-			assert(!opts); // no options are defined for OuterProduct
+	// in-place concatenations
+	unsigned numInPlace = 0;
+	if (!packed) {
+		for (auto &op : plan->operators)
+			if (op.kind == PI::KindConcatenation && canConcatenateInPlace(*plan, op, tensorProducers, modelOutputs)) {
+				auto &outputShape = op.outputShapes[0];
+				unsigned axis = op.params.axis < 0 ? op.params.axis + (int)outputShape.size() : op.params.axis;
+				auto inner = Tensor::sizeBetweenDims(outputShape, axis + 1, outputShape.size() - 1);
+				bool strided = Tensor::sizeBetweenDims(outputShape, 0, (int)axis - 1) > 1;
+				unsigned offset = 0; // along the axis
+				for (unsigned i = 0; i < op.inputs.size(); i++) {
+					auto tid = op.inputs[i];
+					source[tid] = op.outputs[0];
+					sourceOffset[tid] = offset*inner*sizeof(float);
+					if (strided)
+						plan->operators[tensorProducers[tid]].outputStride = outputShape[axis];
+					offset += op.inputShapes[i][axis];
+				}
+				op.inPlace = true;
+				numInPlace++;
+			}
+	}
 
-			auto input1Shape = model->getTensorShape(inputs[0]);
-			auto input2Shape = model->getTensorShape(inputs[1]);
-			assert(input1Shape.size()==2 && input1Shape[0]==1 && input2Shape.size()==2 && input2Shape[0]==1);
+	// integer values: integer kernels pass them to each other, real values are only computed for float kernels, for model outputs,
+	//                 and for tensors that should be viewable by themselves
+	auto isInteger = [&plan](int step) { // the operator produces integer values
+		return step != -1 && plan->operators[step].quantized;
+	};
+	auto takesIntegers = [&plan](unsigned step) { // the operator consumes integer values, Quantize takes real values
+		return plan->operators[step].quantized && plan->operators[step].kind != PI::KindQuantize;
+	};
+	std::vector<bool> integerOnly(numTensors, false);
+	if (!packed)
+		for (auto &op : plan->operators)
+			if (op.quantized) {
+				auto tid = op.outputs[0];
+				auto &consumers = plan->tensorConsumers[tid];
+				integerOnly[tid] = source[tid] == tid && std::find(modelOutputs.begin(), modelOutputs.end(), tid) == modelOutputs.end() &&
+				                   std::all_of(consumers.begin(), consumers.end(), takesIntegers);
+			}
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[input1Shape[1]*input2Shape[1]]);
+	// find lifetimes of computed tensors, aliases extend lifetimes of their sources
+	std::vector<int> producedAt(numTensors, -1), lastUsedAt(numTensors, -1);
+	std::vector<std::vector<unsigned>> users(numTensors);   // operators that produce or use memory of the tensor
+	std::vector<std::vector<unsigned>> writers(numTensors); // operators that produce the tensor or its parts
+	for (unsigned step = 0; step < numSteps; step++) {
+		auto &op = plan->operators[step];
+		for (auto tid : op.inputs)
+			if (producedAt[source[tid]] != -1) {
+				lastUsedAt[source[tid]] = step;
+				users[source[tid]].push_back(step);
+			}
+		if (op.kind == PI::KindReshape) {
+			source[op.outputs[0]] = source[op.inputs[0]];
+			sourceOffset[op.outputs[0]] = sourceOffset[op.inputs[0]];
+		} else {
+			for (unsigned o = 0, oe = op.outputs.size(); o < oe; o++) {
+				auto tid = op.outputs[o];
+				if (!op.viewOutputs.empty() && op.viewOutputs[o] != OperatorPlan::ViewOutput::Copy) {
+					auto inputTid = op.inputs[viewInputIndex(op)];
+					source[tid] = source[inputTid];
+					sourceOffset[tid] += sourceOffset[inputTid];
+					continue;
+				}
+				if (integerOnly[tid])
+					continue;
+				auto src = source[tid];
+				if (producedAt[src] == -1)
+					producedAt[src] = step;
+				lastUsedAt[src] = step;
+				users[src].push_back(step);
+				writers[src].push_back(step);
+			}
+		}
+	}
+	for (auto tid : model->getOutputs())
+		if (producedAt[source[tid]] != -1)
+			lastUsedAt[source[tid]] = numSteps; // model outputs live until the end
+	if (retainedTensors)
+		for (auto tid : *retainedTensors)
+			if (producedAt[source[tid]] != -1)
+				lastUsedAt[source[tid]] = numSteps; // and so do retained tensors
+
+	// place them into the arena with integer values and scratch spaces of kernels
+	plan->tensorOffsets.resize(numTensors, NoOffset);
+	plan->integerOffsets.resize(numTensors, NoOffset);
+	std::vector<MemoryPlanner::TensorLifetime> lifetimes;
+	std::vector<std::vector<unsigned>> regionUsers, regionWriters; // by region
+	std::vector<size_t*> regionOffsets;
+	for (PI::TensorId tid = 0; tid < numTensors; tid++)
+		if (producedAt[tid] != -1) {
+			lifetimes.push_back({Tensor::flatSize(plan->tensorShapes[tid])*sizeof(float), (unsigned)producedAt[tid], (unsigned)lastUsedAt[tid]});
+			regionUsers.push_back(users[tid]);
+			regionWriters.push_back(writers[tid]);
+			regionOffsets.push_back(&plan->tensorOffsets[tid]);
+		}
+	auto alignedSize = [](size_t size) {
+		return (size + MemoryPlanner::Alignment - 1)/MemoryPlanner::Alignment*MemoryPlanner::Alignment;
+	};
+	std::vector<size_t> scratchBegin(numSteps, 0);
+	for (unsigned step = 0; step < numSteps; step++) {
+		auto &op = plan->operators[step];
+		size_t scratchSize = 0;
+		if (op.quantized) {
+			// integer values live until their last integer consumer
+			auto tid = op.outputs[0];
+			std::vector<unsigned> integerUsers = {step};
+			for (auto consumer : plan->tensorConsumers[tid])
+				if (takesIntegers(consumer))
+					integerUsers.push_back(consumer);
+			lifetimes.push_back({Tensor::flatSize(plan->tensorShapes[tid]), step, *std::max_element(integerUsers.begin(), integerUsers.end())});
+			regionUsers.push_back(integerUsers);
+			regionWriters.push_back({step});
+			regionOffsets.push_back(&plan->integerOffsets[tid]);
+			// scratch: computed inputs without integer values are quantized, FullyConnected widens its input
+			for (unsigned i = 0; i < op.quantized->inputs.size(); i++)
+				if (packed || !isInteger(tensorProducers[op.inputs[i]])) {
+					op.scratchOffsets.push_back(scratchSize);
+					scratchSize += alignedSize(Tensor::flatSize(op.inputShapes[i]));
+				} else
+					op.scratchOffsets.push_back(NoOffset);
+			if (op.kind == PI::KindFullyConnected) {
+				op.scratchOffsets.push_back(scratchSize);
+				scratchSize += alignedSize(Tensor::flatSize(op.inputShapes[0])*sizeof(int16_t));
+			}
+		}
+		// scratch: lazy views are copied for kernels that need packed inputs
+		if (op.viewOutputs.empty())
+			for (unsigned i = 0, ie = op.inputs.size(); i < ie; i++)
+				if (lazyViews[op.inputs[i]]) {
+					op.viewInputOffsets.resize(ie, NoOffset);
+					op.viewInputOffsets[i] = scratchSize;
+					scratchSize += alignedSize(Tensor::flatSize(op.inputShapes[i])*sizeof(float));
+				}
+		if (scratchSize > 0) {
+			lifetimes.push_back({scratchSize, step, step});
+			regionUsers.push_back({step});
+			regionWriters.push_back({step});
+			regionOffsets.push_back(&scratchBegin[step]);
+		}
+	}
+	MemoryPlanner::ArenaPlan arenaPlan;
+	if (!keepAllIntermediates) {
+		// operators can run concurrently: memory can only be reused when all users of the old tensor happen before the new one is produced
+		std::vector<std::vector<bool>> happensBefore(numSteps, std::vector<bool>(numSteps, false)); // [op][earlier op]
+		for (unsigned step = 0; step < numSteps; step++)
+			for (auto successor : plan->operators[step].successors) {
+				auto &hb = happensBefore[successor];
+				hb[step] = true;
+				for (unsigned s = 0; s < step; s++)
+					if (happensBefore[step][s])
+						hb[s] = true;
+			}
+		MemoryPlanner::planArena(lifetimes, true/*reuse*/, arenaPlan, [&](unsigned i1, unsigned i2) {
+			if (lifetimes[i1].last == numSteps)
+				return false; // model outputs and retained tensors are alive until the end
+			for (auto writer : regionWriters[i2]) {
+				auto &hb = happensBefore[writer];
+				for (auto user : regionUsers[i1])
+					if (!hb[user])
+						return false;
+			}
+			return true;
+		});
+	} else {
+		MemoryPlanner::planArena(lifetimes, false/*reuse*/, arenaPlan);
+	}
 
-			// compute
-			auto computeOuterProduct = [](const float *left, unsigned Nleft, const float *right, unsigned Nright, float *result) {
-				auto righte = right + Nright;
-				for (auto lefte = left+Nleft; left < lefte; left++)
-					for (auto r = right; r < righte; r++)
-						*result++ = *left * *r;
-			};
-			computeOuterProduct(
-				getTensorDataDynamicOrStatic(inputs[0]), input1Shape[1],
-				getTensorDataDynamicOrStatic(inputs[1]), input2Shape[1],
-				outputData.get()
-			);
+	plan->keepAllIntermediates = keepAllIntermediates;
+	plan->recomputable = retainedTensors != nullptr;
+	for (unsigned i = 0, ie = lifetimes.size(); i < ie; i++)
+		*regionOffsets[i] = arenaPlan.offsets[i];
+	for (PI::TensorId tid = 0; tid < numTensors; tid++)
+		if (source[tid] != tid)
+			plan->tensorOffsets[tid] = plan->tensorOffsets[source[tid]] + sourceOffset[tid];
+	for (unsigned step = 0; step < numSteps; step++) {
+		for (auto &offset : plan->operators[step].scratchOffsets)
+			if (offset != NoOffset)
+				offset += scratchBegin[step];
+		for (auto &offset : plan->operators[step].viewInputOffsets)
+			if (offset != NoOffset)
+				offset += scratchBegin[step];
+	}
+	plan->arenaSize = arenaPlan.arenaSize;
+	plan->naiveSize = arenaPlan.naiveSize;
+
+	// release tensors after their last use so that they don't point to memory reused by other tensors
+	if (!keepAllIntermediates)
+		for (auto &op : plan->operators)
+			for (auto tid : op.outputs)
+				if (lazyViews[tid])
+					plan->operators[plan->tensorConsumers[tid][0]].releasedTensors.push_back(tid); // copied into the scratch space of its consumer
+				else if (producedAt[source[tid]] != -1 && lastUsedAt[source[tid]] != (int)numSteps)
+					plan->operators[lastUsedAt[source[tid]]].releasedTensors.push_back(tid);
+
+	PRINT("Compute: planned " << plan->arenaSize << " bytes for computed tensors"
+	      " (" << plan->naiveSize << " bytes if allocated separately)" << (keepAllIntermediates ? ", all intermediates are kept" : "") <<
+	      (retainedTensors ? STR(", " << retainedTensors->size() << " tensors are retained, others are recomputed on demand") : std::string()) <<
+	      (numInPlace ? STR(", " << numInPlace << " concatenations are computed in place") : std::string()) <<
+	      (numViews ? STR(", " << numViews << " tensors are views of other tensors") : std::string()) <<
+	      (plan->numQuantizedOperators ? STR(", " << plan->numQuantizedOperators << " operators are computed by integer kernels") : std::string()))
+
+	return plan.release();
+}
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+static bool runOperator(const OperatorPlan &op, Execution &ex) {
+	auto start = ex.operatorTimes ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+	if (op.viewOutputs.empty()) // view operators take views, other kernels need packed inputs
+		ex.materializeInputs(op);
+	bool succ = op.exec(op, ex);
+	if (ex.operatorTimes) // every operator has its own element
+		(*ex.operatorTimes)[&op - ex.plan.operators.data()] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return succ;
+}
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+// runs operators in the pool as soon as their inputs are computed, callbacks are forwarded to the calling thread
+static bool runParallel(const Plan &plan, Execution &ex, const std::vector<bool> *selected) {
+	struct Notification {
+		bool            isWarning;
+		PI::TensorId    tid;
+		std::string     msg;
+	};
+	std::mutex                        lock;
+	std::condition_variable           changed;
+	std::deque<Notification>          notifications;
+	std::vector<unsigned>             numPendingInputs(plan.operators.size());
+	unsigned                          numRunning = 0;
+	bool                              failed = false;
+	auto isSelected = [selected](unsigned i) {
+		return !selected || (*selected)[i];
+	};
+	if (!selected)
+		for (unsigned i = 0, ie = plan.operators.size(); i < ie; i++)
+			numPendingInputs[i] = plan.operators[i].numPredecessors;
+	else // only selected predecessors are waited for
+		for (unsigned i = 0, ie = plan.operators.size(); i < ie; i++)
+			if ((*selected)[i])
+				for (auto successor : plan.operators[i].successors)
+					numPendingInputs[successor]++;
+
+	// kernels report through the execution object that queues notifications
+	std::function<void(PI::TensorId)> cbTensorComputed = [&](PI::TensorId tid) {
+		std::unique_lock<std::mutex> l(lock);
+		notifications.push_back({false, tid, ""});
+	};
+	std::function<void(const std::string&)> cbWarningMessage = [&](const std::string &msg) {
+		std::unique_lock<std::mutex> l(lock);
+		notifications.push_back({true, 0, msg});
+	};
+	Execution exPool{plan, ex.arena, ex.tensorData, ex.views, ex.integerData, ex.staticData, cbTensorComputed, cbWarningMessage, ex.cancel, ex.operatorTimes};
+
+	std::function<void(unsigned)> submit = [&](unsigned i) { // called with the lock held
+		numRunning++;
+		ThreadPool::submit([&,i]() {
+			auto &op = plan.operators[i];
+			bool succ = runOperator(op, exPool);
+			std::unique_lock<std::mutex> l(lock);
+			numRunning--;
+			if (!succ || exPool.cancelled())
+				failed = true; // operators that are already running finish, no new ones are started
+			else if (!failed)
+				for (auto successor : op.successors)
+					if (isSelected(successor) && --numPendingInputs[successor] == 0)
+						submit(successor);
+			changed.notify_all();
+		});
+	};
+	{
+		std::unique_lock<std::mutex> l(lock);
+		if (!selected)
+			for (auto i : plan.roots)
+				submit(i);
+		else
+			for (unsigned i = 0, ie = plan.operators.size(); i < ie; i++)
+				if ((*selected)[i] && numPendingInputs[i] == 0)
+					submit(i);
+	}
 
+	// deliver notifications and help to run operators until all are done
+	std::unique_lock<std::mutex> l(lock);
+	while (true) {
+		while (!notifications.empty()) {
+			auto n = std::move(notifications.front());
+			notifications.pop_front();
+			l.unlock();
+			if (n.isWarning)
+				ex.cbWarningMessage(n.msg);
+			else
+				ex.cbTensorComputed(n.tid);
+			l.lock();
+		}
+		if (numRunning == 0)
 			break;
-		} case PI::KindLossMeanSquareError: {
-			assert(inputs.size()==2 && outputs.size()==1 && Tensor::flatSize(model->getTensorShape(outputs[0]))==1);
-			assert(model->getTensorShape(inputs[0]) == model->getTensorShape(inputs[1]));
+		l.unlock();
+		bool ran = ThreadPool::runPendingTask();
+		l.lock();
+		if (!ran && notifications.empty() && numRunning > 0)
+			changed.wait(l);
+	}
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[1]);
+	return !failed;
+}
 
-			// compute
-			outputData.get()[0] = computeLossMeanSquareError(
-				(*tensorData)[inputs[0]].get(),
-				(*tensorData)[inputs[1]].get(),
-				Tensor::flatSize(model->getTensorShape(inputs[0]))
-			);
+// runs all operators, or only the selected ones when the results of others are already available
+static bool runOperators(const Plan &plan, Execution &ex, const std::vector<bool> *selected, Scheduling scheduling, Profile *profile) {
+	auto &tensorData = ex.tensorData;
+
+	if (profile) { // operators are timed individually, those that didn't run have negative times
+		std::vector<double> times(plan.operators.size(), -1);
+		ex.operatorTimes = &times;
+		bool succ = runOperators(plan, ex, selected, scheduling, nullptr);
+		ex.operatorTimes = nullptr;
+		profile->clear();
+		for (unsigned i = 0, ie = plan.operators.size(); i < ie; i++)
+			if (times[i] >= 0)
+				profile->push_back({plan.operators[i].oid, times[i], plan.operators[i].bytesTouched});
+		return succ;
+	}
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+	if (scheduling == Scheduling::Parallel && ThreadPool::getNumThreads() > 1) {
+		if (!runParallel(plan, ex, selected))
+			return false; // failed to compute the model to the end
+		// the order of operators isn't known in advance: release tensors at the end
+		if (!plan.keepAllIntermediates)
+			for (auto &op : plan.operators)
+				for (auto tid : op.releasedTensors)
+					tensorData[tid].reset();
+		return true; // successfully computed the model to the end
+	}
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+	for (unsigned i = 0, ie = plan.operators.size(); i < ie; i++) {
+		if (selected && !(*selected)[i])
+			continue;
+		auto &op = plan.operators[i];
+		if (ex.cancelled() || !runOperator(op, ex))
+			return false; // failed to compute the model to the end
+		for (auto tid : op.releasedTensors)
+			tensorData[tid].reset();
+	}
 
-			break;
-		} case PI::KindLossMeanAbsoluteError: {
-			assert(inputs.size()==2 && outputs.size()==1 && Tensor::flatSize(model->getTensorShape(outputs[0]))==1);
-			assert(model->getTensorShape(inputs[0]) == model->getTensorShape(inputs[1]));
+	return true; // successfully computed the model to the end
+}
 
-			auto sz = Tensor::flatSize(model->getTensorShape(inputs[0]));
+bool run(
+	const Plan &plan,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	std::function<void(PI::TensorId)> cbTensorComputed,
+	std::function<void(const std::string&)> cbWarningMessage,
+	Scheduling scheduling,
+	const std::atomic<bool> *cancel,
+	Profile *profile)
+{
+	assert(tensorData && tensorData->size() == plan.numTensors);
+
+	// release results of the previous run, they would be overwritten anyway
+	for (auto &op : plan.operators)
+		for (auto tid : op.outputs)
+			(*tensorData)[tid].reset();
+
+	// reuse the arena unless results of some other run still hold it
+	std::shared_ptr<uint8_t> arena;
+	{
+		std::unique_lock<std::mutex> lock(plan.arenaLock);
+		if (!plan.arena || plan.arena.use_count() != 1)
+			plan.arena = MemoryPlanner::allocateArena(plan.arenaSize);
+		arena = plan.arena;
+	}
 
-			// create output data
-			std::unique_ptr<float> outputData(new float[1]);
+	std::vector<TensorView> views(plan.numTensors);
+	std::vector<const void*> integerData(plan.numTensors);
+	std::vector<std::shared_ptr<const float>> staticData;
+	requestStaticData(plan, staticData);
+	Execution ex{plan, arena, *tensorData, views, integerData, staticData, cbTensorComputed, cbWarningMessage, cancel};
+	return runOperators(plan, ex, nullptr/*all*/, scheduling, profile);
+}
 
-			// compute
-			if (sz==1) // a simplified computation in a 1D case
-				outputData.get()[0] = std::abs((*tensorData)[inputs[0]].get()[0] - (*tensorData)[inputs[1]].get()[0]);
+bool runIncremental(
+	const Plan &plan,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	const std::vector<PI::TensorId> &changedTensors,
+	std::function<void(PI::TensorId)> cbTensorComputed,
+	std::function<void(const std::string&)> cbWarningMessage,
+	Scheduling scheduling,
+	const std::atomic<bool> *cancel,
+	Profile *profile)
+{
+	assert(tensorData && tensorData->size() == plan.numTensors);
+
+	// weights transformed for kernels are stale when their static tensors changed, whether or not anything is reused
+	{
+		std::unique_lock<std::mutex> lock(plan.winogradFiltersLock);
+		for (auto it = plan.winogradFilters.begin(); it != plan.winogradFilters.end();)
+			if (std::find(changedTensors.begin(), changedTensors.end(), std::get<0>(it->first)) != changedTensors.end())
+				it = plan.winogradFilters.erase(it);
 			else
-				outputData.get()[0] = std::sqrt(computeLossMeanSquareError(
-					(*tensorData)[inputs[0]].get(),
-					(*tensorData)[inputs[1]].get(),
-					sz
-				));
+				it++;
+	}
+	{
+		std::unique_lock<std::mutex> lock(plan.packedFiltersLock);
+		for (auto tid : changedTensors)
+			plan.packedFilters.erase(tid);
+	}
+	for (auto tid : changedTensors) { // expanded copies are refreshed in place: operators point to them
+		auto it = plan.dequantizedTensors.find(tid);
+		if (it != plan.dequantizedTensors.end())
+			dequantizeStaticTensor(plan.model, tid, it->second.get());
+	}
+	for (auto &op : plan.operators)
+		if (op.quantized && op.quantized->filter && std::find(changedTensors.begin(), changedTensors.end(), op.inputs[1]) != changedTensors.end())
+			offsetFilter(op, *op.quantized);
+
+	// intermediate results of the previous run are released: nothing to reuse
+	if (!plan.keepAllIntermediates)
+		return run(plan, tensorData, cbTensorComputed, cbWarningMessage, scheduling, cancel, profile);
+
+	// find operators to run: consumers of changed tensors, operators without results, and everything downstream from them
+	auto numOperators = plan.operators.size();
+	std::vector<bool> dirty(numOperators, false);
+	for (auto tid : changedTensors)
+		for (auto consumer : plan.tensorConsumers[tid])
+			dirty[consumer] = true;
+	for (unsigned i = 0; i < numOperators; i++)
+		for (auto tid : plan.operators[i].outputs)
+			if (!(*tensorData)[tid])
+				dirty[i] = true;
+	for (unsigned i = 0; i < numOperators; i++) // successors always follow in the plan
+		if (dirty[i])
+			for (auto successor : plan.operators[i].successors)
+				dirty[successor] = true;
+
+	// release stale results
+	for (unsigned i = 0; i < numOperators; i++)
+		if (dirty[i])
+			for (auto tid : plan.operators[i].outputs)
+				(*tensorData)[tid].reset();
+
+	// recompute in place when only the plan and these results hold the arena, otherwise reused results stay in the old arena
+	std::shared_ptr<uint8_t> arena;
+	{
+		std::unique_lock<std::mutex> lock(plan.arenaLock);
+		long numHolders = 1; // the plan
+		if (plan.arena)
+			for (auto &data : *tensorData)
+				if (data && !data.owner_before(plan.arena) && !plan.arena.owner_before(data))
+					numHolders++;
+		if (!plan.arena || plan.arena.use_count() != numHolders)
+			plan.arena = MemoryPlanner::allocateArena(plan.arenaSize);
+		arena = plan.arena;
+	}
 
-			// save the data
-			(*tensorData)[outputs[0]].reset(outputData.release());
+	std::vector<TensorView> views(plan.numTensors);
+	std::vector<const void*> integerData(plan.numTensors);
+	std::vector<std::shared_ptr<const float>> staticData;
+	requestStaticData(plan, staticData);
+	Execution ex{plan, arena, *tensorData, views, integerData, staticData, cbTensorComputed, cbWarningMessage, cancel};
+	return runOperators(plan, ex, &dirty, scheduling, profile);
+}
 
-			// notify the caller
-			cbTensorComputed(outputs[0]);
+bool recompute(
+	const Plan &plan,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	PI::TensorId tensorId,
+	std::function<void(const std::string&)> cbWarningMessage)
+{
+	assert(plan.recomputable);
+	assert(tensorData && tensorData->size() == plan.numTensors);
+
+	if ((*tensorData)[tensorId])
+		return true; // still available
+
+	// find operators to run: the producer of the tensor, and producers of their inputs that aren't available
+	auto numOperators = plan.operators.size();
+	std::vector<int> tensorProducers(plan.numTensors, -1);
+	for (unsigned i = 0; i < numOperators; i++)
+		for (auto tid : plan.operators[i].outputs)
+			tensorProducers[tid] = i;
+	assert(tensorProducers[tensorId] != -1); // only computed tensors can be recomputed
+	std::vector<bool> selected(numOperators, false);
+	selected[tensorProducers[tensorId]] = true;
+	for (unsigned i = tensorProducers[tensorId] + 1; i-- > 0;) // producers always precede consumers in the plan
+		if (selected[i])
+			for (auto tid : plan.operators[i].inputs)
+				if (!(*tensorData)[tid] && tensorProducers[tid] != -1)
+					selected[tensorProducers[tid]] = true;
+	std::vector<std::tuple<PI::TensorId, std::shared_ptr<const float>>> available; // other outputs of selected operators can be retained
+	for (unsigned i = 0; i < numOperators; i++)
+		if (selected[i])
+			for (auto tid : plan.operators[i].outputs)
+				if ((*tensorData)[tid])
+					available.push_back({tid, (*tensorData)[tid]});
+
+	// run them in the order of the plan in an arena of their own: the plan's arena holds retained tensors, and a subset
+	// of operators in the same order never reuses memory that is still needed
+	std::shared_ptr<uint8_t> arena = MemoryPlanner::allocateArena(plan.arenaSize);
+	std::vector<TensorView> views(plan.numTensors);
+	std::vector<const void*> integerData(plan.numTensors);
+	std::vector<std::shared_ptr<const float>> staticData;
+	requestStaticData(plan, staticData);
+	std::function<void(PI::TensorId)> cbTensorComputed = [](PI::TensorId) { };
+	Execution ex{plan, arena, *tensorData, views, integerData, staticData, cbTensorComputed, cbWarningMessage};
+	bool succ = true;
+	for (unsigned i = 0; i < numOperators && succ; i++)
+		if (selected[i])
+			succ = runOperator(plan.operators[i], ex);
+
+	// copy the tensor out so that the arena is freed with the other tensors computed on the way
+	std::shared_ptr<const float> result;
+	if (succ) {
+		auto size = Tensor::flatSize(plan.tensorShapes[tensorId]);
+		std::shared_ptr<float> data(new float[size], std::default_delete<float[]>());
+		std::copy((*tensorData)[tensorId].get(), (*tensorData)[tensorId].get() + size, data.get());
+		result = data;
+	}
+	for (unsigned i = 0; i < numOperators; i++)
+		if (selected[i])
+			for (auto tid : plan.operators[i].outputs)
+				(*tensorData)[tid].reset();
+	for (auto &a : available)
+		(*tensorData)[std::get<0>(a)] = std::get<1>(a);
+	(*tensorData)[tensorId] = result;
+
+	return succ;
+}
 
-			break;
-		} default: {
-			cbWarningMessage(STR("Computation didn't succeed: operator #" << (oid+1) << ": " << operatorKind << " isn't yet implemented"));
-			return false; // failed to compute the model to the end
-		}}
+bool compareWithFloatReference(
+	const PI::Model *model,
+	const std::map<PI::TensorId, std::shared_ptr<const float>> &inputs,
+	std::vector<QuantizationError> &errors,
+	std::function<void(const std::string&)> cbWarningMessage)
+{
+	// compute the model with and without integer kernels, plans are kept until outputs are compared
+	std::unique_ptr<Plan> plans[2];
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> tensorData[2];
+	for (unsigned i = 0; i < 2; i++) {
+		plans[i].reset(compile(model, false/*keepAllIntermediates*/, 1/*batchSize*/, i == 0/*integerKernels*/));
+		tensorData[i].reset(new std::vector<std::shared_ptr<const float>>(plans[i]->numTensors));
+		auto planInputs = inputs;
+		fillInputs(planInputs, tensorData[i]);
+		if (!run(*plans[i], tensorData[i], [](PI::TensorId) { }, cbWarningMessage))
+			return false;
 	}
 
-	return true; // successfully computed the model to the end
+	// compare outputs
+	errors.clear();
+	for (auto tid : model->getOutputs()) {
+		auto size = Tensor::flatSize(plans[1]->tensorShapes[tid]);
+		auto quantized = (*tensorData[0])[tid].get(), reference = (*tensorData[1])[tid].get();
+		QuantizationError error{tid, 0, 0, 0};
+		float min = std::numeric_limits<float>::max(), max = std::numeric_limits<float>::lowest();
+		double sum = 0;
+		for (size_t i = 0; i < size; i++) {
+			auto diff = std::abs(quantized[i] - reference[i]);
+			error.maxError = std::max(error.maxError, diff);
+			sum += diff;
+			min = std::min(min, reference[i]);
+			max = std::max(max, reference[i]);
+		}
+		if (size > 0) {
+			error.meanError = sum/size;
+			error.range = max - min;
+		}
+		errors.push_back(error);
+	}
+
+	return true;
+}
+
+bool compute(
+	const PI::Model *model,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	std::function<void(PI::TensorId)> cbTensorComputed,
+	std::function<void(const std::string&)> cbWarningMessage)
+{
+	std::unique_ptr<Plan> plan(compile(model));
+	return run(*plan, tensorData, cbTensorComputed, cbWarningMessage);
 }
 
 }
@@ -8,10 +8,19 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <tuple>
 
+namespace Kernels::Gemm {
+struct PackedWeights;
+}
+namespace Kernels::Winograd {
+struct Filter;
+}
 
 namespace Compute {
 
@@ -30,7 +39,172 @@ void fillInputs(
 	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData
 );
 
-bool compute(
+/// compiled execution plan
+
+// The model is interrogated (operator IO, options, shapes, static data) only once in compile(),
+// and the resulting immutable plan can then be run any number of times.
+
+struct Execution; // run-time state of one run of a plan, defined in compute.cpp
+struct QuantizedOperator; // parameters of integer kernels, defined in compute.cpp
+
+struct OperatorPlan {
+	PluginInterface::OperatorId               oid;
+	PluginInterface::OperatorKind             kind;
+	std::vector<PluginInterface::TensorId>    inputs;
+	std::vector<PluginInterface::TensorId>    outputs;
+	std::vector<TensorShape>                  inputShapes;
+	std::vector<TensorShape>                  outputShapes;
+	std::vector<const void*>                  inputStaticData; // static data of inputs, nullptr for computed inputs
+	                                                             // float32 data of the model is only read through it while compiling: runs request it (see Plan::staticTensors)
+	struct Params { // operator options pre-parsed into typed values
+		PluginInterface::ActivationFunction activationFunction = PluginInterface::ActivationFunction_NONE;
+		int      strideWidth = 1, strideHeight = 1;
+		int      dilationWidth = 1, dilationHeight = 1;
+		int      filterWidth = 0, filterHeight = 0; // pools
+		unsigned paddingWidth = 0, paddingHeight = 0; // padding values computed from the padding type and shapes
+		int      depthMultiplier = 0;
+		int      axis = 0;
+		int      numSplits = 0;
+		int      weightsFormat = 0;
+		bool     keepNumDims = false;
+		bool     alignCorners = false;
+		int      radius = 0;
+		float    alpha = 0, beta = 0, bias = 0;
+		std::vector<unsigned> perm; // Transpose
+		std::vector<int>      sliceBegin, sliceSize, sliceStep; // StridedSlice: resolved for every input dimension
+		int      shrinkAxisMask = 0;
+	}                                         params;
+	std::vector<unsigned>                     successors;          // operators (indexes in the plan) that consume outputs of this operator
+	unsigned                                  numPredecessors = 0; // operators that produce inputs of this operator
+	unsigned                                  winogradTileSize = 0; // Conv2D: output tile size of the Winograd convolution, 0 when it isn't used
+	unsigned                                  outputStride = 0;     // Conv2D: floats between output pixels when they are written into a wider concatenated tensor, 0 when packed
+	bool                                      float16Filter = false; // Conv2D, FullyConnected: the static filter is float16, Conv2D widens it once, FullyConnected as it reads it
+	bool                                      inPlace = false;      // Concatenation: producers wrote inputs directly into the output, nothing is copied
+	enum class ViewOutput {Copy, Alias, Lazy};
+	std::vector<ViewOutput>                   viewOutputs;          // Split, StridedSlice, Transpose: outputs are copied, alias contiguous parts of the input,
+	                                                                // or stay strided views that their only consumer copies
+	std::shared_ptr<const QuantizedOperator>  quantized;            // operators on int8/uint8 tensors computed by integer kernels, nullptr for float kernels
+	std::vector<size_t>                       scratchOffsets;       // integer kernels: arena offsets of scratch space, by computed input where its real values
+	                                                                // can have to be quantized, followed by FullyConnected's input relative to its zero point
+	std::vector<size_t>                       viewInputOffsets;     // arena offsets where inputs that are lazy views are copied, by input, empty when there are none
+	size_t                                    bytesTouched = 0;     // sizes of inputs and outputs in the types that kernels access, for profiles
+	std::vector<PluginInterface::TensorId>    releasedTensors; // computed tensors not used after this operator, released unless all intermediates are kept
+	bool                                    (*exec)(const OperatorPlan &op, Execution &ex); // kernel bound to this operator during compilation
+};
+
+struct Plan {
+	const PluginInterface::Model *model;
+	unsigned                      numTensors;
+	// batch: model inputs and tensors computed from them are stacked along their first dimension
+	unsigned                      batchSize;
+	std::vector<TensorShape>      tensorShapes;   // shapes of all tensors as they are computed, batched tensors begin with batchSize
+	std::vector<bool>             batchedTensors; // which tensors have the batch dimension
+	std::vector<OperatorPlan>     operators; // in the order of the model, which is a valid order of execution
+	std::vector<PluginInterface::TensorId> staticTensors; // static float32 inputs: model views produce their data on demand, and can evict it,
+	                                                     // so every run requests it and releases it when it ends
+	std::vector<unsigned>         roots;     // operators that don't depend on other operators
+	std::vector<std::vector<unsigned>> tensorConsumers; // operators that take the tensor as an input, by tensor
+	// memory: all computed tensors are placed in one arena
+	bool                          keepAllIntermediates; // intermediate tensors stay available after the run, otherwise their memory is reused
+	bool                          recomputable;  // released tensors can be recomputed on demand, every computed tensor is then packed by itself
+	std::vector<size_t>           tensorOffsets; // offset of every computed float32 tensor in the arena, aliases point into their sources
+	std::vector<size_t>           integerOffsets; // offset of integer values of tensors that integer kernels compute
+	size_t                        arenaSize;     // planned peak memory for computed tensors
+	size_t                        naiveSize;     // memory needed if every computed tensor had its own allocation
+	mutable std::shared_ptr<uint8_t> arena;      // reused by runs when nobody else holds it
+	mutable std::mutex            arenaLock;
+	// kernels: weights transformed for particular kernels, they are created on first use and shared by operators with the same weights
+	mutable std::map<std::tuple<PluginInterface::TensorId,unsigned>, std::shared_ptr<const Kernels::Winograd::Filter>> winogradFilters; // by (filter,tileSize)
+	mutable std::mutex            winogradFiltersLock;
+	mutable std::map<PluginInterface::TensorId, std::shared_ptr<const Kernels::Gemm::PackedWeights>> packedFilters; // Conv2D filters packed into GEMM panels
+	mutable std::mutex            packedFiltersLock;
+	// quantization: integer kernels pass integer values to each other, real values of their outputs are only computed for float kernels,
+	//               model outputs and kept tensors, static inputs of float kernels are dequantized
+	unsigned                      numQuantizedOperators; // computed by integer kernels
+	std::map<PluginInterface::TensorId, std::unique_ptr<float[]>> dequantizedTensors; // static inputs of float kernels expanded to float32 once, refreshed by runIncremental
+};
+
+Plan* compile( // returns ownership
+	const PluginInterface::Model *model,
+	bool keepAllIntermediates = false, // keep all computed tensors alive after the run (needed by the visualizer)
+	unsigned batchSize = 1, // samples computed at once, inputs that begin with B=1 get B=batchSize
+	bool integerKernels = true, // operators on quantized tensors are computed by integer kernels, otherwise by float kernels on real values
+	const std::vector<PluginInterface::TensorId> *retainedTensors = nullptr // when given, these tensors stay available after the run like
+	                                                                         // model outputs, and other ones can be recomputed (see recompute())
+);
+
+// stacks inputs of individual samples (with the shapes of the model) into inputs of a batched plan
+void stackInputs(
+	const Plan &plan,
+	const std::vector<std::map<PluginInterface::TensorId, std::shared_ptr<const float>>> &samples,
+	std::map<PluginInterface::TensorId, std::shared_ptr<const float>> &inputs
+);
+
+// per-operator profile of a run
+struct OperatorProfile {
+	PluginInterface::OperatorId oid;
+	double                      time;         // wall time in seconds, operators overlap with the parallel scheduling
+	size_t                      bytesTouched; // see OperatorPlan::bytesTouched
+};
+typedef std::vector<OperatorProfile> Profile; // operators that ran, in the order of the plan
+
+enum class Scheduling {
+	Parallel,     // operators run as soon as their inputs are computed, independent operators run concurrently
+	Deterministic // operators run one at a time in the order of the plan, for debugging
+};
+
+bool run(
+	const Plan &plan,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	std::function<void(PluginInterface::TensorId)> cbTensorComputed, // callbacks are called on the calling thread
+	std::function<void(const std::string&)> cbWarningMessage,
+	Scheduling scheduling = Scheduling::Parallel,
+	const std::atomic<bool> *cancel = nullptr, // can be set by another thread: no further operators are started and run() returns false
+	Profile *profile = nullptr // output: operators are timed when it is given
+);
+
+// Incremental run: only operators that depend on the changed tensors run again, other computed tensors keep their values
+// from the previous run of the same plan with the same tensorData. Changed tensors are model inputs or static tensors altered
+// in place through getTensorDataWr: weights that the plan derived from them are refreshed. Operators without results are run
+// too, and plans that don't keep all intermediates have nothing to reuse: they are run entirely.
+bool runIncremental(
+	const Plan &plan,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	const std::vector<PluginInterface::TensorId> &changedTensors,
+	std::function<void(PluginInterface::TensorId)> cbTensorComputed,
+	std::function<void(const std::string&)> cbWarningMessage,
+	Scheduling scheduling = Scheduling::Parallel,
+	const std::atomic<bool> *cancel = nullptr,
+	Profile *profile = nullptr
+);
+
+// Recomputes a tensor that a run of a recomputable plan has released: only operators that it depends on run again,
+// starting from the nearest tensors that are still available (retained ones, model inputs). Other tensors computed
+// on the way are released again, and the recomputed tensor has its own memory.
+bool recompute(
+	const Plan &plan,
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
+	PluginInterface::TensorId tensorId,
+	std::function<void(const std::string&)> cbWarningMessage
+);
+
+// Accuracy of integer kernels: outputs of a quantized model are compared with the float32 reference,
+// where the same model is computed by float kernels on dequantized values
+struct QuantizationError {
+	PluginInterface::TensorId tensorId;  // a model output
+	float                     maxError;  // the largest absolute difference from the reference
+	float                     meanError; // the mean absolute difference from the reference
+	float                     range;     // max-min of the reference values
+};
+
+bool compareWithFloatReference(
+	const PluginInterface::Model *model,
+	const std::map<PluginInterface::TensorId, std::shared_ptr<const float>> &inputs,
+	std::vector<QuantizationError> &errors, // output: one for every model output
+	std::function<void(const std::string&)> cbWarningMessage
+);
+
+bool compute( // compiles and runs the plan once
 	const PluginInterface::Model *model,
 	std::unique_ptr<std::vector<std::shared_ptr<const float>>> &tensorData,
 	std::function<void(PluginInterface::TensorId)> cbTensorComputed,
@@ -0,0 +1,227 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "frame-pipeline.h"
+#include "image.h"
+#include "misc.h"
+#include "plugin-interface.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <assert.h>
+
+namespace FramePipeline {
+
+typedef PluginInterface PI;
+typedef std::chrono::steady_clock Clock;
+
+const char* stageName(Stage stage) {
+	switch (stage) {
+	case Stage_Decode:
+		return "decode";
+	case Stage_Effects:
+		return "effects";
+	case Stage_Preprocess:
+		return "preprocess";
+	case Stage_Inference:
+		return "inference";
+	case Stage_Postprocess:
+		return "postprocess";
+	case Stage_Count:
+		break;
+	}
+	assert(false);
+	return nullptr;
+}
+
+/// frames and queues between stages
+
+struct Frame {
+	unsigned                                             index; // in the list of files
+	std::shared_ptr<float>                               image;
+	TensorShape                                          imageShape;
+	std::map<PI::TensorId, std::shared_ptr<const float>> inputs;
+	std::vector<std::shared_ptr<const float>>            outputs; // copies of model outputs
+	Clock::time_point                                    startedAt;
+	FrameResult                                          result;
+};
+
+class Queue { // producers wait while it is full, consumers wait while it is empty
+	std::mutex                                   lock;
+	std::condition_variable                      changed;
+	std::deque<std::unique_ptr<Frame>>           frames;
+	size_t                                       capacity;
+	bool                                         closed;
+
+public:
+	Queue(size_t capacity_) : capacity(capacity_), closed(false) { }
+
+	void push(std::unique_ptr<Frame> frame) { // frames pushed after the queue is closed are dropped
+		std::unique_lock<std::mutex> l(lock);
+		changed.wait(l, [this]() {return frames.size() < capacity || closed;});
+		if (!closed)
+			frames.push_back(std::move(frame));
+		changed.notify_all();
+	}
+	std::unique_ptr<Frame> pop() { // returns nullptr when the queue is closed and empty
+		std::unique_lock<std::mutex> l(lock);
+		changed.wait(l, [this]() {return !frames.empty() || closed;});
+		if (frames.empty())
+			return nullptr;
+		auto frame = std::move(frames.front());
+		frames.pop_front();
+		changed.notify_all();
+		return frame;
+	}
+	void close() { // no more frames will come: consumers take remaining ones and finish, producers stop waiting
+		std::unique_lock<std::mutex> l(lock);
+		closed = true;
+		changed.notify_all();
+	}
+};
+
+/// run
+
+bool run(
+	const Compute::Plan &plan,
+	const std::vector<std::string> &files,
+	InputNormalization inputNormalization,
+	const Effects &effects,
+	unsigned queueSize,
+	unsigned numTop,
+	std::vector<FrameResult> &results,
+	std::function<void(const std::string&)> cbWarningMessage)
+{
+	assert(queueSize >= 1);
+	auto model = plan.model;
+	auto seconds = [](Clock::duration d) {
+		return std::chrono::duration<double>(d).count();
+	};
+	auto deleteImage = [](float *p) {
+		delete [] p;
+	};
+	bool haveEffects = effects.flipHorizontally || effects.flipVertically || effects.makeGrayscale || !std::get<1>(effects.convolution).empty();
+
+	// queues: files wait for decoding in the first one, results are collected from the last one
+	std::vector<std::unique_ptr<Queue>> queues;
+	for (unsigned q = 0; q <= Stage_Count; q++)
+		queues.emplace_back(new Queue(q == 0 || q == Stage_Count ? files.size() : queueSize));
+	for (unsigned i = 0, ie = files.size(); i < ie; i++)
+		queues[0]->push(std::unique_ptr<Frame>(new Frame{i}));
+	queues[0]->close();
+
+	// stages: any stage that fails stops all of them
+	std::atomic<bool> failed(false);
+	auto fail = [&]() {
+		failed = true;
+		for (auto &queue : queues)
+			queue->close();
+	};
+	auto work = [&](Stage stage, Frame &frame) -> bool {
+		switch (stage) {
+		case Stage_Decode:
+			frame.startedAt = Clock::now();
+			frame.result.file = files[frame.index];
+			try { // png++ throws on missing and corrupt files
+				frame.image.reset(Image::readPngImageFile(files[frame.index], frame.imageShape), deleteImage);
+			} catch (const std::exception &e) {
+				cbWarningMessage(STR("couldn't decode the frame '" << files[frame.index] << "': " << e.what()));
+				return false;
+			}
+			return true;
+		case Stage_Effects:
+			if (haveEffects)
+				frame.image.reset(Image::applyEffects(frame.image.get(), frame.imageShape,
+					effects.flipHorizontally, effects.flipVertically, effects.makeGrayscale,
+					effects.convolution, effects.convolutionCount), deleteImage);
+			return true;
+		case Stage_Preprocess: {
+			bool succ = Compute::buildComputeInputs(model,
+				{0,0, frame.imageShape[1]-1,frame.imageShape[0]-1}, inputNormalization,
+				frame.image, frame.imageShape,
+				frame.inputs,
+				[](PI::TensorId) { }, cbWarningMessage);
+			frame.image.reset();
+			if (!succ)
+				cbWarningMessage(STR("couldn't prepare inputs from the frame '" << files[frame.index] << "'"));
+			return succ;
+		} case Stage_Inference: {
+			// only copies of outputs leave the stage: tensorData that holds the arena is released, and the next run reuses the arena
+			std::unique_ptr<std::vector<std::shared_ptr<const float>>> tensorData(new std::vector<std::shared_ptr<const float>>(plan.numTensors));
+			Compute::fillInputs(frame.inputs, tensorData);
+			frame.inputs.clear();
+			if (!Compute::run(plan, tensorData, [](PI::TensorId) { }, cbWarningMessage))
+				return false;
+			for (auto tid : model->getOutputs()) {
+				auto size = Tensor::flatSize(plan.tensorShapes[tid]);
+				std::shared_ptr<float> output(new float[size], std::default_delete<float[]>());
+				std::copy((*tensorData)[tid].get(), (*tensorData)[tid].get() + size, output.get());
+				frame.outputs.push_back(output);
+			}
+			return true;
+		} case Stage_Postprocess: {
+			auto output = frame.outputs[0].get();
+			auto size = Tensor::flatSize(plan.tensorShapes[model->getOutputs()[0]]);
+			std::vector<unsigned> indexes(size);
+			for (unsigned i = 0; i < size; i++)
+				indexes[i] = i;
+			auto n = std::min((size_t)numTop, size);
+			std::partial_sort(indexes.begin(), indexes.begin() + n, indexes.end(), [output](unsigned a, unsigned b) {return output[a] > output[b];});
+			for (unsigned i = 0; i < n; i++)
+				frame.result.top.push_back({indexes[i], output[indexes[i]]});
+			frame.outputs.clear();
+			return true;
+		} case Stage_Count:
+			break;
+		}
+		assert(false);
+		return false;
+	};
+
+	// run every stage on its own thread, kernels of the inference split their work on the thread pool
+	auto tmStart = Clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned s = 0; s < Stage_Count; s++)
+		threads.push_back(std::thread([&,s]() {
+			auto &input = *queues[s], &output = *queues[s+1];
+			while (auto frame = input.pop()) {
+				if (failed)
+					break;
+				auto tmStage = Clock::now();
+				if (!work((Stage)s, *frame)) {
+					fail();
+					break;
+				}
+				auto tmDone = Clock::now();
+				frame->result.stageTimes[s] = seconds(tmDone - tmStage);
+				if (s == Stage_Postprocess) {
+					frame->result.latency = seconds(tmDone - frame->startedAt);
+					frame->result.finishedAt = seconds(tmDone - tmStart);
+				}
+				output.push(std::move(frame));
+			}
+			output.close();
+		}));
+	for (auto &thread : threads)
+		thread.join();
+	if (failed)
+		return false;
+
+	// collect results, stages keep the order of frames
+	results.clear();
+	while (auto frame = queues[Stage_Count]->pop())
+		results.push_back(frame->result);
+	assert(results.size() == files.size());
+
+	return true;
+}
+
+}
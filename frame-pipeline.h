@@ -0,0 +1,60 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "compute.h"
+#include "nn-types.h"
+#include "tensor.h"
+
+#include <array>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+//
+// FramePipeline: computes a sequence of frames (PNG images) with decoding, effects, preprocessing, inference and postprocessing
+//                as concurrent stages connected by bounded queues, so that decoding of the next frames overlaps the inference
+//
+
+namespace FramePipeline {
+
+enum Stage {
+	Stage_Decode,      // the PNG file is read
+	Stage_Effects,     // effects are applied to the image, like in the GUI
+	Stage_Preprocess,  // the image is converted into model inputs
+	Stage_Inference,   // the model is computed
+	Stage_Postprocess, // top classes are found in the first model output
+	Stage_Count
+};
+
+const char* stageName(Stage stage);
+
+struct Effects { // see Image::applyEffects
+	bool                                        flipHorizontally = false;
+	bool                                        flipVertically = false;
+	bool                                        makeGrayscale = false;
+	std::tuple<TensorShape,std::vector<float>>  convolution; // no convolution when it is empty
+	unsigned                                    convolutionCount = 0;
+};
+
+struct FrameResult {
+	std::string                                 file;
+	std::vector<std::tuple<unsigned,float>>     top;        // largest values of the first model output with their indexes, largest first
+	std::array<double,Stage_Count>              stageTimes; // seconds that every stage worked on the frame
+	double                                      latency;    // seconds from the beginning of decoding to the end of postprocessing
+	double                                      finishedAt; // seconds from the start of the pipeline
+};
+
+bool run(
+	const Compute::Plan &plan, // the plan shouldn't keep intermediates: outputs are copied out of it
+	const std::vector<std::string> &files,
+	InputNormalization inputNormalization,
+	const Effects &effects,
+	unsigned queueSize, // frames that can wait between two consecutive stages
+	unsigned numTop,    // classes that postprocessing finds
+	std::vector<FrameResult> &results, // output: results of computed frames, in the order of files
+	std::function<void(const std::string&)> cbWarningMessage // it is called on threads of stages
+);
+
+}
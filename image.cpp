@@ -1,6 +1,7 @@
 // Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
 
 #include "image.h"
+#include "nn-operators.h"
 #include "tensor.h"
 #include "misc.h"
 #include "util.h"
@@ -16,6 +17,8 @@
 #include <memory>
 #include <cstring>
 #include <functional>
+#include <tuple>
+#include <vector>
 
 #include <assert.h>
 
@@ -173,4 +176,65 @@ void makeGrayscale(const TensorShape &shape, const float *imgSrc, float *imgDst)
 		imgDst[0] = imgDst[1] = imgDst[2] = convertColor(imgSrc[0], imgSrc[1], imgSrc[2]);
 }
 
+float* applyEffects(const float *image, const TensorShape &shape,
+	bool flipHorizontally, bool flipVertically, bool makeGrayscale,
+	const std::tuple<TensorShape,std::vector<float>> &convolution, unsigned convolutionCount)
+{
+	assert(shape.size()==3);
+	assert(flipHorizontally || flipVertically || makeGrayscale || !std::get<1>(convolution).empty());
+
+	unsigned idx = 0; // idx=0 is "image", idx can be 0,1,2
+	std::unique_ptr<float> withEffects[2]; // idx=1 and idx=2 are allocatable "images"
+
+	auto idxNext = [](unsigned idx) {
+		return (idx+1)<3 ? idx+1 : 1;
+	};
+	auto src = [&](unsigned idx) {
+		if (idx==0)
+			return image;
+		else
+			return (const float*)withEffects[idx-1].get();
+	};
+	auto dst = [&](unsigned idx) {
+		auto &we = withEffects[idxNext(idx)-1];
+		if (!we)
+			we.reset(new float[Tensor::flatSize(shape)]);
+		return we.get();
+	};
+
+	if (flipHorizontally) {
+		Image::flipHorizontally(shape, src(idx), dst(idx));
+		idx = idxNext(idx);
+	}
+	if (flipVertically) {
+		Image::flipVertically(shape, src(idx), dst(idx));
+		idx = idxNext(idx);
+	}
+	if (makeGrayscale) {
+		Image::makeGrayscale(shape, src(idx), dst(idx));
+		idx = idxNext(idx);
+	}
+	if (!std::get<1>(convolution).empty()) {
+		TensorShape shapeWithBatch = shape;
+		shapeWithBatch.insert(shapeWithBatch.begin(), 1/*batch*/);
+		const static float bias[3] = {0,0,0};
+		for (unsigned i = 1; i <= convolutionCount; i++) {
+			float *d = dst(idx);
+			NnOperators::Conv2D(
+				shapeWithBatch, src(idx),
+				std::get<0>(convolution), std::get<1>(convolution).data(),
+				{3}, bias, // no bias
+				shapeWithBatch, d,
+				std::get<0>(convolution)[2]/2, std::get<0>(convolution)[1]/2, // padding, paddings not matching kernel size work but cause image shifts
+				1,1, // strides
+				1,1, // dilation factors
+				Kernels::Activation::clamp(0, 255) // we have to clip the result because otherwise some values are out of range 0..255.
+			);
+			idx = idxNext(idx);
+		}
+	}
+
+	return withEffects[idx-1].release();
+}
+
 }
@@ -10,6 +10,8 @@
 #include <string>
 #include <array>
 #include <functional>
+#include <tuple>
+#include <vector>
 
 namespace Image {
 
@@ -22,5 +24,8 @@ QPixmap toQPixmap(const float *image, const TensorShape &shape);
 void flipHorizontally(const TensorShape &shape, const float *imgSrc, float *imgDst);
 void flipVertically(const TensorShape &shape, const float *imgSrc, float *imgDst);
 void makeGrayscale(const TensorShape &shape, const float *imgSrc, float *imgDst);
+float* applyEffects(const float *image, const TensorShape &shape, // returns a new image with effects applied in this order
+	bool flipHorizontally, bool flipVertically, bool makeGrayscale,
+	const std::tuple<TensorShape,std::vector<float>> &convolution, unsigned convolutionCount);
 
 }
@@ -29,7 +29,7 @@ void InMemoryModel::removeOutput(PI::TensorId tid) {
 PI::TensorId InMemoryModel::addTensor(const std::string &name, TensorShape shape, PI::DataType type, uint8_t *staticTensorData) { // staticTensorData ownership is passed
 	PI::TensorId tid = tensors.size();
 
-	tensors.push_back(TensorInfo{name, shape, type, std::shared_ptr<uint8_t>(staticTensorData)});
+	tensors.push_back(TensorInfo{name, shape, type, std::shared_ptr<uint8_t>(staticTensorData), {}});
 
 	return tid;
 }
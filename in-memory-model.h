@@ -18,6 +18,7 @@ class InMemoryModel : public PluginInterface::Model {
 		TensorShape                                shape;
 		PI::DataType                               type;
 		std::shared_ptr<uint8_t>                   staticTensorData;
+		PI::TensorQuantization                     quantization; // no scales when the tensor isn't quantized
 	};
 	struct OperatorInfo {
 		PI::OperatorKind                           kind;
@@ -32,6 +33,7 @@ class InMemoryModel : public PluginInterface::Model {
 	std::vector<OperatorInfo>           operators;
 
 public:
+	InMemoryModel() { } // an empty model, it is built through the iface for changing the model
 	InMemoryModel(const PI::Model *other)
 	: inputs(other->getInputs())
 	, outputs(other->getOutputs())
@@ -55,7 +57,7 @@ public:
 			}}
 		};
 		tensors.reserve(other->numTensors());
-		for (PI::TensorId t = 0, te=other->numTensors(); t < te; t++)
+		for (PI::TensorId t = 0, te=other->numTensors(); t < te; t++) {
 			tensors.push_back({
 				other->getTensorName(t),
 				other->getTensorShape(t),
@@ -63,8 +65,12 @@ public:
 				other->getTensorHasData(t) ?
 					std::shared_ptr<uint8_t>(copyTensorData(other->getTensorShape(t), other->getTensorType(t), other->getTensorData(t)))
 					:
-					std::shared_ptr<uint8_t>()
+					std::shared_ptr<uint8_t>(),
+				{}
 			});
+			if (!other->getTensorQuantization(t, tensors.rbegin()->quantization))
+				tensors.rbegin()->quantization = {};
+		}
 
 		// copy operators
 		operators.reserve(other->numOperators());
@@ -132,6 +138,12 @@ public: // interface implementation
 	bool getTensorIsVariableFlag(PI::TensorId tensorId) const override {
 		return false; // TODO?
 	}
+	bool getTensorQuantization(PI::TensorId tensorId, PI::TensorQuantization &quantization) const override {
+		if (tensors[tensorId].quantization.scales.empty())
+			return false;
+		quantization = tensors[tensorId].quantization;
+		return true;
+	}
 
 public: // iface for changing the model
 	void addInput(PI::TensorId tid);
@@ -0,0 +1,70 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "simd.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+//
+// activation: fused activation functions, kernels apply them to values that they store for the last time
+//             instead of making another pass over the output
+//
+
+namespace Kernels {
+
+struct Activation {
+	enum Kind {None, Clamp, Tanh, SignBit};
+
+	Kind  kind = None;
+	float min = -std::numeric_limits<float>::infinity(); // Clamp: RELU is [0,inf), RELU6 is [0,6], RELU_N1_TO_1 is [-1,1]
+	float max = std::numeric_limits<float>::infinity();
+
+	static Activation clamp(float min, float max) {return {Clamp, min, max};}
+	static Activation tanh() {return {Tanh};}
+	static Activation signBit() {return {SignBit};}
+
+	bool isNone() const {return kind == None;}
+
+	float operator()(float v) const {
+		switch (kind) {
+		case None:
+			return v;
+		case Clamp: // like if-statements: NaN stays NaN
+			return v < min ? min : v > max ? max : v;
+		case Tanh:
+			return std::tanh(v);
+		case SignBit:
+			return std::signbit(v) ? 1 : 0;
+		}
+		return v;
+	}
+	Simd::Vec operator()(Simd::Vec v) const {
+		switch (kind) {
+		case None:
+			return v;
+		case Clamp:
+			v = v < min ? Simd::broadcast(min) : v;
+			return v > max ? Simd::broadcast(max) : v;
+		default: // not vectorized
+			for (unsigned i = 0; i < Simd::Width; i++)
+				v[i] = (*this)(float(v[i]));
+			return v;
+		}
+	}
+
+	// applies to values that were just stored and are still in cache, for kernels that can't apply it when they store them
+	void apply(float *data, size_t size) const {
+		if (kind == None)
+			return;
+		size_t i = 0;
+		for (; i + Simd::Width <= size; i += Simd::Width)
+			Simd::store(data + i, (*this)(Simd::load(data + i)));
+		for (; i < size; i++)
+			data[i] = (*this)(data[i]);
+	}
+};
+
+}
@@ -0,0 +1,140 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "conv.h"
+#include "gemm.h"
+
+#include "../thread-pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <assert.h>
+
+namespace Kernels {
+
+static const unsigned BlockPixels = 288; // output pixels gathered into one im2col block, a multiple of Gemm::MR
+static const size_t MinWorkPerSlice = 32*1024; // multiply-adds
+
+// gathers the patch of input pixels that the output pixel (oy,ox) sees into one row of K=KH*KW*I values
+static void im2colRow(
+	const float *input, int H, int W, int I,
+	int KH, int KW,
+	int iy0, int ix0, // input coordinates of the patch origin, can be negative due to padding
+	int dilationH, int dilationW,
+	float *row
+) {
+	for (int ky = 0; ky < KH; ky++) {
+		auto iy = iy0 + ky*dilationH;
+		if (iy < 0 || iy >= H) {
+			std::fill(row, row + KW*I, 0);
+			row += KW*I;
+			continue;
+		}
+		auto inputRow = input + (size_t)iy*W*I;
+		if (dilationW == 1 && ix0 >= 0 && ix0 + KW <= W) { // the whole patch row is inside the input
+			std::memcpy(row, inputRow + ix0*I, KW*I*sizeof(float));
+			row += KW*I;
+			continue;
+		}
+		for (int kx = 0; kx < KW; kx++, row += I) {
+			auto ix = ix0 + kx*dilationW;
+			if (ix < 0 || ix >= W)
+				std::fill(row, row + I, 0);
+			else
+				std::memcpy(row, inputRow + ix*I, I*sizeof(float));
+		}
+	}
+}
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const Gemm::PackedWeights &weights,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Activation &activation,
+	unsigned outputStride
+) {
+	assert(inputShape.size()==4 && filterShape.size()==4 && outputShape.size()==4);
+	assert(inputShape[0]==outputShape[0] && inputShape[3]==filterShape[3] && filterShape[0]==outputShape[3]);
+	assert(!biasData || (biasShape.size()==1 && biasShape[0]==outputShape[3]));
+
+	unsigned H = inputShape[1], W = inputShape[2], I = inputShape[3];
+	unsigned KH = filterShape[1], KW = filterShape[2];
+	unsigned OH = outputShape[1], OW = outputShape[2], O = outputShape[3];
+	unsigned K = KH*KW*I;
+	if (outputStride == 0)
+		outputStride = O;
+	assert(outputStride >= O);
+
+	assert(weights.N==O && weights.K==K);
+
+	bool pointwise = KH==1 && KW==1 && paddingWidth==0 && paddingHeight==0;
+
+	auto numPixels = outputShape[0]*OH*OW;
+	auto grain = std::max((size_t)Gemm::MR, MinWorkPerSlice/std::max((size_t)O*K, (size_t)1));
+	ThreadPool::parallelFor(numPixels, grain, [&](size_t begin, size_t end) {
+		thread_local std::vector<float> im2col;
+		if (!pointwise)
+			im2col.resize((size_t)BlockPixels*K);
+
+		const float* rows[BlockPixels];
+		for (auto p0 = begin; p0 < end; p0 += BlockPixels) {
+			auto p1 = std::min(end, p0 + BlockPixels);
+			for (auto p = p0; p < p1; p++) {
+				unsigned b = p/(OH*OW), oy = p/OW%OH, ox = p%OW;
+				auto input = inputData + (size_t)b*H*W*I;
+				if (pointwise) {
+					rows[p - p0] = input + ((size_t)oy*strideHeight*W + ox*strideWidth)*I;
+				} else {
+					auto row = im2col.data() + (p - p0)*K;
+					im2colRow(input, H, W, I, KH, KW,
+						(int)(oy*strideHeight) - (int)paddingHeight, (int)(ox*strideWidth) - (int)paddingWidth,
+						dilationHeightFactor, dilationWidthFactor,
+						row);
+					rows[p - p0] = row;
+				}
+			}
+			Gemm::multiply(p1 - p0, rows, weights, biasData, outputData + p0*outputStride, outputStride, activation);
+		}
+	});
+}
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Activation &activation,
+	unsigned outputStride
+) {
+	Gemm::PackedWeights weights;
+	Gemm::packWeights(filterData, filterShape[0], Tensor::sizeBetweenDims(filterShape, 1, 3), weights);
+	Conv2D(inputShape, inputData, filterShape, weights, biasShape, biasData, outputShape, outputData,
+		paddingWidth, paddingHeight, strideWidth, strideHeight, dilationWidthFactor, dilationHeightFactor, activation, outputStride);
+}
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Activation &activation,
+	unsigned outputStride
+) {
+	Gemm::PackedWeights weights;
+	Gemm::packWeights(filterData, filterShape[0], Tensor::sizeBetweenDims(filterShape, 1, 3), weights);
+	Conv2D(inputShape, inputData, filterShape, weights, biasShape, biasData, outputShape, outputData,
+		paddingWidth, paddingHeight, strideWidth, strideHeight, dilationWidthFactor, dilationHeightFactor, activation, outputStride);
+}
+
+}
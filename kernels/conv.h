@@ -0,0 +1,59 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "activation.h"
+#include "gemm.h"
+
+#include "../tensor.h"
+
+#include <half.hpp>
+
+//
+// conv: convolution as a matrix multiplication (implicit GEMM)
+//       output pixels are rows, output channels are columns, the filter is the weights matrix [O][KH*KW*I]
+//
+
+namespace Kernels {
+
+// pointwise (1x1, no padding) convolutions multiply input pixels in place, others gather pixel patches into rows (im2col) first
+// outputStride is the distance between output pixels in floats when the output is a part of a wider tensor, 0 when they are packed
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Activation &activation,
+	unsigned outputStride = 0
+);
+
+// float16 filters are widened while they are packed
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Activation &activation,
+	unsigned outputStride = 0
+);
+
+// the filter was packed by Gemm::packWeights as the [O][KH*KW*I] matrix: callers that keep it pack it only once
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const Gemm::PackedWeights &filter,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Activation &activation,
+	unsigned outputStride = 0
+);
+
+}
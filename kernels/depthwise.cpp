@@ -0,0 +1,138 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "depthwise.h"
+#include "simd.h"
+
+#include "../thread-pool.h"
+
+#include <algorithm>
+
+#include <assert.h>
+
+namespace Kernels {
+
+namespace Depthwise {
+
+using namespace Simd;
+
+static const size_t MinWorkPerSlice = 32*1024; // multiply-adds
+
+// Every channel sums its taps in the same order as the reference implementation does (row by row, skipping
+// taps outside of the input), and then adds the bias, so results are identical to the reference ones.
+// The activation is applied to the sums before they are stored.
+
+// border pixels: only taps [ky0,ky1)x[kx0,kx1) of the KxK filter at the input position (iy0,ix0) are inside of the input
+template<unsigned K>
+static void borderPixel(const float *input, unsigned W, unsigned C, const float *filter, const float *bias, const Activation &activation,
+                        int iy0, int ix0, unsigned ky0, unsigned ky1, unsigned kx0, unsigned kx1, float *output) {
+	auto tapInput = [=](unsigned ky, unsigned kx) {return input + ((size_t)(iy0 + (int)ky)*W + (ix0 + (int)kx))*C;};
+	unsigned c = 0;
+	for (; c + Width <= C; c += Width) {
+		Vec acc{};
+		for (unsigned ky = ky0; ky < ky1; ky++)
+			for (unsigned kx = kx0; kx < kx1; kx++)
+				acc += load(tapInput(ky, kx) + c)*load(filter + (ky*K + kx)*C + c);
+		store(output + c, activation(acc + (bias ? load(bias + c) : Vec{})));
+	}
+	for (; c < C; c++) { // remaining channels
+		float acc = 0;
+		for (unsigned ky = ky0; ky < ky1; ky++)
+			for (unsigned kx = kx0; kx < kx1; kx++)
+				acc += tapInput(ky, kx)[c]*filter[(ky*K + kx)*C + c];
+		output[c] = activation(acc + (bias ? bias[c] : 0.f));
+	}
+}
+
+// interior pixels: all KxK taps starting at 'input' are inside of the input, the loops are fully unrolled
+template<unsigned K>
+static void interiorPixel(const float *input, unsigned W, unsigned C, const float *filter, const float *bias, const Activation &activation,
+                          float *output) {
+	unsigned c = 0;
+	for (; c + Width <= C; c += Width) {
+		Vec acc{};
+		#pragma GCC unroll 25
+		for (unsigned tap = 0; tap < K*K; tap++)
+			acc += load(input + (tap/K*W + tap%K)*C + c)*load(filter + tap*C + c);
+		store(output + c, activation(acc + (bias ? load(bias + c) : Vec{})));
+	}
+	for (; c < C; c++) { // remaining channels
+		float acc = 0;
+		for (unsigned tap = 0; tap < K*K; tap++)
+			acc += input[(tap/K*W + tap%K)*C + c]*filter[tap*C + c];
+		output[c] = activation(acc + (bias ? bias[c] : 0.f));
+	}
+}
+
+template<unsigned K, unsigned S>
+static void outputRow(
+	const float *input, int H, int W, unsigned C,
+	const float *filter, const float *bias, const Activation &activation,
+	float *output, int oy, unsigned OW,
+	int paddingWidth, int paddingHeight
+) {
+	int iy0 = oy*S - paddingHeight;
+	unsigned ky0 = std::clamp(-iy0, 0, (int)K), ky1 = std::clamp(H - iy0, 0, (int)K);
+	bool interiorRow = ky0 == 0 && ky1 == K;
+
+	for (unsigned ox = 0; ox < OW; ox++, output += C) {
+		int ix0 = ox*S - paddingWidth;
+		if (interiorRow && ix0 >= 0 && ix0 + (int)K <= W)
+			interiorPixel<K>(input + ((size_t)iy0*W + ix0)*C, W, C, filter, bias, activation, output);
+		else
+			borderPixel<K>(input, W, C, filter, bias, activation, iy0, ix0,
+				ky0, ky1, std::clamp(-ix0, 0, (int)K), std::clamp(W - ix0, 0, (int)K), output);
+	}
+}
+
+template<unsigned K, unsigned S>
+static void convolve(
+	const TensorShape &inputShape, const float *inputData,
+	const float *filterData, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	const Activation &activation
+) {
+	unsigned H = inputShape[1], W = inputShape[2], C = inputShape[3];
+	unsigned OH = outputShape[1], OW = outputShape[2];
+
+	ThreadPool::parallelFor(outputShape[0]*OH, std::max(MinWorkPerSlice/((size_t)OW*C*K*K), (size_t)1), [&](size_t begin, size_t end) {
+		for (auto row = begin; row < end; row++) {
+			unsigned b = row/OH, oy = row%OH;
+			outputRow<K,S>(inputData + (size_t)b*H*W*C, H, W, C, filterData, biasData, activation,
+				outputData + row*OW*C, oy, OW, paddingWidth, paddingHeight);
+		}
+	});
+}
+
+bool applicable(
+	const TensorShape &filterShape,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	unsigned depthMultiplier
+) {
+	return filterShape.size()==4 && filterShape[0]==1 && filterShape[1]==filterShape[2] && (filterShape[1]==3 || filterShape[1]==5) &&
+		strideWidth==strideHeight && (strideWidth==1 || strideWidth==2) &&
+		dilationWidthFactor==1 && dilationHeightFactor==1 &&
+		depthMultiplier==1;
+}
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	const Activation &activation
+) {
+	assert(applicable(filterShape, strideWidth, strideHeight, 1, 1, 1));
+	assert(inputShape.size()==4 && outputShape.size()==4);
+	assert(inputShape[0]==outputShape[0] && inputShape[3]==filterShape[3] && outputShape[3]==filterShape[3]);
+
+	auto fn = filterShape[1]==3 ? (strideWidth==1 ? convolve<3,1> : convolve<3,2>) : (strideWidth==1 ? convolve<5,1> : convolve<5,2>);
+	fn(inputShape, inputData, filterData, biasData, outputShape, outputData, paddingWidth, paddingHeight, activation);
+}
+
+}
+
+}
@@ -0,0 +1,37 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "activation.h"
+
+#include "../tensor.h"
+
+//
+// depthwise: DepthwiseConv2D for the common MobileNet layers: 3x3 and 5x5 filters, strides 1 and 2, depth multiplier 1
+//            channels are vectorized, interior pixels are computed without bounds checks
+//
+
+namespace Kernels {
+
+namespace Depthwise {
+
+bool applicable(
+	const TensorShape &filterShape,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	unsigned depthMultiplier
+);
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	const Activation &activation
+);
+
+}
+
+}
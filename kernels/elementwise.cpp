@@ -0,0 +1,192 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "elementwise.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+
+namespace Kernels {
+
+namespace Elementwise {
+
+using namespace Simd;
+
+// the operator, for scalars and for vectors
+template<Op op, typename T>
+static inline T apply(T a, T b) {
+	if constexpr (op == Add)
+		return a + b;
+	else if constexpr (op == Sub)
+		return a - b;
+	else if constexpr (op == Mul)
+		return a*b;
+	else if constexpr (op == Div)
+		return a/b;
+	else if constexpr (op == Maximum) // like std::max
+		return a < b ? b : a;
+	else if constexpr (op == Minimum) // like std::min
+		return b < a ? b : a;
+	else if constexpr (op == SquaredDifference)
+		return (a - b)*(a - b);
+}
+
+struct NoActivation {
+	float operator()(float v) const {return v;}
+	Vec operator()(Vec v) const {return v;}
+};
+
+// innermost dimension: Step1 and Step2 are the strides of the inputs, 0 (repeated value) or 1
+template<Op op, unsigned Step1, unsigned Step2, class Act>
+static void innerLoop(const float *input1, const float *input2, float *output, size_t size, const Act &activation) {
+	static_assert(Step1 <= 1 && Step2 <= 1);
+	size_t i = 0;
+	for (; i + Width <= size; i += Width)
+		store(output + i, activation(apply<op,Vec>(Step1 ? load(input1 + i) : broadcast(*input1),
+		                                           Step2 ? load(input2 + i) : broadcast(*input2))));
+	for (; i < size; i++)
+		output[i] = activation(apply<op,float>(input1[Step1*i], input2[Step2*i]));
+}
+
+template<Op op, class Act>
+static void computeLoops(
+	const std::vector<size_t> &dims, const std::vector<size_t> &strides1, const std::vector<size_t> &strides2,
+	const float *input1, const float *input2, float *output,
+	const Act &activation)
+{
+	auto rank = dims.size();
+	assert(rank >= 1);
+
+	// choose the inner loop by the innermost strides
+	auto inner = strides1[rank-1] ? (strides2[rank-1] ? innerLoop<op,1,1,Act> : innerLoop<op,1,0,Act>)
+	                              : (strides2[rank-1] ? innerLoop<op,0,1,Act> : innerLoop<op,0,0,Act>);
+	auto innerSize = dims[rank-1];
+
+	// iterate over the outer dimensions like an odometer
+	std::vector<size_t> index(rank, 0);
+	size_t offset1 = 0, offset2 = 0;
+	while (true) {
+		inner(input1 + offset1, input2 + offset2, output, innerSize, activation);
+		output += innerSize;
+
+		int d = (int)rank - 2;
+		for (; d >= 0; d--) {
+			offset1 += strides1[d];
+			offset2 += strides2[d];
+			if (++index[d] < dims[d])
+				break;
+			offset1 -= strides1[d]*dims[d];
+			offset2 -= strides2[d]*dims[d];
+			index[d] = 0;
+		}
+		if (d < 0)
+			return;
+	}
+}
+
+template<Op op>
+static void computeOp(
+	const std::vector<size_t> &dims, const std::vector<size_t> &strides1, const std::vector<size_t> &strides2,
+	const float *input1, const float *input2, float *output,
+	const Activation &activation)
+{
+	if (activation.isNone()) // without the activation function the loops are simpler
+		computeLoops<op>(dims, strides1, strides2, input1, input2, output, NoActivation());
+	else
+		computeLoops<op>(dims, strides1, strides2, input1, input2, output, activation);
+}
+
+bool broadcastShape(const TensorShape &shape1, const TensorShape &shape2, TensorShape &outputShape) {
+	auto rank = std::max(shape1.size(), shape2.size());
+	outputShape.resize(rank);
+	for (unsigned d = 0; d < rank; d++) { // from the right
+		auto dim1 = d < shape1.size() ? shape1[shape1.size()-1-d] : 1;
+		auto dim2 = d < shape2.size() ? shape2[shape2.size()-1-d] : 1;
+		if (dim1 != dim2 && dim1 != 1 && dim2 != 1)
+			return false;
+		outputShape[rank-1-d] = dim1 == 1 ? dim2 : dim1;
+	}
+	return true;
+}
+
+bool compute(
+	Op op,
+	const TensorShape &shape1, const float *input1,
+	const TensorShape &shape2, const float *input2,
+	const TensorShape &outputShape, float *output,
+	const Activation &activation)
+{
+	// the output shape should be what the inputs broadcast to
+	TensorShape broadcasted;
+	if (!broadcastShape(shape1, shape2, broadcasted) || Tensor::flatSize(broadcasted) != Tensor::flatSize(outputShape))
+		return false;
+
+	// strides of inputs along the output dimensions, 0 along the repeated dimensions, dimensions of size 1 are dropped
+	std::vector<size_t> dims, strides1, strides2;
+	size_t stride1 = 1, stride2 = 1;
+	for (int d = (int)broadcasted.size() - 1; d >= 0; d--) {
+		auto dim = broadcasted[d];
+		auto r = broadcasted.size() - 1 - d; // from the right
+		auto dim1 = r < shape1.size() ? shape1[shape1.size()-1-r] : 1;
+		auto dim2 = r < shape2.size() ? shape2[shape2.size()-1-r] : 1;
+		if (dim == 1)
+			continue;
+		dims.insert(dims.begin(), dim);
+		strides1.insert(strides1.begin(), dim1 == 1 ? 0 : stride1);
+		strides2.insert(strides2.begin(), dim2 == 1 ? 0 : stride2);
+		stride1 *= dim1;
+		stride2 *= dim2;
+	}
+	if (dims.empty()) { // scalars
+		dims.push_back(1);
+		strides1.push_back(0);
+		strides2.push_back(0);
+	}
+
+	// collapse dimensions that are contiguous with the next one in both inputs
+	for (size_t d = dims.size() - 1; d > 0; d--) {
+		auto contiguous = [&](const std::vector<size_t> &strides) {
+			return strides[d-1] == strides[d]*dims[d]; // also when both are repeated
+		};
+		if (contiguous(strides1) && contiguous(strides2)) {
+			dims[d-1] *= dims[d];
+			strides1[d-1] = strides1[d];
+			strides2[d-1] = strides2[d];
+			dims.erase(dims.begin() + d);
+			strides1.erase(strides1.begin() + d);
+			strides2.erase(strides2.begin() + d);
+		}
+	}
+
+	// compute
+	switch (op) {
+	case Add:
+		computeOp<Add>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	case Sub:
+		computeOp<Sub>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	case Mul:
+		computeOp<Mul>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	case Div:
+		computeOp<Div>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	case Maximum:
+		computeOp<Maximum>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	case Minimum:
+		computeOp<Minimum>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	case SquaredDifference:
+		computeOp<SquaredDifference>(dims, strides1, strides2, input1, input2, output, activation);
+		return true;
+	}
+	return false;
+}
+
+}
+
+}
@@ -0,0 +1,35 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "activation.h"
+
+#include "../tensor.h"
+
+//
+// elementwise: binary operators with NumPy-style broadcasting: shapes are aligned on the right, and dimensions
+//              of size 1 are repeated. Dimensions that are contiguous in both inputs are collapsed, and the innermost
+//              dimension is computed by a vectorized loop specialized for the operator and the input strides.
+//
+
+namespace Kernels {
+
+namespace Elementwise {
+
+enum Op {Add, Sub, Mul, Div, Maximum, Minimum, SquaredDifference};
+
+// the shape that two shapes broadcast to, returns false when they don't broadcast
+bool broadcastShape(const TensorShape &shape1, const TensorShape &shape2, TensorShape &outputShape);
+
+// returns false when the input shapes don't broadcast to the output shape
+bool compute(
+	Op op,
+	const TensorShape &shape1, const float *input1,
+	const TensorShape &shape2, const float *input2,
+	const TensorShape &outputShape, float *output,
+	const Activation &activation
+);
+
+}
+
+}
@@ -0,0 +1,125 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "fully-connected.h"
+#include "simd.h"
+
+#include "../thread-pool.h"
+
+#include <algorithm>
+
+#include <assert.h>
+
+namespace Kernels {
+
+using namespace Simd;
+
+constexpr unsigned RowsPerPass = 4;     // output channels (weight rows) that share the loaded input vectors
+constexpr unsigned BatchesPerPass = 2;  // batches that share the loaded weight vectors
+constexpr unsigned KC = 512;            // weights of RowsPerPass rows in a K-slice stay in L1 while all batches use them
+static const size_t MinWorkPerSlice = 32*1024; // multiply-adds
+
+static float sum(Vec v) {
+	float s = 0;
+	for (unsigned i = 0; i < Width; i++)
+		s += v[i];
+	return s;
+}
+
+// weights are float32, or float16 that is widened in registers: only half of the bytes is streamed from memory
+static Vec loadWeights(const float *p) {return load(p);}
+static Vec loadWeights(const half_float::half *p) {return loadWidened(p);}
+
+// adds dot products of R weight rows and B input rows over [k0,k1) to the outputs
+template<unsigned R, unsigned B, typename W>
+static void dotProducts(const W *weights, const float *input, unsigned K, unsigned N, unsigned k0, unsigned k1, float *output) {
+	Vec acc[B][R] = {};
+	unsigned k = k0;
+	for (; k + Width <= k1; k += Width) {
+		Vec w[R];
+		for (unsigned r = 0; r < R; r++)
+			w[r] = loadWeights(weights + (size_t)r*K + k);
+		for (unsigned b = 0; b < B; b++) {
+			auto x = load(input + (size_t)b*K + k);
+			for (unsigned r = 0; r < R; r++)
+				acc[b][r] += x*w[r];
+		}
+	}
+	for (unsigned b = 0; b < B; b++)
+		for (unsigned r = 0; r < R; r++) {
+			auto s = sum(acc[b][r]);
+			for (unsigned kk = k; kk < k1; kk++) // remaining elements
+				s += input[(size_t)b*K + kk]*(float)weights[(size_t)r*K + kk];
+			output[(size_t)b*N + r] += s;
+		}
+}
+
+template<unsigned R, typename W>
+static void rowGroup(const W *weights, const float *inputData, unsigned batches, unsigned K, unsigned N, float *output) {
+	for (unsigned k0 = 0; k0 < K; k0 += KC) {
+		auto k1 = std::min(K, k0 + KC);
+		unsigned b = 0;
+		for (; b + BatchesPerPass <= batches; b += BatchesPerPass)
+			dotProducts<R,BatchesPerPass>(weights, inputData + (size_t)b*K, K, N, k0, k1, output + (size_t)b*N);
+		for (; b < batches; b++)
+			dotProducts<R,1>(weights, inputData + (size_t)b*K, K, N, k0, k1, output + (size_t)b*N);
+	}
+}
+
+template<typename W>
+static void compute(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const W *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Activation &activation
+) {
+	unsigned N = *outputShape.rbegin();
+	unsigned K = *filterShape.rbegin();
+	unsigned batches = Tensor::flatSize(outputShape)/N;
+	assert(filterShape.size()==2 && filterShape[0]==N);
+	assert(Tensor::flatSize(inputShape)==(size_t)batches*K);
+	assert(!biasData || Tensor::flatSize(biasShape)==N);
+
+	// output channels are split between threads: each thread reads its own part of the weights
+	ThreadPool::parallelFor(N, std::max(MinWorkPerSlice/((size_t)batches*K), (size_t)RowsPerPass), [&](size_t begin, size_t end) {
+		for (unsigned b = 0; b < batches; b++)
+			for (auto n = begin; n < end; n++)
+				outputData[(size_t)b*N + n] = 0;
+
+		auto n = begin;
+		for (; n + RowsPerPass <= end; n += RowsPerPass)
+			rowGroup<RowsPerPass>(filterData + n*K, inputData, batches, K, N, outputData + n);
+		for (; n < end; n++)
+			rowGroup<1>(filterData + n*K, inputData, batches, K, N, outputData + n);
+
+		// bias and activation while this slice of the output is in cache
+		if (biasData || !activation.isNone())
+			for (unsigned b = 0; b < batches; b++)
+				for (auto n = begin; n < end; n++) {
+					auto &out = outputData[(size_t)b*N + n];
+					out = activation(biasData ? out + biasData[n] : out);
+				}
+	});
+}
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Activation &activation
+) {
+	compute(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData, activation);
+}
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Activation &activation
+) {
+	compute(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData, activation);
+}
+
+}
@@ -0,0 +1,35 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "activation.h"
+
+#include "../tensor.h"
+
+#include <half.hpp>
+
+//
+// fully-connected: FullyConnected that streams the weights once per call: several output channels are computed per pass
+//                  over the input, and all batches are computed per pass over a block of weights
+//                  weights can be float16: they are widened as they are loaded, which halves their memory and bandwidth
+//
+
+namespace Kernels {
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Activation &activation
+);
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Activation &activation
+);
+
+}
@@ -0,0 +1,134 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "gemm.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <assert.h>
+
+namespace Kernels {
+
+namespace Gemm {
+
+using namespace Simd;
+
+static_assert(NR % Width == 0);
+constexpr unsigned NV = NR/Width; // vectors in one row of the micro-tile
+
+constexpr unsigned KC = 256; // K-slice: MR rows of A and an NR-wide panel slice of the weights stay in L1
+constexpr unsigned MC = 72;  // rows of A that are multiplied by all panels in one K-slice, they stay in L2
+
+// computes the RxNR tile of C for the K-slice [k0,k1), adds to what C already has unless it is the first slice,
+// the activation is only given for the last slice
+template<unsigned R>
+static void microKernel(const float* const *aRows, const float *panel, unsigned k0, unsigned k1, const float *bias, const Activation *activation,
+                        float *c, unsigned ldc, unsigned cols) {
+	// columns past the end of C are computed in the local tile
+	float tile[R][NR];
+	bool partial = cols < NR;
+	auto cRow = [&](unsigned r) {return partial ? tile[r] : c + (size_t)r*ldc;};
+	if (partial && k0 != 0)
+		for (unsigned r = 0; r < R; r++)
+			std::memcpy(tile[r], c + (size_t)r*ldc, cols*sizeof(float));
+
+	Vec acc[R][NV];
+	for (unsigned r = 0; r < R; r++)
+		for (unsigned v = 0; v < NV; v++)
+			acc[r][v] = k0 == 0 ? (bias ? load(bias + v*Width) : Vec{}) : load(cRow(r) + v*Width);
+
+	const float *a[R];
+	for (unsigned r = 0; r < R; r++)
+		a[r] = aRows[r];
+
+	panel += (size_t)k0*NR;
+	for (unsigned k = k0; k < k1; k++, panel += NR) {
+		Vec b[NV];
+		for (unsigned v = 0; v < NV; v++)
+			b[v] = load(panel + v*Width);
+		for (unsigned r = 0; r < R; r++) {
+			auto ar = broadcast(a[r][k]);
+			for (unsigned v = 0; v < NV; v++)
+				acc[r][v] += ar*b[v];
+		}
+	}
+
+	if (activation)
+		for (unsigned r = 0; r < R; r++)
+			for (unsigned v = 0; v < NV; v++)
+				acc[r][v] = (*activation)(acc[r][v]);
+	for (unsigned r = 0; r < R; r++)
+		for (unsigned v = 0; v < NV; v++)
+			store(cRow(r) + v*Width, acc[r][v]);
+	if (partial)
+		for (unsigned r = 0; r < R; r++)
+			std::memcpy(c + (size_t)r*ldc, tile[r], cols*sizeof(float));
+}
+
+typedef void (*MicroKernel)(const float* const*, const float*, unsigned, unsigned, const float*, const Activation*, float*, unsigned, unsigned);
+static const MicroKernel microKernels[MR+1] = {
+	nullptr, microKernel<1>, microKernel<2>, microKernel<3>, microKernel<4>, microKernel<5>, microKernel<6>
+};
+static_assert(MR == 6);
+
+static void pack(const float *weights, unsigned N, unsigned K, PackedWeights &packed) {
+	packed.N = N;
+	packed.K = K;
+	packed.data.reset(new float[(size_t)packed.numPanels()*K*NR]);
+
+	for (unsigned p = 0, pe = packed.numPanels(); p < pe; p++) {
+		auto panel = const_cast<float*>(packed.panel(p));
+		for (unsigned k = 0; k < K; k++)
+			for (unsigned j = 0; j < NR; j++) {
+				auto n = p*NR + j;
+				*panel++ = n < N ? weights[(size_t)n*K + k] : 0;
+			}
+	}
+}
+
+void packWeights(const float *weights, unsigned N, unsigned K, PackedWeights &packed) {
+	pack(weights, N, K, packed);
+}
+
+void packWeights(const half_float::half *weights, unsigned N, unsigned K, PackedWeights &packed) {
+	// rows are widened by vectors (F16C when it is available) into a float32 copy that is then packed
+	size_t size = (size_t)N*K, i = 0;
+	std::unique_ptr<float[]> widened(new float[size]);
+	for (; i + Width <= size; i += Width)
+		store(widened.get() + i, loadWidened(weights + i));
+	for (; i < size; i++) // remaining elements
+		widened[i] = weights[i];
+	pack(widened.get(), N, K, packed);
+}
+
+void multiply(unsigned M, const float* const *aRows, const PackedWeights &weights, const float *bias, float *c, unsigned ldc,
+	const Activation &activation)
+{
+	auto N = weights.N, K = weights.K;
+	auto numPanels = weights.numPanels();
+
+	// bias padded to the panel width
+	float biasPadded[numPanels*NR];
+	if (bias) {
+		std::memcpy(biasPadded, bias, N*sizeof(float));
+		std::fill(biasPadded + N, biasPadded + numPanels*NR, 0);
+	}
+
+	static_assert(MC % MR == 0);
+	for (unsigned m0 = 0; m0 < M; m0 += MC) {
+		auto m1 = std::min(M, m0 + MC);
+		for (unsigned k0 = 0; k0 < K || k0 == 0; k0 += KC) {
+			auto k1 = std::min(K, k0 + KC);
+			auto sliceActivation = k1 == K && !activation.isNone() ? &activation : nullptr;
+			for (unsigned p = 0; p < numPanels; p++)
+				for (unsigned m = m0; m < m1; m += MR)
+					microKernels[std::min(MR, m1 - m)](aRows + m, weights.panel(p), k0, k1, bias ? biasPadded + p*NR : nullptr, sliceActivation,
+						c + (size_t)m*ldc + p*NR, ldc, std::min(NR, N - p*NR));
+		}
+	}
+}
+
+}
+
+}
@@ -0,0 +1,43 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "activation.h"
+
+#include <memory>
+
+#include <half.hpp>
+
+//
+// gemm: cache-blocked matrix multiplication with a register-blocked SIMD micro-kernel
+//       C[m][n] = bias[n] + sum_k A[m][k]*W[n][k], W has the layout of TF Lite weights: [N][K]
+//
+
+namespace Kernels {
+
+namespace Gemm {
+
+constexpr unsigned MR = 6;  // rows of C computed by one micro-kernel invocation
+constexpr unsigned NR = 16; // columns of C computed by one micro-kernel invocation, weights are packed in panels of this width
+
+struct PackedWeights { // weights rearranged into NR-wide column panels: panel[k][0..NR-1], the last panel is padded with zeros
+	unsigned                  N;
+	unsigned                  K;
+	std::unique_ptr<float[]>  data;
+
+	const float* panel(unsigned p) const {return data.get() + (size_t)p*K*NR;}
+	unsigned numPanels() const {return (N + NR - 1)/NR;}
+};
+
+void packWeights(const float *weights, unsigned N, unsigned K, PackedWeights &packed);
+void packWeights(const half_float::half *weights, unsigned N, unsigned K, PackedWeights &packed); // widened while they are packed
+
+// Multiplies M rows of A given by pointers (rows don't have to be evenly spaced: pointwise convolutions point them into the input)
+// by the packed weights. Rows of C are ldc floats apart. bias can be nullptr. Serial: callers split M between threads.
+// The activation is applied when the last K-slice is stored.
+void multiply(unsigned M, const float* const *aRows, const PackedWeights &weights, const float *bias, float *c, unsigned ldc,
+	const Activation &activation = Activation());
+
+}
+
+}
@@ -0,0 +1,360 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "quantized.h"
+#include "simd.h"
+
+#include "../thread-pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <assert.h>
+
+namespace Kernels {
+
+namespace Quantized {
+
+using namespace Simd;
+
+static const size_t MinWorkPerSlice = 32*1024; // multiply-adds
+
+Multiplier::Multiplier(double real) { // like TF Lite's QuantizeMultiplier
+	assert(real >= 0);
+	if (real == 0) {
+		multiplier = 0;
+		shift = 0;
+		return;
+	}
+	auto mantissa = std::llround(std::frexp(real, &shift)*(int64_t(1) << 31));
+	if (mantissa == (int64_t(1) << 31)) { // rounded up to the next power of two
+		mantissa /= 2;
+		shift++;
+	}
+	if (shift < -31) { // too small: the product is always zero
+		mantissa = 0;
+		shift = 0;
+	}
+	multiplier = (int32_t)mantissa;
+}
+
+template<typename T>
+void activationRange(Quantization quantization, float min, float max, int32_t &qmin, int32_t &qmax) {
+	qmin = std::numeric_limits<T>::min();
+	qmax = std::numeric_limits<T>::max();
+	if (std::isfinite(min))
+		qmin = std::max(qmin, quantization.zeroPoint + (int32_t)std::round(min/quantization.scale));
+	if (std::isfinite(max))
+		qmax = std::min(qmax, quantization.zeroPoint + (int32_t)std::round(max/quantization.scale));
+}
+
+template<typename T>
+void quantize(const float *input, size_t size, Quantization quantization, T *output) {
+	ThreadPool::parallelFor(size, MinWorkPerSlice, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			output[i] = (T)std::clamp(quantization.zeroPoint + (int32_t)std::round(input[i]/quantization.scale),
+			                          (int32_t)std::numeric_limits<T>::min(), (int32_t)std::numeric_limits<T>::max());
+	});
+}
+
+template<typename T>
+void dequantize(const T *input, size_t size, Quantization quantization, float *output) {
+	ThreadPool::parallelFor(size, MinWorkPerSlice, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			output[i] = quantization.scale*((int32_t)input[i] - quantization.zeroPoint);
+	});
+}
+
+template<typename T>
+void offsetValues(const T *input, size_t size, int32_t zeroPoint, int16_t *output) {
+	for (size_t i = 0; i < size; i++)
+		output[i] = (int16_t)((int32_t)input[i] - zeroPoint);
+}
+
+// accumulators become outputs
+template<typename T>
+static inline T requantize(int32_t acc, unsigned channel, const Requantization &requantization) {
+	auto &multiplier = requantization.multipliers[requantization.multipliers.size() == 1 ? 0 : channel];
+	return (T)std::clamp(multiplier.apply(acc) + requantization.zeroPoint, requantization.min, requantization.max);
+}
+
+static int32_t dot(const int16_t *a, const int16_t *b, size_t size) {
+	IVec acc{};
+	size_t i = 0;
+	for (; i + Width <= size; i += Width)
+		acc += loadWidened(a + i)*loadWidened(b + i);
+	int32_t sum = 0;
+	for (unsigned l = 0; l < Width; l++)
+		sum += acc[l];
+	for (; i < size; i++) // remaining elements
+		sum += (int32_t)a[i]*b[i];
+	return sum;
+}
+
+template<typename T>
+void Conv2D(
+	const TensorShape &inputShape, const T *inputData, int32_t inputZeroPoint,
+	const TensorShape &filterShape, const int16_t *filterData,
+	const int32_t *biasData,
+	const TensorShape &outputShape, T *outputData, const Requantization &requantization,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor
+) {
+	assert(inputShape.size()==4 && filterShape.size()==4 && outputShape.size()==4);
+	int H = inputShape[1], W = inputShape[2];
+	unsigned C = inputShape[3];
+	unsigned OC = filterShape[0], KH = filterShape[1], KW = filterShape[2];
+	unsigned OH = outputShape[1], OW = outputShape[2];
+	assert(inputShape[0]==outputShape[0] && filterShape[3]==C && outputShape[3]==OC);
+	size_t K = (size_t)KH*KW*C;
+
+	ThreadPool::parallelFor(outputShape[0]*OH, std::max(MinWorkPerSlice/((size_t)OW*OC*K), (size_t)1), [&](size_t begin, size_t end) {
+		std::vector<int16_t> patch(K); // inputs of one output pixel relative to the input zero point, padding is zero
+		for (auto row = begin; row < end; row++) {
+			unsigned b = row/OH, oy = row%OH;
+			auto input = inputData + (size_t)b*H*W*C;
+			auto output = outputData + row*OW*OC;
+			for (unsigned ox = 0; ox < OW; ox++, output += OC) {
+				auto p = patch.data();
+				for (unsigned ky = 0; ky < KH; ky++) {
+					int iy = (int)(oy*strideHeight + ky*dilationHeightFactor) - (int)paddingHeight;
+					for (unsigned kx = 0; kx < KW; kx++, p += C) {
+						int ix = (int)(ox*strideWidth + kx*dilationWidthFactor) - (int)paddingWidth;
+						if (iy >= 0 && iy < H && ix >= 0 && ix < W) {
+							auto in = input + ((size_t)iy*W + ix)*C;
+							for (unsigned c = 0; c < C; c++)
+								p[c] = (int16_t)((int32_t)in[c] - inputZeroPoint);
+						} else {
+							std::fill(p, p + C, 0);
+						}
+					}
+				}
+				for (unsigned oc = 0; oc < OC; oc++)
+					output[oc] = requantize<T>((biasData ? biasData[oc] : 0) + dot(patch.data(), filterData + oc*K, K), oc, requantization);
+			}
+		}
+	});
+}
+
+template<typename T>
+void DepthwiseConv2D(
+	const TensorShape &inputShape, const T *inputData, int32_t inputZeroPoint,
+	const TensorShape &filterShape, const int16_t *filterData,
+	const int32_t *biasData,
+	const TensorShape &outputShape, T *outputData, const Requantization &requantization,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	unsigned depthMultiplier
+) {
+	assert(inputShape.size()==4 && filterShape.size()==4 && outputShape.size()==4);
+	int H = inputShape[1], W = inputShape[2];
+	unsigned C = inputShape[3];
+	unsigned KH = filterShape[1], KW = filterShape[2], OC = filterShape[3];
+	unsigned OH = outputShape[1], OW = outputShape[2];
+	assert(inputShape[0]==outputShape[0] && filterShape[0]==1 && OC==C*depthMultiplier && outputShape[3]==OC);
+
+	ThreadPool::parallelFor(outputShape[0]*OH, std::max(MinWorkPerSlice/((size_t)OW*OC*KH*KW), (size_t)1), [&](size_t begin, size_t end) {
+		std::vector<int32_t> acc(OC);
+		for (auto row = begin; row < end; row++) {
+			unsigned b = row/OH, oy = row%OH;
+			auto input = inputData + (size_t)b*H*W*C;
+			auto output = outputData + row*OW*OC;
+			for (unsigned ox = 0; ox < OW; ox++, output += OC) {
+				for (unsigned oc = 0; oc < OC; oc++)
+					acc[oc] = biasData ? biasData[oc] : 0;
+				for (unsigned ky = 0; ky < KH; ky++) {
+					int iy = (int)(oy*strideHeight + ky*dilationHeightFactor) - (int)paddingHeight;
+					if (iy < 0 || iy >= H)
+						continue; // padding contributes zeros
+					for (unsigned kx = 0; kx < KW; kx++) {
+						int ix = (int)(ox*strideWidth + kx*dilationWidthFactor) - (int)paddingWidth;
+						if (ix < 0 || ix >= W)
+							continue;
+						auto in = input + ((size_t)iy*W + ix)*C;
+						auto f = filterData + (ky*KW + kx)*OC;
+						if (depthMultiplier == 1)
+							for (unsigned c = 0; c < C; c++)
+								acc[c] += ((int32_t)in[c] - inputZeroPoint)*f[c];
+						else
+							for (unsigned oc = 0; oc < OC; oc++)
+								acc[oc] += ((int32_t)in[oc/depthMultiplier] - inputZeroPoint)*f[oc];
+					}
+				}
+				for (unsigned oc = 0; oc < OC; oc++)
+					output[oc] = requantize<T>(acc[oc], oc, requantization);
+			}
+		}
+	});
+}
+
+template<typename T>
+void FullyConnected(
+	const TensorShape &inputShape, const T *inputData, int32_t inputZeroPoint, int16_t *inputScratch,
+	const TensorShape &filterShape, const int16_t *filterData,
+	const int32_t *biasData,
+	const TensorShape &outputShape, T *outputData, const Requantization &requantization
+) {
+	assert(filterShape.size()==2);
+	unsigned N = filterShape[0], K = filterShape[1];
+	auto batches = Tensor::flatSize(inputShape)/K;
+	assert(Tensor::flatSize(inputShape) == batches*K && Tensor::flatSize(outputShape) == batches*N);
+
+	offsetValues(inputData, batches*K, inputZeroPoint, inputScratch);
+
+	ThreadPool::parallelFor(N, std::max(MinWorkPerSlice/((size_t)batches*K), (size_t)1), [&](size_t begin, size_t end) {
+		for (size_t b = 0; b < batches; b++)
+			for (auto n = begin; n < end; n++)
+				outputData[b*N + n] = requantize<T>((biasData ? biasData[n] : 0) + dot(inputScratch + b*K, filterData + n*K, K), n, requantization);
+	});
+}
+
+template<typename T>
+void Add(
+	size_t size, const T *input1, Quantization quantization1,
+	size_t size2, const T *input2, Quantization quantization2,
+	T *output, Quantization outputQuantization, int32_t outputMin, int32_t outputMax
+) {
+	assert(size2 == size || size2 == 1);
+
+	// like TF Lite: inputs are shifted left and brought to the common scale, their sum is brought to the output scale
+	const int leftShift = 20;
+	double twiceMaxScale = 2*std::max(quantization1.scale, quantization2.scale);
+	Multiplier multiplier1(quantization1.scale/twiceMaxScale), multiplier2(quantization2.scale/twiceMaxScale);
+	Multiplier outputMultiplier(twiceMaxScale/((1 << leftShift)*(double)outputQuantization.scale));
+
+	auto scaled = [leftShift](T q, int32_t zeroPoint, const Multiplier &multiplier) {
+		return multiplier.apply(((int32_t)q - zeroPoint)*(1 << leftShift));
+	};
+	for (size_t i = 0; i < size; i++) {
+		auto sum = scaled(input1[i], quantization1.zeroPoint, multiplier1) + scaled(input2[size2 == 1 ? 0 : i], quantization2.zeroPoint, multiplier2);
+		output[i] = (T)std::clamp(outputMultiplier.apply(sum) + outputQuantization.zeroPoint, outputMin, outputMax);
+	}
+}
+
+// pools: taps outside of the input are skipped
+template<typename T, class Fn>
+static void pool(
+	const TensorShape &inputShape, const T *inputData,
+	const TensorShape &outputShape, T *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	Fn fn // fn(first tap of the channel, rowStride, columnStride, numRows, numColumns): the pooled value
+) {
+	assert(inputShape.size()==4 && outputShape.size()==4 && inputShape[0]==outputShape[0] && inputShape[3]==outputShape[3]);
+	int H = inputShape[1], W = inputShape[2];
+	unsigned C = inputShape[3];
+	unsigned OH = outputShape[1], OW = outputShape[2];
+
+	ThreadPool::parallelFor(outputShape[0]*OH, std::max(MinWorkPerSlice/((size_t)OW*C*filterWidth*filterHeight), (size_t)1), [&](size_t begin, size_t end) {
+		for (auto row = begin; row < end; row++) {
+			unsigned b = row/OH, oy = row%OH;
+			int iy0 = std::max((int)(oy*strideHeight) - (int)paddingHeight, 0), iy1 = std::min((int)(oy*strideHeight + filterHeight) - (int)paddingHeight, H);
+			auto output = outputData + row*OW*C;
+			for (unsigned ox = 0; ox < OW; ox++, output += C) {
+				int ix0 = std::max((int)(ox*strideWidth) - (int)paddingWidth, 0), ix1 = std::min((int)(ox*strideWidth + filterWidth) - (int)paddingWidth, W);
+				auto input = inputData + (((size_t)b*H + iy0)*W + ix0)*C;
+				for (unsigned c = 0; c < C; c++)
+					output[c] = fn(input + c, (size_t)W*C, C, std::max(iy1 - iy0, 0), std::max(ix1 - ix0, 0));
+			}
+		}
+	});
+}
+
+template<typename T>
+void MaxPool(
+	const TensorShape &inputShape, const T *inputData,
+	const TensorShape &outputShape, T *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	int32_t outputMin, int32_t outputMax
+) {
+	pool(inputShape, inputData, outputShape, outputData, paddingWidth, paddingHeight, strideWidth, strideHeight, filterWidth, filterHeight,
+		[outputMin,outputMax](const T *input, size_t rowStride, unsigned columnStride, int numRows, int numColumns) {
+			int32_t max = std::numeric_limits<T>::min();
+			for (int y = 0; y < numRows; y++)
+				for (int x = 0; x < numColumns; x++)
+					max = std::max(max, (int32_t)input[y*rowStride + x*columnStride]);
+			return (T)std::clamp(max, outputMin, outputMax);
+		}
+	);
+}
+
+template<typename T>
+void AveragePool(
+	const TensorShape &inputShape, const T *inputData,
+	const TensorShape &outputShape, T *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	int32_t outputMin, int32_t outputMax
+) {
+	pool(inputShape, inputData, outputShape, outputData, paddingWidth, paddingHeight, strideWidth, strideHeight, filterWidth, filterHeight,
+		[outputMin,outputMax](const T *input, size_t rowStride, unsigned columnStride, int numRows, int numColumns) {
+			int32_t sum = 0, count = numRows*numColumns;
+			for (int y = 0; y < numRows; y++)
+				for (int x = 0; x < numColumns; x++)
+					sum += input[y*rowStride + x*columnStride];
+			if (count == 0)
+				return (T)std::clamp(0, outputMin, outputMax);
+			auto average = (sum + (sum > 0 ? count/2 : -count/2))/count; // rounded like TF Lite does
+			return (T)std::clamp(average, outputMin, outputMax);
+		}
+	);
+}
+
+template<typename T>
+void Softmax(
+	const TensorShape &inputShape, const T *inputData, float inputScale, float beta,
+	T *outputData, Quantization outputQuantization
+) {
+	auto depth = inputShape[inputShape.size()-1];
+	auto rows = Tensor::flatSize(inputShape)/depth;
+
+	// exponents of all possible differences from the maximum
+	std::array<float,256> exps;
+	for (unsigned d = 0; d < exps.size(); d++)
+		exps[d] = std::exp(-beta*inputScale*d);
+
+	for (size_t r = 0; r < rows; r++) {
+		auto input = inputData + r*depth;
+		auto output = outputData + r*depth;
+		int32_t max = *std::max_element(input, input + depth);
+		float sum = 0;
+		for (unsigned i = 0; i < depth; i++)
+			sum += exps[max - input[i]];
+		for (unsigned i = 0; i < depth; i++)
+			output[i] = (T)std::clamp(outputQuantization.zeroPoint + (int32_t)std::round(exps[max - input[i]]/(sum*outputQuantization.scale)),
+			                          (int32_t)std::numeric_limits<T>::min(), (int32_t)std::numeric_limits<T>::max());
+	}
+}
+
+// instantiations for both quantized types
+
+#define INSTANTIATE(T) \
+	template void activationRange<T>(Quantization, float, float, int32_t&, int32_t&); \
+	template void quantize<T>(const float*, size_t, Quantization, T*); \
+	template void dequantize<T>(const T*, size_t, Quantization, float*); \
+	template void offsetValues<T>(const T*, size_t, int32_t, int16_t*); \
+	template void Conv2D<T>(const TensorShape&, const T*, int32_t, const TensorShape&, const int16_t*, const int32_t*, \
+	                        const TensorShape&, T*, const Requantization&, unsigned, unsigned, unsigned, unsigned, unsigned, unsigned); \
+	template void DepthwiseConv2D<T>(const TensorShape&, const T*, int32_t, const TensorShape&, const int16_t*, const int32_t*, \
+	                                 const TensorShape&, T*, const Requantization&, unsigned, unsigned, unsigned, unsigned, unsigned, unsigned, unsigned); \
+	template void FullyConnected<T>(const TensorShape&, const T*, int32_t, int16_t*, const TensorShape&, const int16_t*, const int32_t*, \
+	                                const TensorShape&, T*, const Requantization&); \
+	template void Add<T>(size_t, const T*, Quantization, size_t, const T*, Quantization, T*, Quantization, int32_t, int32_t); \
+	template void MaxPool<T>(const TensorShape&, const T*, const TensorShape&, T*, unsigned, unsigned, unsigned, unsigned, unsigned, unsigned, int32_t, int32_t); \
+	template void AveragePool<T>(const TensorShape&, const T*, const TensorShape&, T*, unsigned, unsigned, unsigned, unsigned, unsigned, unsigned, int32_t, int32_t); \
+	template void Softmax<T>(const TensorShape&, const T*, float, float, T*, Quantization);
+
+INSTANTIATE(int8_t)
+INSTANTIATE(uint8_t)
+
+#undef INSTANTIATE
+
+}
+
+}
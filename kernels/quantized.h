@@ -0,0 +1,140 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "../tensor.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//
+// quantized: integer kernels for int8 and uint8 tensors, values q represent real values scale*(q - zeroPoint)
+//            products of inputs and filters are accumulated in int32, accumulators are brought to the output scale
+//            by fixed-point multipliers with the rounding of TF Lite, so results match those of TF Lite
+//
+
+namespace Kernels {
+
+namespace Quantized {
+
+struct Quantization {
+	float   scale;
+	int32_t zeroPoint;
+};
+
+// fixed-point arithmetic of TF Lite (gemmlowp): the high half of the doubled product, rounded to the nearest
+inline int32_t doublingHighMul(int32_t a, int32_t b) {
+	if (a == std::numeric_limits<int32_t>::min() && b == std::numeric_limits<int32_t>::min())
+		return std::numeric_limits<int32_t>::max(); // the only overflow
+	int64_t ab = (int64_t)a*b;
+	return (int32_t)((ab + (ab >= 0 ? (int64_t(1) << 30) : 1 - (int64_t(1) << 30)))/(int64_t(1) << 31));
+}
+inline int32_t roundingDivideByPOT(int32_t x, int exponent) { // halves are rounded away from zero
+	int32_t mask = (int32_t(1) << exponent) - 1, remainder = x & mask, threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+	return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+// multiplication of int32 values by a positive real number in fixed point: value*multiplier*2^(shift-31)
+struct Multiplier {
+	int32_t multiplier; // the mantissa in [2^30,2^31), or 0
+	int     shift;      // the exponent, positive values shift left
+
+	explicit Multiplier(double real = 0);
+
+	int32_t apply(int32_t value) const { // like TF Lite's MultiplyByQuantizedMultiplier
+		return shift > 0 ? doublingHighMul((int32_t)((int64_t)value << shift), multiplier)
+		                 : roundingDivideByPOT(doublingHighMul(value, multiplier), -shift);
+	}
+};
+
+// how int32 accumulators become output values
+struct Requantization {
+	std::vector<Multiplier> multipliers; // inputScale*filterScale/outputScale: one for all channels, or one per output channel
+	int32_t                 zeroPoint;   // of the output
+	int32_t                 min, max;    // the range of the output type narrowed by the fused activation function
+};
+
+// the range of T narrowed to the real range [min,max] of an activation function
+template<typename T>
+void activationRange(Quantization quantization, float min, float max, int32_t &qmin, int32_t &qmax);
+
+// conversions of real values
+template<typename T>
+void quantize(const float *input, size_t size, Quantization quantization, T *output);
+template<typename T>
+void dequantize(const T *input, size_t size, Quantization quantization, float *output);
+
+// values relative to their zero point fit into int16: filters are passed to kernels in this form, prepared once
+template<typename T>
+void offsetValues(const T *input, size_t size, int32_t zeroPoint, int16_t *output);
+
+template<typename T>
+void Conv2D(
+	const TensorShape &inputShape, const T *inputData, int32_t inputZeroPoint,
+	const TensorShape &filterShape, const int16_t *filterData, // relative to the zero point
+	const int32_t *biasData,
+	const TensorShape &outputShape, T *outputData, const Requantization &requantization,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor
+);
+
+template<typename T>
+void DepthwiseConv2D(
+	const TensorShape &inputShape, const T *inputData, int32_t inputZeroPoint,
+	const TensorShape &filterShape, const int16_t *filterData, // relative to the zero point
+	const int32_t *biasData,
+	const TensorShape &outputShape, T *outputData, const Requantization &requantization,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	unsigned depthMultiplier
+);
+
+template<typename T>
+void FullyConnected(
+	const TensorShape &inputShape, const T *inputData, int32_t inputZeroPoint, int16_t *inputScratch, // the scratch space holds all inputs relative to the zero point
+	const TensorShape &filterShape, const int16_t *filterData, // relative to the zero point
+	const int32_t *biasData,
+	const TensorShape &outputShape, T *outputData, const Requantization &requantization
+);
+
+// input2 has the size of input1, or it is a single value
+template<typename T>
+void Add(
+	size_t size, const T *input1, Quantization quantization1,
+	size_t size2, const T *input2, Quantization quantization2,
+	T *output, Quantization outputQuantization, int32_t outputMin, int32_t outputMax
+);
+
+// pools keep the quantization of their inputs
+template<typename T>
+void MaxPool(
+	const TensorShape &inputShape, const T *inputData,
+	const TensorShape &outputShape, T *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	int32_t outputMin, int32_t outputMax
+);
+template<typename T>
+void AveragePool(
+	const TensorShape &inputShape, const T *inputData,
+	const TensorShape &outputShape, T *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	int32_t outputMin, int32_t outputMax
+);
+
+// exponents of differences from the maximum of the row are looked up in a table of 256 values
+template<typename T>
+void Softmax(
+	const TensorShape &inputShape, const T *inputData, float inputScale, float beta,
+	T *outputData, Quantization outputQuantization
+);
+
+}
+
+}
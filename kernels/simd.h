@@ -0,0 +1,65 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <half.hpp>
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+//
+// simd: portable vector types based on the GCC/Clang vector extensions,
+//       the compiler lowers them to the widest instructions that -march allows
+//
+
+namespace Kernels {
+
+namespace Simd {
+
+constexpr unsigned Width = 8; // floats in one vector
+
+typedef float Vec __attribute__((vector_size(Width*sizeof(float))));
+
+inline Vec load(const float *p) {
+	Vec v;
+	std::memcpy(&v, p, sizeof(v)); // unaligned load
+	return v;
+}
+
+inline void store(float *p, Vec v) {
+	std::memcpy(p, &v, sizeof(v)); // unaligned store
+}
+
+inline Vec broadcast(float f) {
+	return Vec{} + f;
+}
+
+// float16 values are widened as they are loaded, with one instruction when F16C is available
+inline Vec loadWidened(const half_float::half *p) {
+#if defined(__F16C__)
+	static_assert(Width == 8);
+	return (Vec)_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+#else
+	Vec v;
+	for (unsigned i = 0; i < Width; i++)
+		v[i] = p[i];
+	return v;
+#endif
+}
+
+// integers: products of 16-bit values are accumulated in 32-bit lanes
+typedef int32_t IVec __attribute__((vector_size(Width*sizeof(int32_t))));
+typedef int16_t HVec __attribute__((vector_size(Width*sizeof(int16_t))));
+
+inline IVec loadWidened(const int16_t *p) {
+	HVec v;
+	std::memcpy(&v, p, sizeof(v)); // unaligned load
+	return __builtin_convertvector(v, IVec);
+}
+
+}
+
+}
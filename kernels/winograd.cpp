@@ -0,0 +1,295 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "winograd.h"
+
+#include "../thread-pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <assert.h>
+
+namespace Kernels {
+
+namespace Winograd {
+
+// transform matrices from "Fast Algorithms for Convolutional Neural Networks" (Lavin, Gray)
+template<unsigned M> struct Matrices;
+
+template<> struct Matrices<2> {
+	static constexpr float BT[4][4] = {
+		{1,  0, -1,  0},
+		{0,  1,  1,  0},
+		{0, -1,  1,  0},
+		{0,  1,  0, -1}
+	};
+	static constexpr double G[4][3] = {
+		{1,    0,   0},
+		{0.5,  0.5, 0.5},
+		{0.5, -0.5, 0.5},
+		{0,    0,   1}
+	};
+	static constexpr float AT[2][4] = {
+		{1, 1,  1,  0},
+		{0, 1, -1, -1}
+	};
+};
+
+template<> struct Matrices<4> {
+	static constexpr float BT[6][6] = {
+		{4,  0, -5,  0, 1, 0},
+		{0, -4, -4,  1, 1, 0},
+		{0,  4, -4, -1, 1, 0},
+		{0, -2, -1,  2, 1, 0},
+		{0,  2, -1, -2, 1, 0},
+		{0,  4,  0, -5, 0, 1}
+	};
+	static constexpr double G[6][3] = {
+		{ 1./4,     0,      0},
+		{-1./6,  -1./6,  -1./6},
+		{-1./6,   1./6,  -1./6},
+		{ 1./24,  1./12,  1./6},
+		{ 1./24, -1./12,  1./6},
+		{ 0,      0,      1}
+	};
+	static constexpr float AT[4][6] = {
+		{1, 1,  1, 1,  1, 0},
+		{0, 1, -1, 2, -2, 0},
+		{0, 1,  1, 4,  4, 0},
+		{0, 1, -1, 8, -8, 1}
+	};
+};
+
+static const size_t ScratchBudget = 2*1024*1024; // bytes of transformed tiles per thread
+
+/// filter transform: U = G g G^T for every pair of channels
+
+template<unsigned M>
+static void transformFilter(const float *filterData, unsigned O, unsigned I, Filter &filter) {
+	constexpr unsigned N = M+2;
+	auto &G = Matrices<M>::G;
+
+	std::unique_ptr<float[]> u(new float[(size_t)N*N*O*I]); // [N*N][O][I]
+	for (unsigned o = 0; o < O; o++)
+		for (unsigned c = 0; c < I; c++) {
+			double g[3][3], tmp[N][3];
+			for (unsigned ky = 0; ky < 3; ky++)
+				for (unsigned kx = 0; kx < 3; kx++)
+					g[ky][kx] = filterData[((o*3 + ky)*3 + kx)*I + c];
+			for (unsigned i = 0; i < N; i++)
+				for (unsigned j = 0; j < 3; j++)
+					tmp[i][j] = G[i][0]*g[0][j] + G[i][1]*g[1][j] + G[i][2]*g[2][j];
+			for (unsigned i = 0; i < N; i++)
+				for (unsigned j = 0; j < N; j++)
+					u[((size_t)(i*N + j)*O + o)*I + c] = tmp[i][0]*G[j][0] + tmp[i][1]*G[j][1] + tmp[i][2]*G[j][2];
+		}
+
+	filter.weights.resize(N*N);
+	for (unsigned xi = 0; xi < N*N; xi++)
+		Gemm::packWeights(u.get() + (size_t)xi*O*I, O, I, filter.weights[xi]);
+}
+
+/// input and output tile transforms, channels are the innermost loop and are vectorized
+
+template<unsigned M>
+static void transformInputTile(const float *d, float *tmp, float* const *v, unsigned I) { // V = B^T d B
+	constexpr unsigned N = M+2;
+	auto &BT = Matrices<M>::BT;
+
+	for (unsigned i = 0; i < N; i++)
+		for (unsigned j = 0; j < N; j++) {
+			auto out = tmp + (i*N + j)*I;
+			std::fill(out, out + I, 0);
+			for (unsigned k = 0; k < N; k++)
+				if (auto coef = BT[i][k])
+					for (unsigned c = 0, in = (k*N + j)*I; c < I; c++)
+						out[c] += coef*d[in + c];
+		}
+	for (unsigned i = 0; i < N; i++)
+		for (unsigned j = 0; j < N; j++) {
+			auto out = v[i*N + j];
+			std::fill(out, out + I, 0);
+			for (unsigned k = 0; k < N; k++)
+				if (auto coef = BT[j][k])
+					for (unsigned c = 0, in = (i*N + k)*I; c < I; c++)
+						out[c] += coef*tmp[in + c];
+		}
+}
+
+template<unsigned M>
+static void transformOutputTile(const float* const *m, float *tmp, const float *bias, float *y, unsigned O) { // Y = A^T m A + bias
+	constexpr unsigned N = M+2;
+	auto &AT = Matrices<M>::AT;
+
+	for (unsigned i = 0; i < M; i++)
+		for (unsigned j = 0; j < N; j++) {
+			auto out = tmp + (i*N + j)*O;
+			std::fill(out, out + O, 0);
+			for (unsigned k = 0; k < N; k++)
+				if (auto coef = AT[i][k])
+					for (unsigned o = 0; o < O; o++)
+						out[o] += coef*m[k*N + j][o];
+		}
+	for (unsigned i = 0; i < M; i++)
+		for (unsigned j = 0; j < M; j++) {
+			auto out = y + (i*M + j)*O;
+			if (bias)
+				std::memcpy(out, bias, O*sizeof(float));
+			else
+				std::fill(out, out + O, 0);
+			for (unsigned k = 0; k < N; k++)
+				if (auto coef = AT[j][k])
+					for (unsigned o = 0, in = (i*N + k)*O; o < O; o++)
+						out[o] += coef*tmp[in + o];
+		}
+}
+
+/// convolution
+
+template<unsigned M>
+static void convolve(
+	const TensorShape &inputShape, const float *inputData,
+	const Filter &filter,
+	const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	const Activation &activation,
+	unsigned outputStride
+) {
+	constexpr unsigned N = M+2;
+	int H = inputShape[1], W = inputShape[2];
+	unsigned OH = outputShape[1], OW = outputShape[2];
+	unsigned I = filter.I, O = filter.O;
+	unsigned tilesY = (OH + M - 1)/M, tilesX = (OW + M - 1)/M;
+	unsigned numTiles = outputShape[0]*tilesY*tilesX;
+
+	// tiles transformed at once: more tiles reuse the weights better, fewer tiles keep the scratch memory in cache
+	unsigned blockTiles = ScratchBudget/(N*N*(I + O)*sizeof(float));
+	blockTiles = std::clamp(blockTiles/Gemm::MR*Gemm::MR, Gemm::MR, 16*Gemm::MR);
+
+	ThreadPool::parallelFor(numTiles, blockTiles, [&](size_t begin, size_t end) {
+		thread_local std::vector<float> scratch;
+		scratch.resize((size_t)N*N*blockTiles*(I + O) + 2*N*N*std::max(I, O) + M*M*O);
+		auto vbuf = scratch.data();                     // [N*N][blockTiles][I] transformed input tiles
+		auto mbuf = vbuf + (size_t)N*N*blockTiles*I;     // [N*N][blockTiles][O] their products with the transformed filter
+		auto dtile = mbuf + (size_t)N*N*blockTiles*O;    // [N][N][I] input tile
+		auto tmp = dtile + N*N*std::max(I, O);           // [N][N][max(I,O)] intermediate results of transforms
+		auto ytile = tmp + N*N*std::max(I, O);           // [M][M][O] output tile
+
+		const float* rows[blockTiles];
+		float* points[N*N];
+		const float* cpoints[N*N];
+
+		for (auto t0 = begin; t0 < end; t0 += blockTiles) {
+			auto t1 = std::min(end, t0 + blockTiles);
+			auto T = t1 - t0;
+
+			// transform input tiles
+			for (auto t = t0; t < t1; t++) {
+				unsigned b = t/(tilesY*tilesX), ty = t/tilesX%tilesY, tx = t%tilesX;
+				auto input = inputData + (size_t)b*H*W*I;
+				int iy0 = ty*M - paddingHeight, ix0 = tx*M - paddingWidth;
+				for (unsigned y = 0; y < N; y++)
+					for (unsigned x = 0; x < N; x++) {
+						int iy = iy0 + y, ix = ix0 + x;
+						auto d = dtile + (y*N + x)*I;
+						if (iy >= 0 && iy < H && ix >= 0 && ix < W)
+							std::memcpy(d, input + ((size_t)iy*W + ix)*I, I*sizeof(float));
+						else
+							std::fill(d, d + I, 0);
+					}
+				for (unsigned xi = 0; xi < N*N; xi++)
+					points[xi] = vbuf + ((size_t)xi*blockTiles + (t - t0))*I;
+				transformInputTile<M>(dtile, tmp, points, I);
+			}
+
+			// multiply by the transformed filter
+			for (unsigned xi = 0; xi < N*N; xi++) {
+				for (unsigned t = 0; t < T; t++)
+					rows[t] = vbuf + ((size_t)xi*blockTiles + t)*I;
+				Gemm::multiply(T, rows, filter.weights[xi], nullptr, mbuf + (size_t)xi*blockTiles*O, O);
+			}
+
+			// transform output tiles
+			for (auto t = t0; t < t1; t++) {
+				unsigned b = t/(tilesY*tilesX), ty = t/tilesX%tilesY, tx = t%tilesX;
+				for (unsigned xi = 0; xi < N*N; xi++)
+					cpoints[xi] = mbuf + ((size_t)xi*blockTiles + (t - t0))*O;
+				transformOutputTile<M>(cpoints, tmp, biasData, ytile, O);
+				activation.apply(ytile, M*M*O); // the tile is in L1, the output is written once
+				auto output = outputData + (size_t)b*OH*OW*outputStride;
+				for (unsigned y = 0; y < M && ty*M + y < OH; y++) {
+					auto oy = ty*M + y, ox = tx*M;
+					if (outputStride == O)
+						std::memcpy(output + ((size_t)oy*OW + ox)*O, ytile + y*M*O, std::min(M, OW - ox)*O*sizeof(float));
+					else
+						for (unsigned x = 0; x < M && ox + x < OW; x++)
+							std::memcpy(output + ((size_t)oy*OW + ox + x)*outputStride, ytile + (y*M + x)*O, O*sizeof(float));
+				}
+			}
+		}
+	});
+}
+
+/// interface
+
+bool applicable(const TensorShape &filterShape, unsigned strideWidth, unsigned strideHeight, unsigned dilationWidthFactor, unsigned dilationHeightFactor) {
+	return filterShape.size()==4 && filterShape[1]==3 && filterShape[2]==3 &&
+		strideWidth==1 && strideHeight==1 && dilationWidthFactor==1 && dilationHeightFactor==1 &&
+		filterShape[0] >= 32 && filterShape[3] >= 32; // transforms would dominate with fewer channels
+}
+
+unsigned chooseTileSize(const TensorShape &outputShape) {
+	return outputShape[1] >= 8 && outputShape[2] >= 8 ? 4 : 2;
+}
+
+std::shared_ptr<const Filter> transformFilter(const TensorShape &filterShape, const float *filterData, unsigned m) {
+	assert(filterShape.size()==4 && filterShape[1]==3 && filterShape[2]==3);
+
+	auto filter = std::make_shared<Filter>();
+	filter->m = m;
+	filter->O = filterShape[0];
+	filter->I = filterShape[3];
+	switch (m) {
+	case 2:
+		transformFilter<2>(filterData, filter->O, filter->I, *filter);
+		break;
+	case 4:
+		transformFilter<4>(filterData, filter->O, filter->I, *filter);
+		break;
+	default:
+		assert(false);
+	}
+	return filter;
+}
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const Filter &filter,
+	const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	const Activation &activation,
+	unsigned outputStride
+) {
+	assert(inputShape.size()==4 && outputShape.size()==4);
+	assert(inputShape[0]==outputShape[0] && inputShape[3]==filter.I && outputShape[3]==filter.O);
+	if (outputStride == 0)
+		outputStride = filter.O;
+	assert(outputStride >= filter.O);
+
+	switch (filter.m) {
+	case 2:
+		convolve<2>(inputShape, inputData, filter, biasData, outputShape, outputData, paddingWidth, paddingHeight, activation, outputStride);
+		break;
+	case 4:
+		convolve<4>(inputShape, inputData, filter, biasData, outputShape, outputData, paddingWidth, paddingHeight, activation, outputStride);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+}
+
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "activation.h"
+#include "gemm.h"
+
+#include "../tensor.h"
+
+#include <memory>
+#include <vector>
+
+//
+// winograd: Winograd minimal filtering F(mxm,3x3) for 3x3 stride-1 convolutions
+//           every mxm output tile is computed from an (m+2)x(m+2) input tile with (m+2)^2 multiplications
+//           per channel pair instead of 9*m^2, the multiplications of all tiles form (m+2)^2 independent GEMMs
+//
+
+namespace Kernels {
+
+namespace Winograd {
+
+struct Filter { // filter transformed into the Winograd domain, it only depends on the weights and can be reused
+	unsigned                          m; // output tile size: 2 or 4
+	unsigned                          I; // input channels
+	unsigned                          O; // output channels
+	std::vector<Gemm::PackedWeights>  weights; // one [O][I] matrix per point of the transformed tile
+};
+
+// whether the Winograd convolution can be used and is worth it
+bool applicable(const TensorShape &filterShape, unsigned strideWidth, unsigned strideHeight, unsigned dilationWidthFactor, unsigned dilationHeightFactor);
+
+// F(4x4,3x3) has a better multiplication ratio, F(2x2,3x3) wastes less on small outputs and is more accurate
+unsigned chooseTileSize(const TensorShape &outputShape);
+
+std::shared_ptr<const Filter> transformFilter(const TensorShape &filterShape, const float *filterData, unsigned m);
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const Filter &filter,
+	const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	const Activation &activation,
+	unsigned outputStride = 0 // floats between output pixels, 0 when they are packed
+);
+
+}
+
+}
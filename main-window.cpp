@@ -10,14 +10,15 @@
 #include "in-memory-model.h"
 #include "misc.h"
 #include "model-validator.h"
+#include "model-views/fuse-operators.h"
 #include "model-views/merge-dequantize-operators.h"
-#include "nn-operators.h"
 #include "nn-types.h"
 #include "options.h"
 #include "options-dialog.h"
 #include "svg-graphics-generator.h"
 #include "svg-push-button.h"
 #include "tensor.h"
+#include "thread-pool.h"
 #include "training.h"
 #include "training-widget.h"
 #include "transformation-quantize-dialog.h"
@@ -192,6 +193,7 @@ MainWindow::MainWindow()
 ,            computeLayout(&computeWidget)
 ,            computeButton(tr("Compute"), &computeWidget)
 ,            computeRegionComboBox(&computeWidget)
+,            computeProgressBar(&computeWidget)
 ,          computeByWidget(&sourceDetails)
 ,            computeByLayout(&computeByWidget)
 ,            inputNormalizationLabel(tr("Normalization"), &computeByWidget)
@@ -262,6 +264,7 @@ MainWindow::MainWindow()
 #endif
 , plugin(nullptr)
 , modelPendingTrainingDerivativesCoefficient(0)
+, computeGeneration(0)
 , scaleImageWidthPct(0)
 , scaleImageHeightPct(0)
 , self(0)
@@ -308,6 +311,7 @@ MainWindow::MainWindow()
 	    sourceDetailsLayout.addWidget(&computeWidget,            6/*row*/, 0/*col*/, 1/*rowSpan*/, 4/*columnSpan*/);
 	      computeLayout.addWidget(&computeButton);
 	      computeLayout.addWidget(&computeRegionComboBox);
+	      computeLayout.addWidget(&computeProgressBar);
 	    sourceDetailsLayout.addWidget(&computeByWidget,          7/*row*/, 0/*col*/, 1/*rowSpan*/, 4/*columnSpan*/);
 	      computeByLayout.addWidget(&inputNormalizationLabel);
 	      computeByLayout.addWidget(&inputNormalizationRangeComboBox);
@@ -412,6 +416,7 @@ MainWindow::MainWindow()
 	sourceEffectConvolutionCountComboBox.setToolTip(tr("How many times to apply the convolution"));
 	computeButton                       .setToolTip(tr("Perform neural network computation for the currently selected image as input"));
 	computeRegionComboBox               .setToolTip(tr("Choose what region of the image to compute on: the visible area or the whole image"));
+	computeProgressBar                  .setToolTip(tr("Tensors computed so far, they can be viewed while the computation is in progress"));
 	inputNormalizationLabel             .setToolTip(tr("Specify how does this NN expect its input data be normalized"));
 	inputNormalizationRangeComboBox     .setToolTip(tr("Specify what value range does this NN expect its input data be normalized to"));
 	inputNormalizationColorOrderComboBox.setToolTip(tr("Specify what color order does this NN expect its input data be supplied in"));
@@ -468,6 +473,7 @@ MainWindow::MainWindow()
 	computeWidget                        .setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Maximum);
 	computeButton                        .setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Maximum);
 	computeRegionComboBox                .setSizePolicy(QSizePolicy::Fixed,   QSizePolicy::Maximum);
+	computeProgressBar                   .setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Maximum);
 	inputNormalizationLabel              .setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum); //The sizeHint() is a maximum
 	inputNormalizationRangeComboBox      .setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
 	inputNormalizationColorOrderComboBox .setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
@@ -509,6 +515,7 @@ MainWindow::MainWindow()
 	nnNetworkStaticDataText.setWordWrap(true); // allow word wrap because text is long in this label
 	outputInterpretationSummaryLineEdit.setWordWrap(true);
 	nnTensorDataPlaceholder1DnotImplemented.hide();
+	computeProgressBar.hide(); // only visible while the computation is in progress
 
 	// widget states
 	updateResultInterpretationSummaryText(false/*enable*/, tr("n/a"), tr("n/a"));
@@ -613,15 +620,19 @@ MainWindow::MainWindow()
 			effectsChanged();
 	});
 	connect(&computeButton, &QAbstractButton::pressed, [this]() {
+		// the button cancels the computation that is in progress, a tensor that is recomputed for the screen is computed again with the others
+		if (computeThread) {
+			bool recomputing = computeThread->recomputesOnly();
+			cancelComputation();
+			if (!recomputing) {
+				computationTimeLabel.setText(tr("Computation cancelled"));
+				return;
+			}
+		}
+
 		QElapsedTimer timer;
 		timer.start();
 
-		// allocate tensors array
-		if (!tensorData) {
-			tensorData.reset(new std::vector<std::shared_ptr<const float>>);
-			tensorData->resize(model->numTensors());
-		}
-
 		// computation arguments
 		bool doVisibleRegion = computeRegionComboBox.currentIndex()==0;
 		std::array<unsigned,4> imageRegion = doVisibleRegion ? getVisibleImageRegion() : std::array<unsigned,4>{0,0, sourceTensorShape[1]-1,sourceTensorShape[0]-1};
@@ -648,27 +659,101 @@ MainWindow::MainWindow()
 			return;
 		}
 
-		// fill the input data into tensors
+		// fill the input data into tensors, computed tensors are added as the computation thread reports them
+		tensorData.reset(new std::vector<std::shared_ptr<const float>>);
+		tensorData->resize(model->numTensors());
 		Compute::fillInputs(modelInputs, tensorData);
-
-		// compute
-		succ = Compute::compute(model.get(), tensorData, cbTensorComputed,cbWarningMessage);
-		if (!succ) {
-			PRINT("WARNING computation didn't succeed")
-			return;
+		if (nnTensorData2D && model->isTensorComputed(nnCurrentTensorId))
+			nnTensorData2D->setEnabled(false); // gray out the table until its tensor is computed again
+
+		// tensors that the retention policy keeps, the plan is compiled again when they change
+		std::vector<bool> retained;
+		std::vector<PluginInterface::TensorId> checkpoints;
+		if (Options::get().getTensorRetention() != Options::TensorRetention_KeepAll) {
+			retained.resize(model->numTensors(), false);
+			for (auto tids : {model->getInputs(), model->getOutputs()})
+				for (auto tid : tids)
+					retained[tid] = true;
+			if (Options::get().getTensorRetention() == Options::TensorRetention_KeepCheckpoints)
+				for (unsigned oid = 0, oe = model->numOperators(); oid < oe; oid++)
+					if ((oid+1) % std::max(Options::get().getCheckpointInterval(), 1u) == 0) {
+						std::vector<PluginInterface::TensorId> inputs, outputs;
+						model->getOperatorIo(oid, inputs, outputs);
+						for (auto tid : outputs) {
+							retained[tid] = true;
+							checkpoints.push_back(tid);
+						}
+					}
+		}
+		if (retained != retainedTensors) {
+			computePlan.reset(nullptr);
+			retainedTensors = retained;
 		}
 
-		// computation succeeded
-		if (nnCurrentTensorId!=-1 && model->isTensorComputed(nnCurrentTensorId)) {
-			if (!nnTensorData2D) {
-				showNnTensorData2D();
-			} else {
-				nnTensorData2D->dataChanged((*tensorData.get())[nnCurrentTensorId].get());
-				nnTensorData2D->setEnabled(true);
+		// compute on the computation thread
+		computeThread.reset(new ComputeThread(this,
+			model.get(), computePlan, modelInputs,
+			retainedTensors.empty()/*keepAllIntermediates*/, checkpoints,
+			Options::get().getDeterministicCompute() ? Compute::Scheduling::Deterministic : Compute::Scheduling::Parallel,
+			Options::get().getCompareQuantized(),
+			nnCurrentTensorId // recomputed before the computation finishes when the retention policy discards it
+		));
+		auto generation = ++computeGeneration;
+		connect(computeThread.get(), &ComputeThread::tensorComputed, this,
+			[this,generation](PluginInterface::TensorId tensorId, unsigned numComputed, unsigned numTotal) {
+				if (generation != computeGeneration)
+					return; // the computation was cancelled
+				// memory of tensors that the retention policy discards is reused while the computation goes on
+				if (retainedTensors.empty() || retainedTensors[tensorId])
+					(*tensorData)[tensorId] = computeThread->getTensorData(tensorId);
+				computeProgressBar.setMaximum(numTotal);
+				computeProgressBar.setValue(numComputed);
+				// the tensor on screen is viewable as soon as it is computed
+				if (tensorId == nnCurrentTensorId && (*tensorData)[tensorId]) {
+					if (!nnTensorData2D) {
+						showNnTensorData2D();
+					} else {
+						nnTensorData2D->dataChanged((*tensorData.get())[nnCurrentTensorId].get());
+						nnTensorData2D->setEnabled(true);
+					}
+				}
+			},
+			Qt::QueuedConnection
+		);
+		connect(computeThread.get(), &ComputeThread::tensorRecomputed, this, [this,generation](PluginInterface::TensorId tensorId) {
+			if (generation == computeGeneration)
+				showRecomputedTensor(tensorId);
+		}, Qt::QueuedConnection);
+		connect(computeThread.get(), &ComputeThread::warningMessage, this, [this,generation](const QString &msg) {
+			if (generation == computeGeneration)
+				Util::warningOk(this, msg);
+		}, Qt::QueuedConnection);
+		connect(computeThread.get(), &ComputeThread::finished, this, [this,generation,timer]() {
+			if (generation != computeGeneration)
+				return; // the computation was cancelled
+			bool succ = computeThread->succeeded();
+			if (succ)
+				showComputeProfile(computeThread->getProfile());
+			// delete the thread object
+			computeThread.reset(nullptr);
+			// restore widgets to their normal state
+			computeButton.setText(tr("Compute"));
+			computeProgressBar.hide();
+			if (!succ) {
+				PRINT("WARNING computation didn't succeed")
+				return;
 			}
-		}
-		updateResultInterpretation();
-		computationTimeLabel.setText(QString("Computed in %1").arg(QString("%1 ms").arg(S2Q(Util::formatUIntHumanReadable(timer.elapsed())))));
+			// computation succeeded
+			updateResultInterpretation();
+			computationTimeLabel.setText(QString("Computed in %1").arg(QString("%1 ms").arg(S2Q(Util::formatUIntHumanReadable(timer.elapsed())))));
+			// the thread has recomputed the tensor that was on screen when it started, another one could have been selected since
+			if (nnCurrentTensorId >= 0 && isTensorDiscarded(nnCurrentTensorId))
+				recomputeDiscardedTensor(nnCurrentTensorId);
+		}, Qt::QueuedConnection);
+		computeButton.setText(tr("Cancel"));
+		computeProgressBar.setValue(0);
+		computeProgressBar.show();
+		computeThread->start();
 	});
 	connect(&computeRegionComboBox, QOverload<int>::of(&QComboBox::activated), [this](int) {
 		clearComputedTensorData(Temporary);
@@ -703,9 +788,16 @@ MainWindow::MainWindow()
 		PluginInterface::TensorId tensorId = nnTensorSaveDataButton.property("tensorId").toUInt();
 		PRINT("Saving data for tensor#" << tensorId)
 		if (model->getTensorHasData(tensorId) || (tensorData && (*tensorData.get())[tensorId])) {
+			std::unique_ptr<float[]> widened; // static float16 tensors are saved as float32
+			if (model->getTensorHasData(tensorId) && model->getTensorType(tensorId) == PluginInterface::DataType_Float16) {
+				auto size = Tensor::flatSize(model->getTensorShape(tensorId));
+				auto data = static_cast<const half_float::half*>(model->getTensorData(tensorId));
+				widened.reset(new float[size]);
+				std::copy(data, data + size, widened.get());
+			}
 			Tensor::saveTensorDataAsJson(
 				model->getTensorShape(tensorId),
-				model->getTensorHasData(tensorId) ? model->getTensorDataF32(tensorId) : (*tensorData.get())[tensorId].get(),
+				widened ? widened.get() : model->getTensorHasData(tensorId) ? model->getTensorDataF32(tensorId) : (*tensorData.get())[tensorId].get(),
 				CSTR("tensor#" << tensorId << ".json") // match the name with one in compute.cpp
 			);
 		} else {
@@ -882,7 +974,14 @@ MainWindow::MainWindow()
 			showFullScreen();
 	})->setShortcut(QKeySequence(Qt::Key_F11));
 	viewMenu->addAction(tr("Op&tions"), [this]() {
+		auto numComputeThreads = Options::get().getNumComputeThreads();
 		OptionsDialog(Options::get(), this).exec();
+		if (Options::get().getNumComputeThreads() != numComputeThreads) {
+			// the pool is resized when it is idle: computations are cancelled rather than waited for
+			for (auto w : allWindows)
+				w->cancelComputation();
+			ThreadPool::setNumThreads(Options::get().getNumComputeThreads());
+		}
 	})->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_T));
 
 	// icon
@@ -897,6 +996,7 @@ MainWindow::MainWindow()
 }
 
 MainWindow::~MainWindow() {
+	cancelComputation();
 	if (model) {
 		model = nullptr;
 		pluginInterface.reset(nullptr);
@@ -933,6 +1033,9 @@ bool MainWindow::loadModelFile(const QString &filePath) {
 	if (pluginName == nullptr)
 		return Util::warningOk(this, QString("%1 '%2'").arg(tr("Couldn't find a plugin to open the file")).arg(filePath));
 
+	// the computation in progress uses the previous model
+	cancelComputation();
+
 	// load the plugin
 	plugin = PluginManager::loadPlugin(pluginName);
 	if (!plugin)
@@ -947,10 +1050,18 @@ bool MainWindow::loadModelFile(const QString &filePath) {
 	if (pluginInterface->numModels() != 1)
 		FAIL("multi-model files aren't supported yet")
 	model.reset(pluginInterface->getModel(0));
+	computePlan.reset(nullptr);
 
 	// add ModelViews::MergeDequantizeOperators
-	if (!::getenv("NN_INSIGHT_NO_MERGE_DEQUANTIZE_OPERATORS")) // XXX TODO need to have a UI-based options screen for such choices
-		model.reset(new ModelViews::MergeDequantizeOperators(model.release()));
+	if (!::getenv("NN_INSIGHT_NO_MERGE_DEQUANTIZE_OPERATORS")) { // XXX TODO need to have a UI-based options screen for such choices
+		auto cacheMb = ::getenv("NN_INSIGHT_DEQUANTIZED_CACHE_MB"); // dequantized weights kept when they aren't in use
+		model.reset(cacheMb ? new ModelViews::MergeDequantizeOperators(model.release(), (size_t)std::stoul(cacheMb)*1024*1024)
+		                    : new ModelViews::MergeDequantizeOperators(model.release()));
+	}
+
+	// add ModelViews::FuseOperators
+	if (Options::get().getFuseOperators())
+		model.reset(new ModelViews::FuseOperators(model.release()));
 
 	// render the model as SVG image
 	nnWidget.open(model.get());
@@ -972,8 +1083,12 @@ bool MainWindow::loadModelFile(const QString &filePath) {
 }
 
 void MainWindow::loadInMemoryModel(PluginInterface::Model *inMemoryModel, const char *name) { // accepts ownership
+	// the computation in progress uses the previous model
+	cancelComputation();
+
 	// save the model
 	model.reset(inMemoryModel);
+	computePlan.reset(nullptr);
 
 	// render the model as SVG image
 	nnWidget.open(model.get());
@@ -1061,7 +1176,7 @@ void MainWindow::showOperatorDetails(PluginInterface::OperatorId operatorId) {
 			nnOperatorDetailsLayout.addWidget(label,         row,   3/*column*/);
 			// button
 			auto hasStaticData = model->getTensorHasData(tensorId);
-			if (hasStaticData || (tensorData && (*tensorData.get())[tensorId])) {
+			if (hasStaticData || (tensorData && (*tensorData.get())[tensorId]) || isTensorDiscarded(tensorId)) {
 				auto button = new SvgPushButton(SvgGraphics::generateTableIcon(), &nnOperatorDetails);
 				button->setContentsMargins(0,0,0,0);
 				button->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
@@ -1166,6 +1281,8 @@ void MainWindow::showTensorDetails(PluginInterface::TensorId tensorId, const cha
 		nnCurrentTensorId = tensorId;
 		if (nnTensorData2D)
 			clearNnTensorData2D();
+		if (isTensorDiscarded(nnCurrentTensorId))
+			recomputeDiscardedTensor(nnCurrentTensorId);
 		if (model->getTensorHasData(nnCurrentTensorId) || (tensorData && (*tensorData)[nnCurrentTensorId]))
 			showNnTensorData2D();
 	}
@@ -1242,12 +1359,15 @@ void MainWindow::clearInputImageDisplay() {
 	sourceTensorDataAsLoaded = nullptr;
 	sourceTensorDataAsUsed = nullptr;
 	sourceTensorShape = TensorShape();
+	cancelComputation();
 	tensorData.reset(nullptr);
 	scaleImageWidthPct = 0;
 	scaleImageHeightPct = 0;
 }
 
 void MainWindow::clearComputedTensorData(HowLong howLong) {
+	// results of the computation in progress would be invalid too
+	cancelComputation();
 	// clear table-like display of data about to be invalidated
 	if (howLong == Temporary) {
 		if (nnTensorData2D && model->isTensorComputed(nnCurrentTensorId))
@@ -1258,6 +1378,82 @@ void MainWindow::clearComputedTensorData(HowLong howLong) {
 	tensorData.reset(nullptr);
 }
 
+void MainWindow::cancelComputation() { // stops the computation in progress, if any, and waits for its thread to finish
+	if (!computeThread)
+		return;
+	computeGeneration++; // notifications that are still queued are ignored
+	computeThread->cancel();
+	computeThread->wait(); // operators that are already running finish
+	computeThread.reset(nullptr);
+	computeButton.setText(tr("Compute"));
+	computeProgressBar.hide();
+}
+
+bool MainWindow::isTensorDiscarded(PluginInterface::TensorId tensorId) const { // computed, but not kept by the retention policy: it can be recomputed
+	return tensorData && !(*tensorData)[tensorId] && (!computeThread || computeThread->recomputesOnly()) && computePlan && computePlan->recomputable && model->isTensorComputed(tensorId);
+}
+
+void MainWindow::recomputeDiscardedTensor(PluginInterface::TensorId tensorId) { // on the computation thread, the tensor is shown when it arrives
+	assert(isTensorDiscarded(tensorId));
+	if (computeThread)
+		return; // another tensor is being recomputed, the finished recomputation starts the one on screen
+	// only the viewed tensor is kept besides retained ones
+	for (PluginInterface::TensorId tid = 0; tid < retainedTensors.size(); tid++)
+		if (!retainedTensors[tid] && model->isTensorComputed(tid))
+			(*tensorData)[tid].reset();
+	computeThread.reset(new ComputeThread(this, model.get(), computePlan, *tensorData, tensorId));
+	auto generation = ++computeGeneration;
+	connect(computeThread.get(), &ComputeThread::tensorRecomputed, this, [this,generation](PluginInterface::TensorId tensorId) {
+		if (generation == computeGeneration)
+			showRecomputedTensor(tensorId);
+	}, Qt::QueuedConnection);
+	connect(computeThread.get(), &ComputeThread::warningMessage, this, [this,generation](const QString &msg) {
+		if (generation == computeGeneration)
+			Util::warningOk(this, msg);
+	}, Qt::QueuedConnection);
+	connect(computeThread.get(), &ComputeThread::finished, this, [this,generation]() {
+		if (generation != computeGeneration)
+			return; // the recomputation was cancelled
+		bool succ = computeThread->succeeded();
+		computeThread.reset(nullptr);
+		if (!succ) {
+			PRINT("WARNING recomputation didn't succeed")
+			return;
+		}
+		// another tensor could have been selected while this one was recomputed
+		if (nnCurrentTensorId >= 0 && isTensorDiscarded(nnCurrentTensorId))
+			recomputeDiscardedTensor(nnCurrentTensorId);
+	}, Qt::QueuedConnection);
+	computeThread->start();
+}
+
+void MainWindow::showRecomputedTensor(PluginInterface::TensorId tensorId) {
+	if ((int)tensorId != nnCurrentTensorId)
+		return; // another tensor is on screen now, only the viewed tensor is kept besides retained ones
+	(*tensorData)[tensorId] = computeThread->getTensorData(tensorId);
+	if (!nnTensorData2D) {
+		showNnTensorData2D();
+	} else {
+		nnTensorData2D->dataChanged((*tensorData.get())[nnCurrentTensorId].get());
+		nnTensorData2D->setEnabled(true);
+	}
+}
+
+void MainWindow::showComputeProfile(const Compute::Profile &profile) {
+	// operators list: times, achieved performance and memory traffic
+	nnNetworkOperatorsListWidget.setProfile(profile);
+
+	// graph: operators are tinted by their share of the time of the slowest operator
+	double maxTime = 0;
+	for (auto &p : profile)
+		maxTime = std::max(maxTime, p.time);
+	std::vector<float> heat(model->numOperators(), 0);
+	if (maxTime > 0)
+		for (auto &p : profile)
+			heat[p.oid] = p.time/maxTime;
+	nnWidget.setOperatorHeat(heat);
+}
+
 void MainWindow::effectsChanged() {
 	inputParamsChanged(); // effects change invalidates computation results
 
@@ -1269,7 +1465,7 @@ void MainWindow::effectsChanged() {
 
 	// any effects to apply?
 	if (flipHorizontally || flipVertically || makeGrayscale || !std::get<1>(convolution).empty()) {
-		sourceTensorDataAsUsed.reset(applyEffects(sourceTensorDataAsLoaded.get(), sourceTensorShape,
+		sourceTensorDataAsUsed.reset(Image::applyEffects(sourceTensorDataAsLoaded.get(), sourceTensorShape,
 			flipHorizontally, flipVertically, makeGrayscale, convolution,sourceEffectConvolutionCountComboBox.currentData().toUInt()));
 	} else {
 		sourceTensorDataAsUsed = sourceTensorDataAsLoaded;
@@ -1289,74 +1485,6 @@ void MainWindow::inputParamsChanged() {
 	updateResultInterpretation();
 }
 
-float* MainWindow::applyEffects(const float *image, const TensorShape &shape,
-	bool flipHorizontally, bool flipVertically, bool makeGrayscale,
-	const std::tuple<TensorShape,std::vector<float>> &convolution, unsigned convolutionCount) const
-{
-	assert(shape.size()==3);
-	assert(flipHorizontally || flipVertically || makeGrayscale || !std::get<1>(convolution).empty());
-
-	unsigned idx = 0; // idx=0 is "image", idx can be 0,1,2
-	std::unique_ptr<float> withEffects[2]; // idx=1 and idx=2 are allocatable "images"
-
-	auto idxNext = [](unsigned idx) {
-		return (idx+1)<3 ? idx+1 : 1;
-	};
-	auto src = [&](unsigned idx) {
-		if (idx==0)
-			return image;
-		else
-			return (const float*)withEffects[idx-1].get();
-	};
-	auto dst = [&](unsigned idx) {
-		auto &we = withEffects[idxNext(idx)-1];
-		if (!we)
-			we.reset(new float[Tensor::flatSize(shape)]);
-		return we.get();
-	};
-
-	if (flipHorizontally) {
-		Image::flipHorizontally(shape, src(idx), dst(idx));
-		idx = idxNext(idx);
-	}
-	if (flipVertically) {
-		Image::flipVertically(shape, src(idx), dst(idx));
-		idx = idxNext(idx);
-	}
-	if (makeGrayscale) {
-		Image::makeGrayscale(shape, src(idx), dst(idx));
-		idx = idxNext(idx);
-	}
-	if (!std::get<1>(convolution).empty()) {
-		TensorShape shapeWithBatch = shape;
-		shapeWithBatch.insert(shapeWithBatch.begin(), 1/*batch*/);
-		auto clip = [](float *a, size_t sz) {
-			for (auto ae = a+sz; a<ae; a++)
-				if (*a < 0.)
-					*a = 0.;
-				else if (*a > 255.)
-					*a = 255.;
-		};
-		const static float bias[3] = {0,0,0};
-		for (unsigned i = 1; i <= convolutionCount; i++) {
-			float *d = dst(idx);
-			NnOperators::Conv2D(
-				shapeWithBatch, src(idx),
-				std::get<0>(convolution), std::get<1>(convolution).data(),
-				{3}, bias, // no bias
-				shapeWithBatch, d,
-				std::get<0>(convolution)[2]/2, std::get<0>(convolution)[1]/2, // padding, paddings not matching kernel size work but cause image shifts
-				1,1, // strides
-				1,1  // dilation factors
-			);
-			clip(d, Tensor::flatSize(shapeWithBatch)); // we have to clip the result because otherwise some values are out of range 0..255.
-			idx = idxNext(idx);
-		}
-	}
-
-	return withEffects[idx-1].release();
-}
-
 void MainWindow::clearEffects() {
 	sourceEffectFlipHorizontallyCheckBox.setChecked(false);
 	sourceEffectFlipVerticallyCheckBox  .setChecked(false);
@@ -1652,6 +1780,7 @@ void MainWindow::closeNeuralNetwork() {
 	nnNetworkOperatorsListWidget.clearNnModel();
 	pluginInterface.reset(nullptr);
 	PluginManager::unloadPlugin(plugin);
+	computePlan.reset(nullptr);
 	model = nullptr;
 	plugin = nullptr;
 	// update screen
@@ -1691,7 +1820,14 @@ void MainWindow::showNnTensorData2D() {
 			));
 			break;
 		case PluginInterface::DataType_Int8:
-			assert(!model->isTensorComputed(nnCurrentTensorId)); // we don't yet support computed tensors of the type int8 because tensorData always has float32
+			if (model->isTensorComputed(nnCurrentTensorId)) { // computed quantized tensors have their real values in tensorData
+				nnTensorData2D.reset(new DataTable2D<float>(
+					model->getTensorShape(nnCurrentTensorId),
+					(*tensorData.get())[nnCurrentTensorId].get(),
+					&nnTensorDetails
+				));
+				break;
+			}
 			nnTensorData2D.reset(new DataTable2D<int8_t>(
 				model->getTensorShape(nnCurrentTensorId),
 				static_cast<const int8_t*>(model->getTensorData(nnCurrentTensorId)),
@@ -1699,7 +1835,14 @@ void MainWindow::showNnTensorData2D() {
 			));
 			break;
 		case PluginInterface::DataType_UInt8:
-			assert(!model->isTensorComputed(nnCurrentTensorId)); // we don't yet support computed tensors of the type uint8 because tensorData always has float32
+			if (model->isTensorComputed(nnCurrentTensorId)) { // computed quantized tensors have their real values in tensorData
+				nnTensorData2D.reset(new DataTable2D<float>(
+					model->getTensorShape(nnCurrentTensorId),
+					(*tensorData.get())[nnCurrentTensorId].get(),
+					&nnTensorDetails
+				));
+				break;
+			}
 			nnTensorData2D.reset(new DataTable2D<uint8_t>(
 				model->getTensorShape(nnCurrentTensorId),
 				static_cast<const uint8_t*>(model->getTensorData(nnCurrentTensorId)),
@@ -12,6 +12,7 @@
 #include <QMenu>
 #include <QMenuBar>
 #include <QPixmap>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QRectF>
 #include <QScrollArea>
@@ -30,6 +31,8 @@ class QCloseEvent;
 #include "operators-list-widget.h"
 #include "scale-image-widget.h"
 
+#include "compute.h"
+#include "compute-thread.h"
 #include "nn-types.h"
 #include "plugin-manager.h"
 #include "plugin-interface.h"
@@ -96,6 +99,7 @@ private: // fields
 	QHBoxLayout                                computeLayout;
 	QPushButton                                computeButton;
 	QComboBox                                  computeRegionComboBox;
+	QProgressBar                               computeProgressBar; // only visible while the computation is in progress
 	QWidget                                  computeByWidget;
 	QHBoxLayout                                computeByLayout;
 	QLabel                                     inputNormalizationLabel;
@@ -177,6 +181,10 @@ private: // fields
 	std::unique_ptr<PluginInterface>               pluginInterface; // the file is opened through this handle
 	std::unique_ptr<const PluginInterface::Model>  model;     // the model from the file that is currently open XXX need to lose "const", also see TrainingWidget in main-window.cpp
 	float                                          modelPendingTrainingDerivativesCoefficient; // coefficient that all derivatives should be multiplied by
+	std::unique_ptr<Compute::Plan>                 computePlan; // the model compiled for computation, created on the first computation
+	std::unique_ptr<ComputeThread>                 computeThread; // the computation in progress
+	unsigned                                       computeGeneration; // incremented when the computation is cancelled: notifications that are still queued are ignored
+	std::vector<bool>                              retainedTensors; // computed tensors that the retention policy keeps, by tensor, empty when all are kept
 
 	// data associated with a specific input data (image) currently loaded by the user (static tensors from the model aren't here)
 	TensorShape                      sourceTensorShape;
@@ -209,12 +217,14 @@ private: // private methods
 	void openImagePixmap(const QPixmap &imagePixmap, const QString &sourceName);
 	void clearInputImageDisplay();
 	void clearComputedTensorData(HowLong howLong);
+	void cancelComputation();
+	void showComputeProfile(const Compute::Profile &profile);
+	bool isTensorDiscarded(PluginInterface::TensorId tensorId) const;
+	void recomputeDiscardedTensor(PluginInterface::TensorId tensorId);
+	void showRecomputedTensor(PluginInterface::TensorId tensorId);
 	void effectsChanged();
 	void inputNormalizationChanged();
 	void inputParamsChanged();
-	float* applyEffects(const float *image, const TensorShape &shape,
-		bool flipHorizontally, bool flipVertically, bool makeGrayscale,
-		const std::tuple<TensorShape,std::vector<float>> &convolution, unsigned convolutionCount) const;
 	void clearEffects();
 	void updateNetworkDetailsPage();
 	void updateSourceImageOnScreen();
@@ -5,6 +5,8 @@
 #include "plugin-interface.h"
 #include "plugin-manager.h"
 #include "misc.h"
+#include "options.h"
+#include "thread-pool.h"
 
 #include "svg-graphics-generator.h"
 
@@ -23,6 +25,8 @@ int main(int argc, char **argv) {
 
 	QApplication app(argc, argv);
 
+	ThreadPool::setNumThreads(Options::get().getNumComputeThreads());
+
 	std::unique_ptr<MainWindow> mainWindow(new MainWindow);
 	mainWindow->loadModelFile(argv[1]);
 	mainWindow->show();
@@ -0,0 +1,87 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "memory-planner.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <tuple>
+#include <vector>
+
+#include <assert.h>
+
+namespace MemoryPlanner {
+
+static size_t alignUp(size_t size) {
+	return (size + Alignment - 1) & ~(Alignment - 1);
+}
+
+void planArena(const std::vector<TensorLifetime> &lifetimes, bool reuse, ArenaPlan &plan,
+	const std::function<bool(unsigned i1, unsigned i2)> &ordered)
+{
+	plan.offsets.resize(lifetimes.size());
+	plan.arenaSize = 0;
+	plan.naiveSize = 0;
+
+	for (auto &l : lifetimes)
+		plan.naiveSize += alignUp(l.size);
+
+	if (!reuse) {
+		// sequential placement, nothing is shared
+		for (unsigned i = 0, ie = lifetimes.size(); i < ie; i++) {
+			plan.offsets[i] = plan.arenaSize;
+			plan.arenaSize += alignUp(lifetimes[i].size);
+		}
+		return;
+	}
+
+	// place larger tensors first: they are the hardest to fit into gaps
+	std::vector<unsigned> order(lifetimes.size());
+	for (unsigned i = 0, ie = order.size(); i < ie; i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&lifetimes](unsigned i1, unsigned i2) {
+		return lifetimes[i1].size > lifetimes[i2].size;
+	});
+
+	std::vector<unsigned> placed;
+	std::vector<std::tuple<size_t,size_t>> busy; // (offset,size) of placed tensors that are alive at the same time
+	for (auto i : order) {
+		auto &l = lifetimes[i];
+		auto size = alignUp(l.size);
+
+		// collect regions used by the tensors that overlap in time
+		busy.clear();
+		for (auto j : placed)
+			if ((lifetimes[j].first <= l.last && l.first <= lifetimes[j].last) ||
+			    (ordered && !(lifetimes[j].last < l.first ? ordered(j, i) : ordered(i, j))))
+				busy.push_back({plan.offsets[j], alignUp(lifetimes[j].size)});
+		std::sort(busy.begin(), busy.end());
+
+		// find the smallest gap that fits
+		size_t bestOffset = std::numeric_limits<size_t>::max(), bestGap = std::numeric_limits<size_t>::max();
+		size_t offset = 0;
+		for (auto &b : busy) {
+			if (std::get<0>(b) >= offset + size && std::get<0>(b) - offset < bestGap) {
+				bestOffset = offset;
+				bestGap = std::get<0>(b) - offset;
+			}
+			offset = std::max(offset, std::get<0>(b) + std::get<1>(b));
+		}
+		if (bestOffset == std::numeric_limits<size_t>::max())
+			bestOffset = offset; // after all busy regions
+
+		plan.offsets[i] = bestOffset;
+		plan.arenaSize = std::max(plan.arenaSize, bestOffset + size);
+		placed.push_back(i);
+	}
+}
+
+std::shared_ptr<uint8_t> allocateArena(size_t size) {
+	auto arena = static_cast<uint8_t*>(std::aligned_alloc(Alignment, std::max(alignUp(size), Alignment)));
+	if (!arena)
+		throw std::bad_alloc();
+	return std::shared_ptr<uint8_t>(arena, [](uint8_t *p) {std::free(p);});
+}
+
+}
@@ -0,0 +1,36 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace MemoryPlanner {
+
+// all arena offsets and the arena itself are aligned to the cache line size (also suitable for any SIMD width)
+constexpr size_t Alignment = 64;
+
+struct TensorLifetime {
+	size_t   size;  // in bytes
+	unsigned first; // step that produces the tensor
+	unsigned last;  // last step that uses the tensor
+};
+
+struct ArenaPlan {
+	std::vector<size_t> offsets;   // one per lifetime
+	size_t              arenaSize; // planned peak memory use
+	size_t              naiveSize; // memory that would be used if every tensor had its own allocation
+};
+
+// Places tensors with lifetimes into one arena. With reuse=true tensors whose lifetimes don't overlap
+// can share the same memory (greedy by size, best fit), otherwise every tensor gets its own region.
+// When steps can run concurrently, 'ordered(i1,i2)' tells whether the tensor i1 is surely dead before the tensor i2 is produced.
+void planArena(const std::vector<TensorLifetime> &lifetimes, bool reuse, ArenaPlan &plan,
+	const std::function<bool(unsigned i1, unsigned i2)> &ordered = nullptr);
+
+std::shared_ptr<uint8_t> allocateArena(size_t size);
+
+}
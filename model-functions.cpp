@@ -77,20 +77,38 @@ size_t computeModelFlops(const PluginInterface::Model *model) {
 size_t computeOperatorFlops(const PluginInterface::Model *model, PluginInterface::OperatorId operatorId) {
 	std::vector<PluginInterface::TensorId> inputs, outputs;
 	model->getOperatorIo(operatorId, inputs, outputs);
+	auto intOption = [model,operatorId](PluginInterface::OperatorOptionName name) {
+		std::unique_ptr<PluginInterface::OperatorOptionsList> opts(model->getOperatorOptions(operatorId));
+		if (opts)
+			for (auto &o : *opts)
+				if (o.name == name)
+					return o.value.as<int32_t>();
+		return 0;
+	};
 	switch (model->getOperatorKind(operatorId)) {
-	case PluginInterface::KindConv2D: {
-		auto shapeImage = model->getTensorShape(inputs[0]);
+	case PluginInterface::KindConv2D:
+	case PluginInterface::KindDepthwiseConv2D: {
+		auto shapeOutput = model->getTensorShape(outputs[0]);
 		auto shapeWeights = model->getTensorShape(inputs[1]);
-		assert(shapeImage.size() == 4 && shapeImage[0] == 1);
+		assert(shapeOutput.size() == 4 && shapeOutput[0] == 1);
 		assert(shapeWeights.size() == 4);
-		return Tensor::flatSize(shapeWeights)*(shapeImage[1]*shapeImage[2]); // TODO add summations, strides, pads
+		return Tensor::flatSize(shapeWeights)*(shapeOutput[1]*shapeOutput[2]); // multiply-adds of every output pixel, taps over the padding are counted too
 	} case PluginInterface::KindFullyConnected: {
 		auto shapeWeights = model->getTensorShape(inputs[1]);
 		assert(shapeWeights.size() == 2);
 		return Tensor::flatSize(shapeWeights); // add summations, strides, pads
-	} case PluginInterface::KindLocalResponseNormalization: {
-		return 0; // TODO
-	} case PluginInterface::KindAdd:
+	} case PluginInterface::KindMaxPool:
+	  case PluginInterface::KindAveragePool:
+		return Tensor::flatSize(model->getTensorShape(outputs[0]))*intOption(PluginInterface::OperatorOption_FILTER_WIDTH)*intOption(PluginInterface::OperatorOption_FILTER_HEIGHT);
+	  case PluginInterface::KindLocalResponseNormalization:
+		return (2*intOption(PluginInterface::OperatorOption_RADIUS)+1 + 25)*Tensor::flatSize(model->getTensorShape(inputs[0])); // squares in the window, and the expensive pow
+	  case PluginInterface::KindSoftmax:
+		return 12*Tensor::flatSize(model->getTensorShape(inputs[0])); // exp is expensive, maybe 10X, then the sum and the division
+	  case PluginInterface::KindResizeBilinear:
+		return 4*Tensor::flatSize(model->getTensorShape(outputs[0])); // four weighted input values for each output value
+	  case PluginInterface::KindMean:
+		return Tensor::flatSize(model->getTensorShape(inputs[0]));
+	  case PluginInterface::KindAdd:
 	  case PluginInterface::KindRelu:
 	  case PluginInterface::KindRelu6:
 	  case PluginInterface::KindSub:
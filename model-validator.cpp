@@ -31,16 +31,19 @@ bool validate(const PluginInterface::Model *model, std::ostream &os) {
 				auto const biasShape    = model->getTensorShape(inputs[2]);
 				auto const outputShape  = model->getTensorShape(outputs[0]);
 
-				if (inputShape.size()<2 || inputShape[0]!=1)
-					addError(STR("Operator#" << oid << " (" << model->getOperatorKind(oid) << "): has wrong input shape: " << inputShape << ", expected [1,N1{,...}]"));
-				if (inputShape.size()!=2 || inputShape[0]!=1)
-					addError(STR("Operator#" << oid << " (" << model->getOperatorKind(oid) << "): has wrong output shape: " << outputShape << ", expected [1,N]"));
-				if (weightsShape.size()!=2 || weightsShape[0]!=Tensor::flatSize(outputShape) || weightsShape[1]!=Tensor::flatSize(inputShape))
+				// the first dimension is the batch: B samples of N1{,...} values produce B samples of N values
+				if (inputShape.size()<2 || inputShape[0]==0)
+					addError(STR("Operator#" << oid << " (" << model->getOperatorKind(oid) << "): has wrong input shape: " << inputShape << ", expected [B,N1{,...}]"));
+				if (outputShape.size()!=2 || (inputShape.size()>=2 && outputShape[0]!=inputShape[0]))
+					addError(STR("Operator#" << oid << " (" << model->getOperatorKind(oid) << "): has wrong output shape: " << outputShape << ", expected [B,N]"));
+				auto batches = inputShape.empty() || inputShape[0]==0 ? 1 : inputShape[0];
+				auto inputSize = Tensor::flatSize(inputShape)/batches, outputSize = Tensor::flatSize(outputShape)/batches;
+				if (weightsShape.size()!=2 || weightsShape[0]!=outputSize || weightsShape[1]!=inputSize)
 					addError(STR("Operator#" << oid << " (" << model->getOperatorKind(oid) << "): has wrong weights shape: "
-					             << weightsShape << ", expected [" << Tensor::flatSize(outputShape) << "," << Tensor::flatSize(inputShape) << "]"));
-				if (!(biasShape.size()==0/*no-bias operator (is this legit?)*/ || (biasShape.size()==1 && biasShape[0]==Tensor::flatSize(outputShape))))
+					             << weightsShape << ", expected [" << outputSize << "," << inputSize << "]"));
+				if (!(biasShape.size()==0/*no-bias operator (is this legit?)*/ || (biasShape.size()==1 && biasShape[0]==outputSize)))
 					addError(STR("Operator#" << oid << " (" << model->getOperatorKind(oid) << "): has wrong bias shape: "
-					             << biasShape << ", expected [" << Tensor::flatSize(outputShape) << "]"));
+					             << biasShape << ", expected [" << outputSize << "]"));
 			}
 			break;
 		} default:
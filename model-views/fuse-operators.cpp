@@ -0,0 +1,335 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "fuse-operators.h"
+
+#include "../misc.h"
+#include "../model-functions.h"
+#include "../tensor.h"
+#include "../util.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <assert.h>
+
+namespace ModelViews {
+
+typedef PluginInterface PI;
+
+/// local helpers
+
+static std::unique_ptr<PI::OperatorOptionsList> copyOptions(const PI::OperatorOptionsList *options) {
+	return std::unique_ptr<PI::OperatorOptionsList>(options ? new PI::OperatorOptionsList(*options) : new PI::OperatorOptionsList);
+}
+
+static const PI::OperatorOptionValue* findOption(const PI::OperatorOptionsList &options, PI::OperatorOptionName name) {
+	for (auto &o : options)
+		if (o.name == name)
+			return &o.value;
+	return nullptr;
+}
+
+static void setOption(PI::OperatorOptionsList &options, PI::OperatorOptionName name, PI::OperatorOptionValue value) {
+	for (auto &o : options)
+		if (o.name == name) {
+			o.value = value;
+			return;
+		}
+	options.push_back({name, value});
+}
+
+static PI::ActivationFunction getActivationFunction(const PI::OperatorOptionsList &options) {
+	auto value = findOption(options, PI::OperatorOption_FUSED_ACTIVATION_FUNCTION);
+	return value ? value->activationFunction : PI::ActivationFunction_NONE;
+}
+
+static int getIntOption(const PI::OperatorOptionsList &options, PI::OperatorOptionName name, int dflt) {
+	auto value = findOption(options, name);
+	return value ? value->i : dflt;
+}
+
+/// FuseOperators
+
+FuseOperators::FuseOperators(const PluginInterface::Model *original_)
+: original(original_)
+{
+	// start with all operators of the original model
+	auto numOriginalOperators = original->numOperators();
+	operators.resize(numOriginalOperators);
+	for (PI::OperatorId oid = 0; oid < numOriginalOperators; oid++) {
+		operators[oid].original = oid;
+		original->getOperatorIo(oid, operators[oid].inputs, operators[oid].outputs);
+	}
+
+	// intermediate tensors can only be eliminated when their only consumer is the fused operator
+	std::vector<int> tensorProducers;
+	std::vector<std::vector<PI::OperatorId>> tensorConsumers;
+	ModelFunctions::indexOperatorsByTensors(original.get(), tensorProducers, tensorConsumers);
+	auto modelOutputs = original->getOutputs();
+	auto soleConsumer = [&](PI::TensorId tid) -> int {
+		if (tensorConsumers[tid].size() != 1 || std::find(modelOutputs.begin(), modelOutputs.end(), tid) != modelOutputs.end())
+			return -1;
+		return tensorConsumers[tid][0];
+	};
+	auto tensorBytes = [this](PI::TensorId tid) {
+		return Tensor::flatSize(original->getTensorShape(tid))*sizeof(float);
+	};
+
+	// fuse: operators are in the order of execution, so producers are seen before their consumers
+	std::vector<bool> fused(numOriginalOperators, false);
+	for (PI::OperatorId oid = 0; oid < numOriginalOperators; oid++) {
+		if (fused[oid])
+			continue;
+		auto &op = operators[oid];
+		switch (original->getOperatorKind(oid)) {
+		case PI::KindPad: {
+			auto consumer = soleConsumer(op.outputs[0]);
+			if (consumer == -1)
+				break;
+			auto consumerKind = original->getOperatorKind(consumer);
+			if ((consumerKind == PI::KindConv2D || consumerKind == PI::KindDepthwiseConv2D) && fusePad(op, operators[consumer])) {
+				fused[oid] = true;
+				numEliminatedBytes += tensorBytes(op.outputs[0]);
+			}
+			break;
+		} case PI::KindConv2D:
+		  case PI::KindDepthwiseConv2D:
+		  case PI::KindFullyConnected: {
+			while (true) { // fold a chain of scales and shifts
+				auto consumer = soleConsumer(op.outputs[0]);
+				if (consumer == -1)
+					break;
+				auto consumerKind = original->getOperatorKind(consumer);
+				if (consumerKind != PI::KindMul && consumerKind != PI::KindAdd && consumerKind != PI::KindSub)
+					break;
+				auto intermediate = op.outputs[0];
+				if (!foldAffine(op, operators[consumer]))
+					break;
+				fused[consumer] = true;
+				numEliminatedBytes += tensorBytes(intermediate);
+			}
+			break;
+		} default:
+			break;
+		}
+	}
+
+	// remove fused operators
+	unsigned idx = 0;
+	for (PI::OperatorId oid = 0; oid < numOriginalOperators; oid++)
+		if (fused[oid])
+			numFusedOperators++;
+		else if (idx++ != oid)
+			operators[idx - 1] = std::move(operators[oid]);
+	operators.resize(idx);
+
+	// print a notice to the user
+	PRINT("FuseOperators: fused " << numFusedOperators << " operators out of a total of " << numOriginalOperators << " operators in a model,"
+	      " " << Util::formatUIntHumanReadable(numEliminatedBytes) << " bytes of intermediate tensors are eliminated")
+}
+
+unsigned FuseOperators::numInputs() const {
+	return original->numInputs();
+}
+
+std::vector<PI::TensorId> FuseOperators::getInputs() const {
+	return original->getInputs();
+}
+
+unsigned FuseOperators::numOutputs() const {
+	return original->numOutputs();
+}
+
+std::vector<PI::TensorId> FuseOperators::getOutputs() const {
+	return original->getOutputs();
+}
+
+unsigned FuseOperators::numOperators() const {
+	return operators.size();
+}
+
+void FuseOperators::getOperatorIo(unsigned operatorIdx, std::vector<PI::TensorId> &inputs, std::vector<PI::TensorId> &outputs) const {
+	inputs = operators[operatorIdx].inputs;
+	outputs = operators[operatorIdx].outputs;
+}
+
+PI::OperatorKind FuseOperators::getOperatorKind(unsigned operatorIdx) const {
+	return original->getOperatorKind(operators[operatorIdx].original);
+}
+
+PI::OperatorOptionsList* FuseOperators::getOperatorOptions(unsigned operatorIdx) const {
+	auto &op = operators[operatorIdx];
+	return op.options ? new PI::OperatorOptionsList(*op.options) : original->getOperatorOptions(op.original);
+}
+
+unsigned FuseOperators::numTensors() const {
+	return original->numTensors() + foldedTensors.size();
+}
+
+TensorShape FuseOperators::getTensorShape(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? folded(tensorId).shape : original->getTensorShape(tensorId);
+}
+
+PI::DataType FuseOperators::getTensorType(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? PI::DataType_Float32 : original->getTensorType(tensorId);
+}
+
+std::string FuseOperators::getTensorName(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? folded(tensorId).name : original->getTensorName(tensorId);
+}
+
+bool FuseOperators::getTensorHasData(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? true : original->getTensorHasData(tensorId);
+}
+
+const void* FuseOperators::getTensorData(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? folded(tensorId).data.get() : original->getTensorData(tensorId);
+}
+
+void* FuseOperators::getTensorDataWr(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? folded(tensorId).data.get() : original->getTensorDataWr(tensorId);
+}
+
+const float* FuseOperators::getTensorDataF32(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? folded(tensorId).data.get() : original->getTensorDataF32(tensorId);
+}
+
+std::shared_ptr<const float> FuseOperators::getTensorDataF32Shared(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? PI::Model::getTensorDataF32Shared(tensorId) : original->getTensorDataF32Shared(tensorId);
+}
+
+bool FuseOperators::getTensorIsVariableFlag(PI::TensorId tensorId) const {
+	return isFolded(tensorId) ? false : original->getTensorIsVariableFlag(tensorId);
+}
+
+bool FuseOperators::getTensorQuantization(PI::TensorId tensorId, PI::TensorQuantization &quantization) const {
+	return isFolded(tensorId) ? false : original->getTensorQuantization(tensorId, quantization); // folded tensors are float32
+}
+
+/// internals
+
+PI::TensorId FuseOperators::addFoldedTensor(PI::TensorId like, const float *data) {
+	auto shape = getTensorShape(like);
+	auto size = Tensor::flatSize(shape);
+	std::unique_ptr<float[]> copy(new float[size]);
+	std::memcpy(copy.get(), data, size*sizeof(float));
+	foldedTensors.push_back({STR(getTensorName(like) << " (folded)"), shape, std::move(copy)});
+	return numTensors() - 1;
+}
+
+// Pad with zeros along height and width followed by a convolution: the convolution pads its input itself
+bool FuseOperators::fusePad(Operator &pad, Operator &conv) {
+	if (pad.inputs.size() != 2 || conv.inputs[0] != pad.outputs[0])
+		return false;
+	auto paddingsTid = pad.inputs[1];
+	if (!getTensorHasData(paddingsTid) || getTensorType(paddingsTid) != PI::DataType_Int32 || getTensorShape(paddingsTid) != TensorShape{4,2})
+		return false;
+	auto paddings = static_cast<const std::array<int32_t,2>*>(getTensorData(paddingsTid));
+	if (paddings[0] != std::array<int32_t,2>{0,0} || paddings[3] != std::array<int32_t,2>{0,0})
+		return false;
+
+	auto options = copyOptions(conv.options ? conv.options.get() : std::unique_ptr<PI::OperatorOptionsList>(original->getOperatorOptions(conv.original)).get());
+	auto inputShape = getTensorShape(pad.inputs[0]), paddedShape = getTensorShape(pad.outputs[0]);
+	auto filterShape = getTensorShape(conv.inputs[1]), outputShape = getTensorShape(conv.outputs[0]);
+	if (inputShape.size() != 4 || filterShape.size() != 4 || outputShape.size() != 4)
+		return false;
+
+	// the convolution computes its padding from shapes (see computePaddingValues): the leading padding should stay the same
+	bool padded = false;
+	for (unsigned dim : {1, 2}) {
+		int stride   = getIntOption(*options, dim==1 ? PI::OperatorOption_STRIDE_H : PI::OperatorOption_STRIDE_W, 1);
+		int dilation = getIntOption(*options, dim==1 ? PI::OperatorOption_DILATION_H_FACTOR : PI::OperatorOption_DILATION_W_FACTOR, 1);
+		int effectiveFilterSize = ((int)filterShape[dim] - 1)*dilation + 1;
+		int totalBefore = ((int)outputShape[dim] - 1)*stride + effectiveFilterSize - (int)paddedShape[dim];
+		int totalAfter  = ((int)outputShape[dim] - 1)*stride + effectiveFilterSize - (int)inputShape[dim];
+		if (totalBefore < 0 || totalAfter < 0 || paddings[dim][0] + totalBefore/2 != totalAfter/2)
+			return false;
+		if (totalAfter > 0)
+			padded = true;
+	}
+
+	setOption(*options, PI::OperatorOption_PADDING, padded ? PI::PaddingType_SAME : PI::PaddingType_VALID);
+	conv.inputs[0] = pad.inputs[0];
+	conv.options = std::move(options);
+	return true;
+}
+
+// Mul, Add or Sub of the producer's output and a constant: the filter is scaled, the bias is scaled and shifted
+bool FuseOperators::foldAffine(Operator &producer, const Operator &affine) {
+	auto producerKind = original->getOperatorKind(producer.original), affineKind = original->getOperatorKind(affine.original);
+	if (producer.inputs.size() != 3 || affine.inputs.size() != 2 || affine.outputs.size() != 1)
+		return false;
+
+	// the producer: static float filter and bias, no activation function
+	auto filterTid = producer.inputs[1], biasTid = producer.inputs[2];
+	for (auto tid : {filterTid, biasTid})
+		if (!getTensorHasData(tid) || getTensorType(tid) != PI::DataType_Float32)
+			return false;
+	auto producerOptions = copyOptions(producer.options ? producer.options.get() : std::unique_ptr<PI::OperatorOptionsList>(original->getOperatorOptions(producer.original)).get());
+	if (getActivationFunction(*producerOptions) != PI::ActivationFunction_NONE)
+		return false;
+	if (producerKind == PI::KindFullyConnected && getIntOption(*producerOptions, PI::OperatorOption_WEIGHTS_FORMAT, 0) != 0)
+		return false;
+
+	// the constant: a scalar, or a vector along channels (the last dimension), and Sub only subtracts it
+	unsigned producerIdx = affine.inputs[0] == producer.outputs[0] ? 0 : 1;
+	assert(affine.inputs[producerIdx] == producer.outputs[0]);
+	auto constTid = affine.inputs[1 - producerIdx];
+	if (affineKind == PI::KindSub && producerIdx != 0)
+		return false;
+	if (!getTensorHasData(constTid) || getTensorType(constTid) != PI::DataType_Float32)
+		return false;
+	auto outputShape = getTensorShape(producer.outputs[0]), constShape = getTensorShape(constTid);
+	if (outputShape.empty() || getTensorShape(affine.outputs[0]) != outputShape)
+		return false;
+	auto numChannels = *outputShape.rbegin();
+	auto constSize = Tensor::flatSize(constShape);
+	if (!(constSize == 1 || (constSize == numChannels && *constShape.rbegin() == numChannels)))
+		return false;
+	if (Tensor::flatSize(getTensorShape(biasTid)) != numChannels)
+		return false;
+	auto constData = getTensorDataF32(constTid);
+	auto constAt = [constData,constSize](unsigned c) {return constData[constSize == 1 ? 0 : c];};
+
+	// folded tensors are altered in place, original tensors are copied first
+	auto writable = [this](PI::TensorId &tid) {
+		if (!isFolded(tid))
+			tid = addFoldedTensor(tid, getTensorDataF32(tid));
+		return foldedTensors[tid - original->numTensors()].data.get();
+	};
+	auto bias = writable(producer.inputs[2]);
+	switch (affineKind) {
+	case PI::KindMul: {
+		auto filter = writable(producer.inputs[1]);
+		auto filterSize = Tensor::flatSize(getTensorShape(producer.inputs[1]));
+		if (producerKind == PI::KindDepthwiseConv2D) // [1,KH,KW,C]: channels are the last dimension
+			for (size_t i = 0; i < filterSize; i++)
+				filter[i] *= constAt(i % numChannels);
+		else // [O,KH,KW,I] or [N,K]: channels are the first dimension
+			for (size_t i = 0, perChannel = filterSize/numChannels; i < filterSize; i++)
+				filter[i] *= constAt(i / perChannel);
+		for (unsigned c = 0; c < numChannels; c++)
+			bias[c] *= constAt(c);
+		break;
+	} case PI::KindAdd:
+		for (unsigned c = 0; c < numChannels; c++)
+			bias[c] += constAt(c);
+		break;
+	case PI::KindSub:
+		for (unsigned c = 0; c < numChannels; c++)
+			bias[c] -= constAt(c);
+		break;
+	default:
+		assert(false);
+	}
+
+	// the producer now computes the output of the affine operator with its activation function
+	std::unique_ptr<PI::OperatorOptionsList> affineOptions(original->getOperatorOptions(affine.original));
+	setOption(*producerOptions, PI::OperatorOption_FUSED_ACTIVATION_FUNCTION, affineOptions ? getActivationFunction(*affineOptions) : PI::ActivationFunction_NONE);
+	producer.options = std::move(producerOptions);
+	producer.outputs = affine.outputs;
+	return true;
+}
+
+} // ModelViews
@@ -0,0 +1,80 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "../plugin-interface.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ModelViews {
+
+//
+// FuseOperators presents the model with chains of operators rewritten into single operators:
+// * Pad → Conv2D/DepthwiseConv2D: zero padding becomes the padding of the convolution
+// * Conv2D/DepthwiseConv2D/FullyConnected → Mul/Add/Sub with constant scalars or per-channel vectors:
+//   the scale is folded into the filter and the bias, the shift is folded into the bias
+// Fused operators don't compute their intermediate tensors. Folded filters and biases are new static tensors
+// that follow the tensors of the original model, original tensors aren't altered.
+//
+
+class FuseOperators : public PluginInterface::Model {
+
+// types
+	typedef PluginInterface PI;
+	struct Operator {
+		PI::OperatorId                            original;
+		std::vector<PI::TensorId>                 inputs;
+		std::vector<PI::TensorId>                 outputs;
+		std::unique_ptr<PI::OperatorOptionsList>  options; // replaced options, or nullptr when they are those of the original operator
+	};
+	struct FoldedTensor {
+		std::string                               name;
+		TensorShape                               shape;
+		std::unique_ptr<float[]>                  data;
+	};
+
+// data
+	std::unique_ptr<const PluginInterface::Model> original;
+	std::vector<Operator>                         operators;
+	std::vector<FoldedTensor>                     foldedTensors; // their ids follow the tensors of the original model
+	unsigned                                      numFusedOperators = 0;   // operators of the original model that aren't present here
+	size_t                                        numEliminatedBytes = 0;  // intermediate tensors that aren't computed
+
+public:
+	FuseOperators(const PluginInterface::Model *original_);
+
+	unsigned getNumFusedOperators() const {return numFusedOperators;}
+	size_t getNumEliminatedBytes() const {return numEliminatedBytes;}
+
+public: // interface implementation
+	unsigned                    numInputs() const override;
+	std::vector<PI::TensorId>   getInputs() const override;
+	unsigned                    numOutputs() const override;
+	std::vector<PI::TensorId>   getOutputs() const override;
+	unsigned                    numOperators() const override;
+	void                        getOperatorIo(unsigned operatorIdx, std::vector<PI::TensorId> &inputs, std::vector<PI::TensorId> &outputs) const override;
+	PI::OperatorKind            getOperatorKind(unsigned operatorIdx) const override;
+	PI::OperatorOptionsList*    getOperatorOptions(unsigned operatorIdx) const override;
+	unsigned                    numTensors() const override;
+	TensorShape                 getTensorShape(PI::TensorId tensorId) const override;
+	PI::DataType                getTensorType(PI::TensorId tensorId) const override;
+	std::string                 getTensorName(PI::TensorId tensorId) const override;
+	bool                        getTensorHasData(PI::TensorId tensorId) const override;
+	const void*                 getTensorData(PI::TensorId tensorId) const override;
+	void*                       getTensorDataWr(PI::TensorId tensorId) const override;
+	const float*                getTensorDataF32(PI::TensorId tensorId) const override;
+	std::shared_ptr<const float> getTensorDataF32Shared(PI::TensorId tensorId) const override;
+	bool                        getTensorIsVariableFlag(PI::TensorId tensorId) const override;
+	bool                        getTensorQuantization(PI::TensorId tensorId, PI::TensorQuantization &quantization) const override;
+
+private: // internals
+	bool isFolded(PI::TensorId tensorId) const {return tensorId >= original->numTensors();}
+	const FoldedTensor& folded(PI::TensorId tensorId) const {return foldedTensors[tensorId - original->numTensors()];}
+	PI::TensorId addFoldedTensor(PI::TensorId like, const float *data);
+	bool fusePad(Operator &pad, Operator &conv);
+	bool foldAffine(Operator &producer, const Operator &affine);
+}; // FuseOperators
+
+} // ModelViews
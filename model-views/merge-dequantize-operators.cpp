@@ -4,23 +4,26 @@
 
 #include "../misc.h"
 #include "../tensor.h"
+#include "../thread-pool.h"
+
+#include <algorithm>
 
 #include <assert.h>
-#include <half.hpp>
 
 namespace ModelViews {
 
 typedef PluginInterface PI;
 
-MergeDequantizeOperators::MergeDequantizeOperators(const PluginInterface::Model *original_)
+MergeDequantizeOperators::MergeDequantizeOperators(const PluginInterface::Model *original_, size_t cacheBudget_)
 : original(original_),
-  tensorData(new std::vector<std::shared_ptr<const float>>)
+  cacheBudget(cacheBudget_)
 {
-	// find all dequantize operators and their tensor outputs
-	unsigned numDequantizeOperators = 0;
+	// find all dequantize operators and their tensor outputs, their data is converted later, when it's requested
+	unsigned numDequantizeOperators = 0, numFloat16 = 0;
 	tensorIsDequantizeInput  .resize(original->numTensors());
 	tensorIsDequantizeOutput .resize(original->numTensors());
-	tensorData              ->resize(original->numTensors());
+	dequantizeInputs         .resize(original->numTensors());
+	converted                .resize(original->numTensors());
 	for (PI::OperatorId oid = 0, oide = original->numOperators(); oid < oide; oid++)
 		if (original->getOperatorKind(oid) == PI::KindDequantize) {
 			std::vector<PI::TensorId> inputs, outputs;
@@ -34,15 +37,17 @@ MergeDequantizeOperators::MergeDequantizeOperators(const PluginInterface::Model
 				FAIL("MergeDequantizeOperators: Dequantize operator tensor types aren't consistent with Dequantize definition")
 			tensorIsDequantizeInput[inputs[0]] = true;
 			tensorIsDequantizeOutput[outputs[0]] = true;
-			(*tensorData)[outputs[0]].reset(convertStaticArrayToFloat32(
-				original->getTensorData(inputs[0]),
-				original->getTensorType(inputs[0]),
-				original->getTensorShape(inputs[0])
-			));
+			dequantizeInputs[outputs[0]] = inputs[0];
+			PI::TensorQuantization quantization;
+			if (original->getTensorType(inputs[0]) == PI::DataType_Float16)
+				numFloat16++; // kept as float16: compute kernels widen float16 weights themselves, which halves their memory
+			else if (!original->getTensorQuantization(inputs[0], quantization))
+				FAIL("MergeDequantizeOperators: Dequantize operator input of the type " << original->getTensorType(inputs[0]) << " isn't quantized")
 		} else
 			operatorMap.push_back(oid);
 	// print a notice to the user
-	PRINT("MergeDequantizeOperators: merged " << numDequantizeOperators << " operators out of a total of " << original->numOperators() << " operators in a model")
+	PRINT("MergeDequantizeOperators: merged " << numDequantizeOperators << " operators out of a total of " << original->numOperators() << " operators in a model"
+	      ", " << numFloat16 << " float16 tensors are kept as float16")
 }
 
 unsigned MergeDequantizeOperators::numInputs() const {
@@ -82,14 +87,13 @@ unsigned MergeDequantizeOperators::numTensors() const {
 }
 
 TensorShape MergeDequantizeOperators::getTensorShape(PI::TensorId tensorId) const {
-	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
-	return original->getTensorShape(tensorId);
+	return original->getTensorShape(tensorId); // also of Dequantize inputs: shapes of all tensors are collected by users
 }
 
 PI::DataType MergeDequantizeOperators::getTensorType(PI::TensorId tensorId) const {
 	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
 	if (tensorIsDequantizeOutput[tensorId])
-		return PI::DataType_Float32;
+		return isFloat16(tensorId) ? PI::DataType_Float16 : PI::DataType_Float32;
 	else
 		return original->getTensorType(tensorId);
 }
@@ -110,7 +114,10 @@ bool MergeDequantizeOperators::getTensorHasData(PI::TensorId tensorId) const {
 
 const void* MergeDequantizeOperators::getTensorData(PI::TensorId tensorId) const {
 	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
-	return original->getTensorData(tensorId);
+	if (tensorIsDequantizeOutput[tensorId])
+		return isFloat16(tensorId) ? original->getTensorData(dequantizeInputs[tensorId]) : getConverted(tensorId, true/*pin*/).get();
+	else
+		return original->getTensorData(tensorId);
 }
 
 void* MergeDequantizeOperators::getTensorDataWr(PI::TensorId tensorId) const {
@@ -119,32 +126,129 @@ void* MergeDequantizeOperators::getTensorDataWr(PI::TensorId tensorId) const {
 
 const float* MergeDequantizeOperators::getTensorDataF32(PI::TensorId tensorId) const {
 	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
-	if (tensorIsDequantizeOutput[tensorId])
-		return (*tensorData)[tensorId].get();
-	else
+	if (tensorIsDequantizeOutput[tensorId]) {
+		assert(!isFloat16(tensorId)); // float16 tensors can only be accessed through getTensorData()
+		return getConverted(tensorId, true/*pin*/).get();
+	} else
 		return original->getTensorDataF32(tensorId);
 }
 
+std::shared_ptr<const float> MergeDequantizeOperators::getTensorDataF32Shared(PI::TensorId tensorId) const {
+	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
+	if (tensorIsDequantizeOutput[tensorId]) {
+		assert(!isFloat16(tensorId)); // float16 tensors can only be accessed through getTensorData()
+		return getConverted(tensorId, false/*pin*/);
+	} else
+		return original->getTensorDataF32Shared(tensorId);
+}
+
 bool MergeDequantizeOperators::getTensorIsVariableFlag(PI::TensorId tensorId) const {
 	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
 	return original->getTensorIsVariableFlag(tensorId);
 }
 
-const float* MergeDequantizeOperators::convertStaticArrayToFloat32(const void *array, PI::DataType dataType, const TensorShape &shape) {
-	auto shapeSize = Tensor::flatSize(shape);
-	assert(dataType != PI::DataType_Float32);
-	switch (dataType) {
-	case PI::DataType_Float16: { // float16->float is performed through the 'half' library for half-precision floating point arithmetic
-		std::unique_ptr<float> f(new float[shapeSize]);
-		float *pf = f.get();
-		for (const uint8_t *p = static_cast<const uint8_t*>(array), *pe = p + 2*shapeSize; p < pe; p += 2)
-			*pf++ = *(const half_float::half*)p;
-		return f.release();
+bool MergeDequantizeOperators::getTensorQuantization(PI::TensorId tensorId, PI::TensorQuantization &quantization) const {
+	assert(!tensorIsDequantizeInput[tensorId]); // dequantize input can't be queried
+	if (tensorIsDequantizeOutput[tensorId])
+		return false; // Dequantize output is presented as float32 static data
+	return original->getTensorQuantization(tensorId, quantization);
+}
+
+bool MergeDequantizeOperators::isFloat16(PI::TensorId tensorId) const {
+	return original->getTensorType(dequantizeInputs[tensorId]) == PI::DataType_Float16;
+}
+
+std::shared_ptr<const float> MergeDequantizeOperators::getConverted(PI::TensorId tensorId, bool pin) const {
+	{ // already converted?
+		std::unique_lock<std::mutex> lock(convertedLock);
+		auto &c = converted[tensorId];
+		if (c.data) {
+			c.lastUse = ++useCounter;
+			c.pinned |= pin;
+			auto data = c.data; // it's in use, and isn't evicted
+			evictOverBudget(); // others could have been released by their users since
+			return data;
+		}
+	}
+
+	// convert without holding the lock: several tensors can be converted in parallel
+	auto data = convertStaticArrayToFloat32(dequantizeInputs[tensorId]);
+	auto bytes = Tensor::flatSize(original->getTensorShape(dequantizeInputs[tensorId]))*sizeof(float);
+
+	std::unique_lock<std::mutex> lock(convertedLock);
+	auto &c = converted[tensorId];
+	if (!c.data) { // otherwise another thread converted it in the meantime
+		c.data = data;
+		c.bytes = bytes;
+		convertedBytes += bytes;
+	}
+	c.lastUse = ++useCounter;
+	c.pinned |= pin;
+	data = c.data; // it's in use, and isn't evicted
+	evictOverBudget();
+	return data;
+}
+
+void MergeDequantizeOperators::evictOverBudget() const {
+	if (convertedBytes <= cacheBudget)
+		return; // the usual case: cheap enough for every request
+
+	// least recently used conversions that only this view holds are released first
+	std::vector<PI::TensorId> candidates;
+	for (PI::TensorId tid = 0; tid < converted.size(); tid++) {
+		auto &c = converted[tid];
+		if (c.data && !c.pinned && c.data.use_count() == 1)
+			candidates.push_back(tid);
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](PI::TensorId a, PI::TensorId b) {return converted[a].lastUse < converted[b].lastUse;});
+	for (auto tid : candidates) {
+		if (convertedBytes <= cacheBudget)
+			break;
+		auto &c = converted[tid];
+		convertedBytes -= c.bytes;
+		c.data.reset();
+		c.bytes = 0;
 	}
+}
+
+std::shared_ptr<const float> MergeDequantizeOperators::convertStaticArrayToFloat32(PI::TensorId tensorId) const {
+	auto shape = original->getTensorShape(tensorId);
+	auto shapeSize = Tensor::flatSize(shape);
+	PI::TensorQuantization quantization;
+	if (!original->getTensorQuantization(tensorId, quantization))
+		FAIL("MergeDequantizeOperators: can't convert the tensor #" << tensorId << " that isn't quantized")
+	std::shared_ptr<float> f(new float[shapeSize], [](float *p) {delete [] p;});
+
+	// real values: scale*(q-zeroPoint), with one scale or with a scale per slice along the quantized dimension
+	size_t inner = 1; // elements in one slice along the quantized dimension
+	for (auto d = quantization.quantizedDimension + 1; d < shape.size(); d++)
+		inner *= shape[d];
+	auto convert = [&](auto *array) {
+		ThreadPool::parallelFor(shapeSize, 64*1024, [&](size_t begin, size_t end) {
+			for (auto i = begin; i < end; i++) {
+				auto s = quantization.scales.size() == 1 ? 0 : (i/inner)%shape[quantization.quantizedDimension];
+				f.get()[i] = quantization.scales[s]*(float)((int64_t)array[i] - quantization.zeroPoints[s]);
+			}
+		});
+	};
+	auto array = original->getTensorData(tensorId);
+	switch (auto dataType = original->getTensorType(tensorId)) {
+	case PI::DataType_Int8:
+		convert(static_cast<const int8_t*>(array));
+		break;
+	case PI::DataType_UInt8:
+		convert(static_cast<const uint8_t*>(array));
+		break;
+	case PI::DataType_Int16:
+		convert(static_cast<const int16_t*>(array));
+		break;
+	case PI::DataType_Int32:
+		convert(static_cast<const int32_t*>(array));
+		break;
 	default:
 		FAIL("Unknown data type " << dataType << " in conversion to float32")
 	}
-	return nullptr;
+	return f;
 }
 
 } // ModelViews
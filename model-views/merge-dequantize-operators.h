@@ -5,6 +5,7 @@
 #include "../plugin-interface.h"
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace ModelViews {
@@ -19,10 +20,23 @@ class MergeDequantizeOperators : public PluginInterface::Model {
 	std::vector<PI::OperatorId>                   operatorMap; // view operator to original operator mapping
 	std::vector<bool>                             tensorIsDequantizeInput;
 	std::vector<bool>                             tensorIsDequantizeOutput;
-	std::unique_ptr<std::vector<std::shared_ptr<const float>>>   tensorData; // tensors corresponding to the outputs of Dequantize operators
+	std::vector<PI::TensorId>                     dequantizeInputs; // the input of the Dequantize operator, by its output
+	// float32 data of Dequantize outputs is converted on first request, float16 ones aren't converted at all
+	// conversions that nobody else holds are evicted when they exceed the budget: they can be converted again from the original
+	struct Converted {
+		std::shared_ptr<const float>              data;
+		size_t                                    bytes = 0; // of the data, while it is kept
+		bool                                      pinned = false; // raw pointers were handed out: stays as long as the view
+		uint64_t                                  lastUse = 0;
+	};
+	mutable std::vector<Converted>                converted; // by tensor
+	mutable std::mutex                            convertedLock;
+	mutable uint64_t                              useCounter = 0;
+	mutable size_t                                convertedBytes = 0; // kept by all conversions
+	size_t                                        cacheBudget; // bytes of converted data kept when it isn't in use
 
 public:
-	MergeDequantizeOperators(const PluginInterface::Model *original_);
+	MergeDequantizeOperators(const PluginInterface::Model *original_, size_t cacheBudget_ = 512*1024*1024);
 
 public: // interface implementation
 	unsigned                    numInputs() const override;
@@ -41,10 +55,15 @@ public: // interface implementation
 	const void*                 getTensorData(PI::TensorId tensorId) const override;
 	void*                       getTensorDataWr(PI::TensorId tensorId) const override;
 	const float*                getTensorDataF32(PI::TensorId tensorId) const override;
+	std::shared_ptr<const float> getTensorDataF32Shared(PI::TensorId tensorId) const override;
 	bool                        getTensorIsVariableFlag(PI::TensorId tensorId) const override;
+	bool                        getTensorQuantization(PI::TensorId tensorId, PI::TensorQuantization &quantization) const override;
 
 private: // internals
-	static const float* convertStaticArrayToFloat32(const void *array, PI::DataType dataType, const TensorShape &shape);
+	bool                        isFloat16(PI::TensorId tensorId) const; // a Dequantize output that is presented as float16
+	std::shared_ptr<const float> getConverted(PI::TensorId tensorId, bool pin) const;
+	void                        evictOverBudget() const; // convertedLock should be held
+	std::shared_ptr<const float> convertStaticArrayToFloat32(PI::TensorId tensorId) const; // the Dequantize input
 }; // MergeDequantize
 
 } // ModelViews
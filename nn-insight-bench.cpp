@@ -0,0 +1,372 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+//
+// nn-insight-bench: measures the inference latency of a model without the GUI, and prints results as JSON
+//                   sequences of frames are computed by the pipeline where stages of consecutive frames overlap,
+//                   batches of inputs are computed by a batched plan
+//
+
+#include "compute.h"
+#include "frame-pipeline.h"
+#include "image.h"
+#include "misc.h"
+#include "model-functions.h"
+#include "model-views/fuse-operators.h"
+#include "model-views/merge-dequantize-operators.h"
+#include "nn-types.h"
+#include "plugin-interface.h"
+#include "plugin-manager.h"
+#include "rng.h"
+#include "tensor.h"
+#include "thread-pool.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdlib.h> // only for ::getenv
+#include <sys/resource.h> // getrusage
+
+using json = nlohmann::json;
+
+/// arguments
+
+struct Arguments {
+	std::string                  modelFile;
+	std::string                  inputFile;     // a PNG image, inputs are synthetic when it is empty
+	std::string                  framesDirectory; // numbered PNG frames that are computed by the pipeline instead
+	FramePipeline::Effects       effects;       // applied to frames
+	unsigned                     queueSize = 2; // frames between stages of the pipeline
+	InputNormalization           inputNormalization = {InputNormalizationRange_0_1, InputNormalizationColorOrder_RGB};
+	unsigned                     numRuns = 100; // measured runs
+	unsigned                     numWarmupRuns = 10; // also frames that fill the pipeline, up to a half of them
+	unsigned                     numThreads = 0; // the number of hardware threads
+	unsigned                     batchSize = 1; // samples stacked into the inputs of one run
+};
+
+static const std::map<std::string, InputNormalizationRange> normalizationRanges = { // like in the GUI
+	{"0..1",       InputNormalizationRange_0_1},
+	{"0..255",     InputNormalizationRange_0_255},
+	{"0..128",     InputNormalizationRange_0_128},
+	{"0..64",      InputNormalizationRange_0_64},
+	{"0..32",      InputNormalizationRange_0_32},
+	{"0..16",      InputNormalizationRange_0_16},
+	{"0..8",       InputNormalizationRange_0_8},
+	{"-1..1",      InputNormalizationRange_M1_P1},
+	{"-0.5..0.5",  InputNormalizationRange_M05_P05},
+	{"0.25..0.75", InputNormalizationRange_14_34},
+	{"ImageNet",   InputNormalizationRange_ImageNet}
+};
+
+static void usage() {
+	FAIL("Usage: nn-insight-bench [--runs N] [--warmup N] [--threads N] [--batch N] [--input {image.png} | --frames {directory} [--queue N] [--flip-horizontally] [--flip-vertically] [--grayscale]]"
+	     " [--normalization {0..1|0..255|-1..1|ImageNet|...}] [--bgr] {network.tflite}")
+}
+
+static Arguments parseArguments(int argc, char **argv) {
+	Arguments args;
+	auto value = [&](int &a) {
+		if (++a == argc)
+			usage();
+		return std::string(argv[a]);
+	};
+	auto number = [&](int &a) {
+		auto v = value(a);
+		if (v.empty() || v.find_first_not_of("0123456789") != std::string::npos)
+			usage();
+		return (unsigned)std::stoul(v);
+	};
+	for (int a = 1; a < argc; a++) {
+		std::string arg = argv[a];
+		if (arg == "--runs")
+			args.numRuns = number(a);
+		else if (arg == "--warmup")
+			args.numWarmupRuns = number(a);
+		else if (arg == "--threads")
+			args.numThreads = number(a);
+		else if (arg == "--batch")
+			args.batchSize = number(a);
+		else if (arg == "--input")
+			args.inputFile = value(a);
+		else if (arg == "--frames")
+			args.framesDirectory = value(a);
+		else if (arg == "--queue")
+			args.queueSize = number(a);
+		else if (arg == "--flip-horizontally")
+			args.effects.flipHorizontally = true;
+		else if (arg == "--flip-vertically")
+			args.effects.flipVertically = true;
+		else if (arg == "--grayscale")
+			args.effects.makeGrayscale = true;
+		else if (arg == "--normalization") {
+			auto it = normalizationRanges.find(value(a));
+			if (it == normalizationRanges.end())
+				usage();
+			std::get<0>(args.inputNormalization) = it->second;
+		} else if (arg == "--bgr")
+			std::get<1>(args.inputNormalization) = InputNormalizationColorOrder_BGR;
+		else if (arg.size() > 1 && arg[0] == '-')
+			usage();
+		else if (args.modelFile.empty())
+			args.modelFile = arg;
+		else
+			usage();
+	}
+	if (args.modelFile.empty() || args.numRuns == 0 || args.queueSize == 0 || args.batchSize == 0 || (!args.inputFile.empty() && !args.framesDirectory.empty()) ||
+	    (args.batchSize > 1 && !args.framesDirectory.empty())) // frames go through the pipeline one by one
+		usage();
+	return args;
+}
+
+/// helpers
+
+typedef std::chrono::steady_clock Clock;
+
+static double ms(Clock::duration d) {
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+static double percentile(const std::vector<double> &sorted, double p) { // nearest rank
+	auto rank = (size_t)std::ceil(p/100*sorted.size());
+	return sorted[std::max(rank, (size_t)1) - 1];
+}
+
+static json latencyStats(const std::vector<double> &latencies) {
+	auto sorted = latencies;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0;
+	for (auto l : latencies)
+		total += l;
+	return {
+		{"min",  sorted.front()},
+		{"mean", total/latencies.size()},
+		{"p50",  percentile(sorted, 50)},
+		{"p90",  percentile(sorted, 90)},
+		{"p99",  percentile(sorted, 99)},
+		{"max",  sorted.back()}
+	};
+}
+
+static size_t peakRss() {
+	struct rusage usage;
+	::getrusage(RUSAGE_SELF, &usage);
+	return (size_t)usage.ru_maxrss*1024; // in kilobytes on Linux and FreeBSD
+}
+
+/// benchmarks
+
+static json benchmarkRuns(const Arguments &args, const Compute::Plan &plan, std::function<void(const std::string&)> cbWarningMessage) {
+	auto model = plan.model;
+
+	// inputs of every sample: the image, or uniformly distributed values
+	std::vector<std::map<PluginInterface::TensorId, std::shared_ptr<const float>>> samples(plan.batchSize);
+	if (!args.inputFile.empty()) {
+		TensorShape imageShape;
+		std::shared_ptr<float> image(Image::readPngImageFile(args.inputFile, imageShape), [](float *p) {delete [] p;});
+		if (!Compute::buildComputeInputs(model,
+			{0,0, imageShape[1]-1,imageShape[0]-1}, args.inputNormalization,
+			image, imageShape,
+			samples[0],
+			[](PluginInterface::TensorId) { }, cbWarningMessage))
+			FAIL("couldn't prepare inputs from the image '" << args.inputFile << "'")
+		for (auto &sample : samples)
+			sample = samples[0];
+	} else {
+		std::uniform_real_distribution<float> distribution(0, 1);
+		for (auto &sample : samples)
+			for (auto tid : model->getInputs()) {
+				auto size = Tensor::flatSize(model->getTensorShape(tid));
+				std::shared_ptr<float> data(new float[size], [](float *p) {delete [] p;});
+				for (size_t i = 0; i < size; i++)
+					data.get()[i] = distribution(Rng::generator);
+				sample[tid] = data;
+			}
+	}
+	std::map<PluginInterface::TensorId, std::shared_ptr<const float>> inputs;
+	if (plan.batchSize > 1)
+		Compute::stackInputs(plan, samples, inputs);
+	else
+		inputs = samples[0];
+
+	// run
+	std::unique_ptr<std::vector<std::shared_ptr<const float>>> tensorData(new std::vector<std::shared_ptr<const float>>(plan.numTensors));
+	std::vector<double> latencies;
+	std::map<PluginInterface::OperatorId, Compute::OperatorProfile> operators; // times are summed over measured runs
+	for (unsigned r = 0; r < args.numWarmupRuns + args.numRuns; r++) {
+		bool measured = r >= args.numWarmupRuns;
+		Compute::Profile profile;
+		Compute::fillInputs(inputs, tensorData);
+		auto tmStart = Clock::now();
+		if (!Compute::run(plan, tensorData, [](PluginInterface::TensorId) { }, cbWarningMessage, Compute::Scheduling::Parallel, nullptr, measured ? &profile : nullptr))
+			FAIL("computation didn't succeed")
+		auto latency = ms(Clock::now() - tmStart);
+		if (!measured)
+			continue;
+		latencies.push_back(latency);
+		for (auto &p : profile) {
+			auto it = operators.find(p.oid);
+			if (it == operators.end())
+				operators[p.oid] = p;
+			else
+				it->second.time += p.time;
+		}
+	}
+
+	// report
+	double totalMs = 0, operatorsTime = 0;
+	for (auto l : latencies)
+		totalMs += l;
+	for (auto &o : operators)
+		operatorsTime += o.second.time;
+	json report = {
+		{"input",        args.inputFile.empty() ? std::string("synthetic") : args.inputFile},
+		{"warmupRuns",   args.numWarmupRuns},
+		{"runs",         args.numRuns},
+		{"batchSize",    plan.batchSize},
+		{"latencyMs",    latencyStats(latencies)}, // of a run, that computes all samples of the batch
+		{"throughput",   latencies.size()*plan.batchSize/(totalMs/1000)}, // samples per second
+		{"operators",    json::array()}
+	};
+	for (auto &o : operators) {
+		auto &p = o.second;
+		auto time = p.time/args.numRuns; // mean, in seconds
+		std::vector<PluginInterface::TensorId> opInputs, opOutputs;
+		model->getOperatorIo(p.oid, opInputs, opOutputs);
+		auto flops = ModelFunctions::computeOperatorFlops(model, p.oid)*(plan.batchedTensors[opOutputs[0]] ? plan.batchSize : 1); // of all samples
+		report["operators"].push_back({
+			{"id",           p.oid},
+			{"kind",         STR(model->getOperatorKind(p.oid))},
+			{"timeMs",       time*1000},
+			{"share",        operatorsTime > 0 ? p.time/operatorsTime : 0}, // operators overlap when they run in parallel
+			{"flops",        flops},
+			{"gflops",       time > 0 ? flops/time/1e9 : 0},
+			{"bytesTouched", p.bytesTouched}
+		});
+	}
+	return report;
+}
+
+static json benchmarkFrames(const Arguments &args, const Compute::Plan &plan, std::function<void(const std::string&)> cbWarningMessage) {
+	// frames are numbered: frame9.png goes before frame10.png
+	std::vector<std::string> files;
+	for (auto &entry : std::filesystem::directory_iterator(args.framesDirectory))
+		if (entry.is_regular_file() && entry.path().extension() == ".png")
+			files.push_back(entry.path().string());
+	std::sort(files.begin(), files.end(), [](const std::string &a, const std::string &b) {
+		return a.size() != b.size() ? a.size() < b.size() : a < b;
+	});
+	if (files.empty())
+		FAIL("no PNG frames in the directory '" << args.framesDirectory << "'")
+
+	// compute them in the pipeline
+	std::vector<FramePipeline::FrameResult> results;
+	if (!FramePipeline::run(plan, files, args.inputNormalization, args.effects, args.queueSize, 5/*numTop*/, results, cbWarningMessage))
+		FAIL("computation of frames didn't succeed")
+
+	// steady state: frames that finish after the pipeline has filled up
+	unsigned numFrames = results.size();
+	unsigned numWarmup = std::min(args.numWarmupRuns, numFrames/2);
+	auto framesPerSecond = numFrames > numWarmup+1 ? (numFrames-numWarmup-1)/(results.back().finishedAt - results[numWarmup].finishedAt)
+	                                               : numFrames/results.back().finishedAt;
+	std::vector<double> latencies;
+	for (unsigned f = numWarmup; f < numFrames; f++)
+		latencies.push_back(results[f].latency*1000);
+
+	// report
+	json report = {
+		{"frames",          args.framesDirectory},
+		{"numFrames",       numFrames},
+		{"warmupFrames",    numWarmup},
+		{"queueSize",       args.queueSize},
+		{"latencyMs",       latencyStats(latencies)}, // of a frame through all stages
+		{"framesPerSecond", framesPerSecond},
+		{"stages",          json::object()},
+		{"results",         json::array()}
+	};
+	double serialMs = 0; // stages of one frame after another, without the overlap
+	for (unsigned s = 0; s < FramePipeline::Stage_Count; s++) {
+		std::vector<double> times;
+		for (unsigned f = numWarmup; f < numFrames; f++)
+			times.push_back(results[f].stageTimes[s]*1000);
+		auto stats = latencyStats(times);
+		serialMs += stats["mean"].get<double>();
+		report["stages"][FramePipeline::stageName((FramePipeline::Stage)s)] = stats;
+	}
+	report["serialFramesPerSecond"] = 1000/serialMs;
+	for (auto &result : results) {
+		json top = json::array();
+		for (auto &t : result.top)
+			top.push_back({{"index", std::get<0>(t)}, {"value", std::get<1>(t)}});
+		report["results"].push_back({{"frame", result.file}, {"top", top}});
+	}
+	return report;
+}
+
+/// main
+
+int main(int argc, char **argv) {
+	auto args = parseArguments(argc, argv);
+	auto cbWarningMessage = [](const std::string &msg) {
+		WARNING(msg)
+	};
+
+	ThreadPool::setNumThreads(args.numThreads);
+
+	// messages printed while the model is loaded and computed go to stderr, stdout only has the report
+	auto coutBuf = std::cout.rdbuf(std::cerr.rdbuf());
+
+	// load the model through its plugin, like the GUI does
+	if (args.modelFile.size() < 8 || args.modelFile.compare(args.modelFile.size() - 7, 7, ".tflite") != 0)
+		FAIL("couldn't find a plugin to open the file '" << args.modelFile << "'")
+	auto plugin = PluginManager::loadPlugin("tf-lite");
+	if (!plugin)
+		FAIL("failed to load the plugin 'tf-lite'")
+	std::unique_ptr<PluginInterface> pluginInterface(PluginManager::getInterface(plugin)());
+	if (!pluginInterface->open(args.modelFile))
+		FAIL("failed to load the model '" << args.modelFile << "'")
+	if (pluginInterface->numModels() != 1)
+		FAIL("multi-model files aren't supported yet")
+	std::unique_ptr<const PluginInterface::Model> model(pluginInterface->getModel(0));
+	if (!::getenv("NN_INSIGHT_NO_MERGE_DEQUANTIZE_OPERATORS")) {
+		auto cacheMb = ::getenv("NN_INSIGHT_DEQUANTIZED_CACHE_MB");
+		model.reset(cacheMb ? new ModelViews::MergeDequantizeOperators(model.release(), (size_t)std::stoul(cacheMb)*1024*1024)
+		                    : new ModelViews::MergeDequantizeOperators(model.release()));
+	}
+	if (::getenv("NN_INSIGHT_FUSE_OPERATORS"))
+		model.reset(new ModelViews::FuseOperators(model.release()));
+
+	// compile
+	auto tmCompile = Clock::now();
+	std::unique_ptr<Compute::Plan> plan(Compute::compile(model.get(), false/*keepAllIntermediates*/, args.batchSize));
+	auto compileMs = ms(Clock::now() - tmCompile);
+
+	// run: repeatedly on the same inputs, or once on every frame
+	auto report = args.framesDirectory.empty() ? benchmarkRuns(args, *plan, cbWarningMessage) : benchmarkFrames(args, *plan, cbWarningMessage);
+
+	// report
+	std::cout.rdbuf(coutBuf);
+	report["model"]        = args.modelFile;
+	report["threads"]      = ThreadPool::getNumThreads();
+	report["flops"]        = ModelFunctions::computeModelFlops(model.get()); // of one sample
+	report["compileMs"]    = compileMs;
+	report["peakRssBytes"] = peakRss();
+	std::cout << report.dump(1, '\t') << std::endl;
+
+	// unload
+	plan.reset(nullptr);
+	model.reset(nullptr);
+	pluginInterface.reset(nullptr);
+	PluginManager::unloadPlugin(plugin);
+
+	return 0;
+}
@@ -0,0 +1,407 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+//
+// nn-operators-bench: measures NnOperators kernels on shapes of layers of well-known networks, and prints results as JSON
+//                     with --check it compares kernels with the reference implementation on random cases instead
+//
+
+#include "in-memory-model.h"
+#include "misc.h"
+#include "model-functions.h"
+#include "nn-operators.h"
+#include "nn-operators-check.h"
+#include "nn-types.h"
+#include "plugin-interface.h"
+#include "rng.h"
+#include "tensor.h"
+#include "thread-pool.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+typedef PluginInterface PI;
+
+/// cases
+
+// one operator applied to one shape: the operator is also the only operator of a model,
+// so that its FLOPs are counted by ModelFunctions::computeOperatorFlops like for operators of real models
+struct Case {
+	std::string                     layer;  // the network and the layer that the shape is taken from
+	std::unique_ptr<InMemoryModel>  model;
+	std::function<void()>           run;
+
+	Case(const std::string &layer_) : layer(layer_), model(new InMemoryModel) { }
+
+	PI::TensorId tensor(const TensorShape &shape) { // all tensors have data with random values: inputs, outputs and static ones alike
+		auto size = Tensor::flatSize(shape);
+		std::unique_ptr<float> data(new float[size]);
+		std::uniform_real_distribution<float> distribution(-1, 1);
+		for (size_t i = 0; i < size; i++)
+			data.get()[i] = distribution(Rng::generator);
+		return model->addTensor(STR("tensor#" << model->numTensors()), shape, PI::DataType_Float32, (uint8_t*)data.release());
+	}
+	PI::TensorId tensor(const TensorShape &shape, const std::vector<int32_t> &values) {
+		std::unique_ptr<int32_t> data(new int32_t[values.size()]);
+		std::copy(values.begin(), values.end(), data.get());
+		return model->addTensor(STR("tensor#" << model->numTensors()), shape, PI::DataType_Int32, (uint8_t*)data.release());
+	}
+	size_t bytesTouched() const { // all tensors are read or written once, float32 and int32 values have the same size
+		size_t bytes = 0;
+		for (PI::TensorId tid = 0; tid < model->numTensors(); tid++)
+			bytes += Tensor::flatSize(model->getTensorShape(tid))*sizeof(float);
+		return bytes;
+	}
+};
+
+static unsigned outputSizeSame(unsigned inSize, unsigned stride) { // like padding=SAME in TF Lite
+	return (inSize + stride - 1)/stride;
+}
+
+static unsigned padding(unsigned inSize, unsigned filterSize, unsigned outSize, unsigned stride) {
+	return std::get<0>(computePaddingValues(stride, 1/*dilationRate*/, inSize, filterSize, outSize));
+}
+
+static Case conv2D(const std::string &layer, const TensorShape &inputShape, unsigned filterSize, unsigned outputChannels, unsigned stride) {
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto filter = c.tensor({outputChannels, filterSize, filterSize, inputShape[3]});
+	auto bias = c.tensor({outputChannels});
+	auto output = c.tensor({1, outputSizeSame(inputShape[1], stride), outputSizeSame(inputShape[2], stride), outputChannels});
+	c.model->addOperator(PI::KindConv2D, {input, filter, bias}, {output}, nullptr);
+	c.run = [&m = *c.model, input, filter, bias, output, stride]() {
+		auto is = m.getTensorShape(input), fs = m.getTensorShape(filter), os = m.getTensorShape(output);
+		NnOperators::Conv2D(
+			is, m.getTensorDataF32(input),
+			fs, m.getTensorDataF32(filter),
+			m.getTensorShape(bias), m.getTensorDataF32(bias),
+			os, (float*)m.getTensorDataWr(output),
+			padding(is[2], fs[2], os[2], stride), padding(is[1], fs[1], os[1], stride),
+			stride, stride,
+			1, 1,
+			Kernels::Activation::clamp(0, 6)
+		);
+	};
+	return c;
+}
+
+static Case depthwiseConv2D(const std::string &layer, const TensorShape &inputShape, unsigned filterSize, unsigned stride) {
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto filter = c.tensor({1, filterSize, filterSize, inputShape[3]});
+	auto bias = c.tensor({inputShape[3]});
+	auto output = c.tensor({1, outputSizeSame(inputShape[1], stride), outputSizeSame(inputShape[2], stride), inputShape[3]});
+	c.model->addOperator(PI::KindDepthwiseConv2D, {input, filter, bias}, {output}, nullptr);
+	c.run = [&m = *c.model, input, filter, bias, output, stride]() {
+		auto is = m.getTensorShape(input), fs = m.getTensorShape(filter), os = m.getTensorShape(output);
+		NnOperators::DepthwiseConv2D(
+			is, m.getTensorDataF32(input),
+			fs, m.getTensorDataF32(filter),
+			m.getTensorShape(bias), m.getTensorDataF32(bias),
+			os, (float*)m.getTensorDataWr(output),
+			padding(is[2], fs[2], os[2], stride), padding(is[1], fs[1], os[1], stride),
+			stride, stride,
+			1, 1,
+			1/*depthMultiplier*/,
+			Kernels::Activation::clamp(0, 6)
+		);
+	};
+	return c;
+}
+
+static Case fullyConnected(const std::string &layer, unsigned inputSize, unsigned outputSize) {
+	Case c(layer);
+	auto input = c.tensor({1, inputSize});
+	auto filter = c.tensor({outputSize, inputSize});
+	auto bias = c.tensor({outputSize});
+	auto output = c.tensor({1, outputSize});
+	c.model->addOperator(PI::KindFullyConnected, {input, filter, bias}, {output}, nullptr);
+	c.run = [&m = *c.model, input, filter, bias, output]() {
+		NnOperators::FullyConnected(
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(filter), m.getTensorDataF32(filter),
+			m.getTensorShape(bias), m.getTensorDataF32(bias),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output),
+			Kernels::Activation::clamp(0, std::numeric_limits<float>::infinity())
+		);
+	};
+	return c;
+}
+
+static Case pool(PI::OperatorKind kind, const std::string &layer, const TensorShape &inputShape, unsigned filterSize, unsigned stride) { // padding=VALID
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto output = c.tensor({1, (inputShape[1] - filterSize)/stride + 1, (inputShape[2] - filterSize)/stride + 1, inputShape[3]});
+	c.model->addOperator(kind, {input}, {output}, new PI::OperatorOptionsList({
+		{PI::OperatorOption_FILTER_WIDTH,  PI::OperatorOptionValue((int32_t)filterSize)},
+		{PI::OperatorOption_FILTER_HEIGHT, PI::OperatorOptionValue((int32_t)filterSize)}
+	}));
+	auto fn = kind == PI::KindMaxPool ? NnOperators::MaxPool : NnOperators::AveragePool;
+	c.run = [&m = *c.model, input, output, filterSize, stride, fn]() {
+		fn(
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output),
+			0, 0,
+			stride, stride,
+			filterSize, filterSize,
+			Kernels::Activation()
+		);
+	};
+	return c;
+}
+
+static Case softmax(const std::string &layer, unsigned size) {
+	Case c(layer);
+	auto input = c.tensor({1, size});
+	auto output = c.tensor({1, size});
+	c.model->addOperator(PI::KindSoftmax, {input}, {output}, nullptr);
+	c.run = [&m = *c.model, input, output]() {
+		NnOperators::Softmax(
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output),
+			1/*beta*/
+		);
+	};
+	return c;
+}
+
+static Case resizeBilinear(const std::string &layer, const TensorShape &inputShape, unsigned factor) {
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto output = c.tensor({1, inputShape[1]*factor, inputShape[2]*factor, inputShape[3]});
+	c.model->addOperator(PI::KindResizeBilinear, {input}, {output}, nullptr);
+	c.run = [&m = *c.model, input, output]() {
+		NnOperators::ResizeBilinear(
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output),
+			false/*alignCorners*/
+		);
+	};
+	return c;
+}
+
+static Case localResponseNormalization(const std::string &layer, const TensorShape &inputShape, int radius) {
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto output = c.tensor(inputShape);
+	c.model->addOperator(PI::KindLocalResponseNormalization, {input}, {output}, new PI::OperatorOptionsList({
+		{PI::OperatorOption_RADIUS, PI::OperatorOptionValue((int32_t)radius)}
+	}));
+	c.run = [&m = *c.model, input, output, radius]() {
+		NnOperators::LocalResponseNormalization(
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output),
+			radius, 0.0001/*alpha*/, 0.75/*beta*/, 1/*bias*/
+		);
+	};
+	return c;
+}
+
+static Case mean(const std::string &layer, const TensorShape &inputShape) { // over height and width
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto axis = c.tensor({2}, {1, 2});
+	auto output = c.tensor({1, inputShape[3]});
+	c.model->addOperator(PI::KindMean, {input, axis}, {output}, nullptr);
+	c.run = [&m = *c.model, input, axis, output]() {
+		NnOperators::Mean(
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output),
+			(const int32_t*)m.getTensorData(axis), 2
+		);
+	};
+	return c;
+}
+
+static Case pad(const std::string &layer, const TensorShape &inputShape, int32_t before, int32_t after) { // pads height and width
+	Case c(layer);
+	auto input = c.tensor(inputShape);
+	auto paddings = c.tensor({4, 2}, {0,0, before,after, before,after, 0,0});
+	auto output = c.tensor({1, inputShape[1] + before + after, inputShape[2] + before + after, inputShape[3]});
+	c.model->addOperator(PI::KindPad, {input, paddings}, {output}, nullptr);
+	c.run = [&m = *c.model, input, paddings, output]() {
+		NnOperators::Pad(
+			(const std::array<int32_t,2>*)m.getTensorData(paddings),
+			m.getTensorShape(input), m.getTensorDataF32(input),
+			m.getTensorShape(output), (float*)m.getTensorDataWr(output)
+		);
+	};
+	return c;
+}
+
+static std::vector<Case> allCases() {
+	std::vector<Case> cases;
+	// Conv2D
+	cases.push_back(conv2D("MobileNet v1 conv0 3x3/2",          {1,224,224,3},   3, 32,   2));
+	cases.push_back(conv2D("MobileNet v1 pw1 1x1",              {1,112,112,32},  1, 64,   1));
+	cases.push_back(conv2D("MobileNet v1 pw5 1x1",              {1,28,28,256},   1, 256,  1));
+	cases.push_back(conv2D("MobileNet v1 pw13 1x1",             {1,7,7,1024},    1, 1024, 1));
+	cases.push_back(conv2D("VGG16 conv1_2 3x3",                 {1,224,224,64},  3, 64,   1));
+	cases.push_back(conv2D("VGG16 conv3_2 3x3",                 {1,56,56,256},   3, 256,  1));
+	cases.push_back(conv2D("VGG16 conv5_1 3x3",                 {1,14,14,512},   3, 512,  1));
+	cases.push_back(conv2D("SqueezeNet fire2 squeeze 1x1",      {1,55,55,96},    1, 16,   1));
+	cases.push_back(conv2D("SqueezeNet fire2 expand 3x3",       {1,55,55,16},    3, 64,   1));
+	cases.push_back(conv2D("SqueezeNet conv10 1x1",             {1,13,13,512},   1, 1000, 1));
+	// DepthwiseConv2D
+	cases.push_back(depthwiseConv2D("MobileNet v1 dw1 3x3",     {1,112,112,32},  3, 1));
+	cases.push_back(depthwiseConv2D("MobileNet v1 dw2 3x3/2",   {1,112,112,64},  3, 2));
+	cases.push_back(depthwiseConv2D("MobileNet v1 dw5 3x3",     {1,28,28,256},   3, 1));
+	cases.push_back(depthwiseConv2D("MobileNet v1 dw7 3x3",     {1,14,14,512},   3, 1));
+	cases.push_back(depthwiseConv2D("MobileNet v1 dw13 3x3",    {1,7,7,1024},    3, 1));
+	// FullyConnected
+	cases.push_back(fullyConnected("VGG16 fc7",                 4096, 4096));
+	cases.push_back(fullyConnected("VGG16 fc8",                 4096, 1000));
+	cases.push_back(fullyConnected("MobileNet v1 logits",       1024, 1001));
+	// MaxPool
+	cases.push_back(pool(PI::KindMaxPool, "VGG16 pool1 2x2/2",         {1,224,224,64}, 2, 2));
+	cases.push_back(pool(PI::KindMaxPool, "VGG16 pool5 2x2/2",         {1,14,14,512},  2, 2));
+	cases.push_back(pool(PI::KindMaxPool, "SqueezeNet maxpool1 3x3/2", {1,111,111,96}, 3, 2));
+	// AveragePool
+	cases.push_back(pool(PI::KindAveragePool, "MobileNet v1 avgpool 7x7", {1,7,7,1024},    7,  1));
+	cases.push_back(pool(PI::KindAveragePool, "SqueezeNet avgpool10 13x13", {1,13,13,1000}, 13, 1));
+	// Softmax
+	cases.push_back(softmax("MobileNet v1 prediction",          1001));
+	cases.push_back(softmax("VGG16 prediction",                 1000));
+	// ResizeBilinear
+	cases.push_back(resizeBilinear("DeepLab v3 upsampling x2",  {1,33,33,256},  2));
+	cases.push_back(resizeBilinear("DeepLab v3 logits x8",      {1,65,65,21},   8));
+	// LocalResponseNormalization
+	cases.push_back(localResponseNormalization("AlexNet norm1", {1,55,55,96},   2));
+	cases.push_back(localResponseNormalization("GoogLeNet norm2", {1,56,56,192}, 2));
+	// Mean
+	cases.push_back(mean("MobileNet v2 global average",         {1,7,7,1280}));
+	cases.push_back(mean("ResNet50 v2 global average",          {1,7,7,2048}));
+	// Pad
+	cases.push_back(pad("MobileNet v2 pad before conv 3x3/2",   {1,112,112,96}, 0, 1));
+	cases.push_back(pad("ResNet50 pad before conv1 7x7/2",      {1,224,224,3},  3, 3));
+	return cases;
+}
+
+/// arguments
+
+struct Arguments {
+	unsigned                     numRuns = 10;   // measured runs
+	unsigned                     numWarmupRuns = 2;
+	unsigned                     numThreads = 0; // the number of hardware threads
+	std::string                  kernel;         // all kernels when it is empty
+	bool                         check = false;  // compare kernels with the reference implementation instead
+	unsigned                     numIterations = 100; // random cases of every kernel variant
+	unsigned                     seed = std::random_device()();
+	std::string                  caseParams;     // the single case to check, as printed by reproducers
+};
+
+static void usage() {
+	FAIL("Usage: nn-operators-bench [--runs N] [--warmup N] [--threads N] [--kernel {Conv2D|DepthwiseConv2D|FullyConnected|...}]\n"
+	     "       nn-operators-bench --check [--iterations N] [--seed N] [--threads N] [--kernel {Conv2D|Conv2D/float16|...} [--case {N=1,H=5,...}]]")
+}
+
+static Arguments parseArguments(int argc, char **argv) {
+	Arguments args;
+	auto value = [&](int &a) {
+		if (++a == argc)
+			usage();
+		return std::string(argv[a]);
+	};
+	auto number = [&](int &a) {
+		auto v = value(a);
+		if (v.empty() || v.find_first_not_of("0123456789") != std::string::npos)
+			usage();
+		return (unsigned)std::stoul(v);
+	};
+	for (int a = 1; a < argc; a++) {
+		std::string arg = argv[a];
+		if (arg == "--runs")
+			args.numRuns = number(a);
+		else if (arg == "--warmup")
+			args.numWarmupRuns = number(a);
+		else if (arg == "--threads")
+			args.numThreads = number(a);
+		else if (arg == "--kernel")
+			args.kernel = value(a);
+		else if (arg == "--check")
+			args.check = true;
+		else if (arg == "--iterations")
+			args.numIterations = number(a);
+		else if (arg == "--seed")
+			args.seed = number(a);
+		else if (arg == "--case")
+			args.caseParams = value(a);
+		else
+			usage();
+	}
+	if (args.numRuns == 0 || (!args.caseParams.empty() && (!args.check || args.kernel.empty())))
+		usage();
+	return args;
+}
+
+/// main
+
+int main(int argc, char **argv) {
+	auto args = parseArguments(argc, argv);
+	typedef std::chrono::steady_clock Clock;
+
+	ThreadPool::setNumThreads(args.numThreads);
+
+	// conformance
+	if (args.check) {
+		if (!args.caseParams.empty())
+			return NnOperatorsCheck::checkCase(args.kernel, args.caseParams, args.seed) ? 0 : 1;
+		PRINT("checking kernels against the reference implementation, the seed is " << args.seed)
+		return NnOperatorsCheck::checkRandomCases(args.kernel, args.numIterations, args.seed) == 0 ? 0 : 1;
+	}
+
+	// benchmarks
+	json report = {
+		{"threads", ThreadPool::getNumThreads()},
+		{"warmupRuns", args.numWarmupRuns},
+		{"runs", args.numRuns},
+		{"kernels", json::array()}
+	};
+	for (auto &c : allCases()) {
+		auto kind = STR(c.model->getOperatorKind(0));
+		if (!args.kernel.empty() && kind != args.kernel)
+			continue;
+
+		// the best and the median times: the best is the least disturbed by the rest of the system
+		std::vector<double> times;
+		for (unsigned r = 0; r < args.numWarmupRuns + args.numRuns; r++) {
+			auto tmStart = Clock::now();
+			c.run();
+			if (r >= args.numWarmupRuns)
+				times.push_back(std::chrono::duration<double>(Clock::now() - tmStart).count());
+		}
+		std::sort(times.begin(), times.end());
+		auto best = times.front(), median = times[times.size()/2];
+
+		auto flops = ModelFunctions::computeOperatorFlops(c.model.get(), 0);
+		auto bytes = c.bytesTouched();
+		std::vector<TensorShape> shapes;
+		for (PI::TensorId tid = 0; tid < c.model->numTensors(); tid++)
+			shapes.push_back(c.model->getTensorShape(tid));
+		report["kernels"].push_back({
+			{"kernel",       kind},
+			{"layer",        c.layer},
+			{"shapes",       shapes}, // inputs, then outputs
+			{"flops",        flops},
+			{"bytesTouched", bytes},
+			{"bestMs",       best*1000},
+			{"medianMs",     median*1000},
+			{"gflops",       flops/best/1e9},
+			{"gbytes",       bytes/best/1e9} // GB/s
+		});
+	}
+	std::cout << report.dump(1, '\t') << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,1132 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "nn-operators-check.h"
+#include "kernels/activation.h"
+#include "kernels/elementwise.h"
+#include "kernels/quantized.h"
+#include "kernels/winograd.h"
+#include "misc.h"
+#include "nn-operators.h"
+#include "nn-types.h"
+#include "rng.h"
+#include "tensor.h"
+
+#include <half.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <assert.h>
+
+namespace NnOperatorsCheck {
+
+/// parameters of cases
+
+class Params {
+	std::vector<std::pair<std::string,int>> values; // in the order in which they were set
+
+public:
+	int operator()(const std::string &name) const {
+		for (auto &v : values)
+			if (v.first == name)
+				return v.second;
+		FAIL("the case doesn't have the parameter " << name)
+	}
+	void set(const std::string &name, int value) {
+		for (auto &v : values)
+			if (v.first == name) {
+				v.second = value;
+				return;
+			}
+		values.push_back({name, value});
+	}
+	size_t size() const {return values.size();}
+	int& operator[](size_t i) {return values[i].second;}
+
+	std::string str() const { // like "N=1,H=5,W=3"
+		std::string s;
+		for (auto &v : values)
+			s += STR((s.empty() ? "" : ",") << v.first << "=" << v.second);
+		return s;
+	}
+	static bool parse(const std::string &str, Params &params) {
+		std::istringstream ss(str);
+		std::string item;
+		while (std::getline(ss, item, ',')) {
+			auto eq = item.find('=');
+			if (eq == std::string::npos || eq == 0 || eq+1 == item.size() || item.find_first_not_of("0123456789", eq+1) != std::string::npos)
+				return false;
+			params.set(item.substr(0, eq), std::stoi(item.substr(eq+1)));
+		}
+		return params.size() > 0;
+	}
+};
+
+/// helpers
+
+static int uniform(int min, int max) {
+	return std::uniform_int_distribution<int>(min, max)(Rng::generator);
+}
+static float uniformReal(float min, float max) {
+	return std::uniform_real_distribution<float>(min, max)(Rng::generator);
+}
+static bool chance(unsigned percent) {
+	return uniform(1, 100) <= (int)percent;
+}
+static std::vector<float> randomData(const TensorShape &shape, float amplitude = 1) {
+	std::vector<float> data(Tensor::flatSize(shape));
+	for (auto &d : data)
+		d = uniformReal(-amplitude, amplitude);
+	return data;
+}
+
+// output sizes and padding like in TF Lite: SAME keeps the size divided by the stride, VALID only has whole windows
+static unsigned outputSize(unsigned inSize, unsigned filterSize, unsigned stride, unsigned dilation, bool same) {
+	auto effectiveFilterSize = (filterSize-1)*dilation + 1;
+	return same ? (inSize + stride - 1)/stride : inSize >= effectiveFilterSize ? (inSize - effectiveFilterSize)/stride + 1 : 0;
+}
+static unsigned padding(unsigned inSize, unsigned filterSize, unsigned stride, unsigned dilation, unsigned outSize) {
+	return std::get<0>(computePaddingValues(stride, dilation, inSize, filterSize, outSize));
+}
+
+// activations: 0 is none, 1 is RELU, 2 is RELU6, 3 is RELU_N1_TO_1, 4 is TANH
+static Kernels::Activation activation(int a) {
+	switch (a) {
+	case 0:
+		return Kernels::Activation();
+	case 1:
+		return Kernels::Activation::clamp(0, std::numeric_limits<float>::infinity());
+	case 2:
+		return Kernels::Activation::clamp(0, 6);
+	case 3:
+		return Kernels::Activation::clamp(-1, 1);
+	default:
+		return Kernels::Activation::tanh();
+	}
+}
+static const int NumActivations = 5;
+static const int NumClampActivations = 4; // all but TANH: integer kernels only clamp
+static const float Inf = std::numeric_limits<float>::infinity();
+
+// the reference implementations compute without activations, activations are applied to their outputs
+// rounding errors are relative to the largest magnitude before the activation: activations can hide large sums
+static void finishReference(const Kernels::Activation &a, std::vector<float> &expected, float &scale) {
+	scale = 0;
+	for (auto e : expected)
+		if (std::isfinite(e))
+			scale = std::max(scale, std::abs(e));
+	a.apply(expected.data(), expected.size());
+}
+
+// outputs that are parts of wider tensors: values between pixels have to stay intact
+static const float Untouched = 12345.f;
+static std::vector<float> widen(const std::vector<float> &data, unsigned depth, unsigned stride) {
+	std::vector<float> wide(data.size()/depth*stride, Untouched);
+	for (size_t p = 0, pe = data.size()/depth; p < pe; p++)
+		std::copy(data.begin() + p*depth, data.begin() + (p+1)*depth, wide.begin() + p*stride);
+	return wide;
+}
+
+/// comparison
+
+struct Tolerance {
+	unsigned maxUlps;  // values this close are equal at any magnitude
+	float    relative; // of the scale of outputs: rounding errors of sums grow with the magnitude of terms
+};
+
+struct Outputs {
+	std::vector<float> output;
+	std::vector<float> expected;
+	float              scale = -1; // what relative tolerances are relative to, the largest magnitude of expected values when it is negative
+};
+
+struct Mismatch {
+	size_t   index;
+	float    value;
+	float    expected;
+	float    allowed;
+};
+
+static int64_t ulpDistance(float a, float b) {
+	auto ordered = [](float f) -> int64_t { // consecutive floats are consecutive integers
+		int32_t i;
+		std::memcpy(&i, &f, sizeof(i));
+		return i < 0 ? -(int64_t)(i & 0x7fffffff) : i;
+	};
+	return std::abs(ordered(a) - ordered(b));
+}
+
+static bool compare(const Outputs &outputs, Tolerance tolerance, Mismatch &mismatch) {
+	auto &output = outputs.output, &expected = outputs.expected;
+	assert(output.size() == expected.size());
+	float scale = outputs.scale;
+	if (scale < 0) {
+		scale = 0;
+		for (auto e : expected)
+			if (std::isfinite(e))
+				scale = std::max(scale, std::abs(e));
+	}
+	float allowed = tolerance.relative*scale;
+	for (size_t i = 0; i < output.size(); i++) {
+		auto v = output[i], e = expected[i];
+		if (v == e || (std::isnan(v) && std::isnan(e)) || ulpDistance(v, e) <= tolerance.maxUlps || std::abs(v - e) <= allowed)
+			continue;
+		mismatch = {i, v, e, allowed};
+		return false;
+	}
+	return true;
+}
+
+/// checks
+
+// one kernel variant: parameters and data of its cases are random, data is drawn from Rng::generator seeded by the case seed
+struct Check {
+	std::string                                                                  kernel;
+	Tolerance                                                                    tolerance;
+	std::function<Params()>                                                      generate;
+	std::function<bool(const Params&)>                                           valid; // shrinking only tries valid parameters
+	std::function<void(const Params&, Outputs&)>                                  run;   // computes the output and the expected output
+};
+
+enum ConvolutionVariant {Float32, Float16, OutputStride};
+
+static Params generateConvolution(bool depthwise) {
+	Params p;
+	p.set("N", uniform(1, 2));
+	p.set("H", uniform(1, 20));
+	p.set("W", uniform(1, 20));
+	if (!depthwise) {
+		p.set("I", uniform(1, 40));
+		p.set("O", uniform(1, 40));
+	} else {
+		p.set("C", uniform(1, 40));
+		p.set("MULT", chance(70) ? 1 : uniform(2, 3));
+	}
+	auto square = chance(60), plain = chance(50); // plain filters are those of optimized paths
+	auto kh = plain ? (depthwise ? 2*uniform(1, 2)+1 : uniform(1, 3)) : uniform(1, 5);
+	p.set("KH", kh);
+	p.set("KW", square ? kh : uniform(1, 5));
+	auto sh = plain ? uniform(1, 2) : uniform(1, 3);
+	p.set("SH", sh);
+	p.set("SW", plain ? sh : uniform(1, 3));
+	p.set("DH", plain || chance(70) ? 1 : uniform(2, 3));
+	p.set("DW", plain || chance(70) ? 1 : uniform(2, 3));
+	p.set("SAME", uniform(0, 1));
+	p.set("ACT", uniform(0, NumActivations-1));
+	if (!depthwise)
+		p.set("X", uniform(1, 8)); // extra floats between output pixels of the OutputStride variant
+	// VALID padding needs the whole filter inside the input
+	if (!p("SAME")) {
+		p.set("H", std::max(p("H"), (p("KH")-1)*p("DH")+1 + uniform(0, 8)));
+		p.set("W", std::max(p("W"), (p("KW")-1)*p("DW")+1 + uniform(0, 8)));
+	}
+	return p;
+}
+
+static bool validConvolution(const Params &p, bool depthwise) {
+	for (auto name : {"N", "H", "W", "KH", "KW", "SH", "SW", "DH", "DW"})
+		if (p(name) < 1)
+			return false;
+	if (depthwise ? (p("C") < 1 || p("MULT") < 1) : (p("I") < 1 || p("O") < 1 || p("X") < 1))
+		return false;
+	return p("SAME") >= 0 && p("SAME") <= 1 && p("ACT") >= 0 && p("ACT") < NumActivations &&
+		outputSize(p("H"), p("KH"), p("SH"), p("DH"), p("SAME")) > 0 && outputSize(p("W"), p("KW"), p("SW"), p("DW"), p("SAME")) > 0;
+}
+
+static void runConv2D(const Params &p, ConvolutionVariant variant, Outputs &outputs) {
+	unsigned N = p("N"), H = p("H"), W = p("W"), I = p("I"), O = p("O"), KH = p("KH"), KW = p("KW");
+	unsigned SH = p("SH"), SW = p("SW"), DH = p("DH"), DW = p("DW");
+	unsigned OH = outputSize(H, KH, SH, DH, p("SAME")), OW = outputSize(W, KW, SW, DW, p("SAME"));
+	unsigned PH = padding(H, KH, SH, DH, OH), PW = padding(W, KW, SW, DW, OW);
+	TensorShape inputShape = {N, H, W, I}, filterShape = {O, KH, KW, I}, biasShape = {O}, outputShape = {N, OH, OW, O};
+	auto input = randomData(inputShape), filter = randomData(filterShape), bias = randomData(biasShape);
+	auto act = activation(p("ACT"));
+
+	std::vector<half_float::half> filter16;
+	if (variant == Float16) { // the reference computes with the same values
+		for (auto &f : filter) {
+			filter16.push_back(half_float::half(f));
+			f = float(filter16.back());
+		}
+	}
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	NnOperators::Reference::Conv2D(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.expected.data(),
+		PW, PH, SW, SH, DW, DH, -Inf, Inf);
+	finishReference(act, outputs.expected, outputs.scale);
+
+	switch (variant) {
+	case Float32:
+		outputs.output.resize(outputs.expected.size());
+		NnOperators::Conv2D(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.output.data(),
+			PW, PH, SW, SH, DW, DH, act);
+		break;
+	case Float16:
+		outputs.output.resize(outputs.expected.size());
+		NnOperators::Conv2D(inputShape, input.data(), filterShape, filter16.data(), biasShape, bias.data(), outputShape, outputs.output.data(),
+			PW, PH, SW, SH, DW, DH, act);
+		break;
+	case OutputStride:
+		outputs.output.assign(outputs.expected.size()/O*(O + p("X")), Untouched);
+		NnOperators::Conv2D(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.output.data(),
+			PW, PH, SW, SH, DW, DH, act, O + p("X"));
+		outputs.expected = widen(outputs.expected, O, O + p("X"));
+		break;
+	}
+}
+
+static void runWinograd(const Params &p, Outputs &outputs) {
+	unsigned N = p("N"), H = p("H"), W = p("W"), I = p("I"), O = p("O");
+	unsigned OH = outputSize(H, 3, 1, 1, p("SAME")), OW = outputSize(W, 3, 1, 1, p("SAME"));
+	unsigned PH = padding(H, 3, 1, 1, OH), PW = padding(W, 3, 1, 1, OW);
+	TensorShape inputShape = {N, H, W, I}, filterShape = {O, 3, 3, I}, biasShape = {O}, outputShape = {N, OH, OW, O};
+	auto input = randomData(inputShape), filter = randomData(filterShape), bias = randomData(biasShape);
+	auto act = activation(p("ACT"));
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	NnOperators::Reference::Conv2D(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.expected.data(),
+		PW, PH, 1, 1, 1, 1, -Inf, Inf);
+	finishReference(act, outputs.expected, outputs.scale);
+	outputs.expected = widen(outputs.expected, O, O + p("X"));
+
+	outputs.output.assign(outputs.expected.size(), Untouched);
+	auto transformed = Kernels::Winograd::transformFilter(filterShape, filter.data(), p("M"));
+	Kernels::Winograd::Conv2D(inputShape, input.data(), *transformed, bias.data(), outputShape, outputs.output.data(), PW, PH, act, O + p("X"));
+}
+
+static void runDepthwiseConv2D(const Params &p, Outputs &outputs) {
+	unsigned N = p("N"), H = p("H"), W = p("W"), C = p("C"), MULT = p("MULT"), KH = p("KH"), KW = p("KW");
+	unsigned SH = p("SH"), SW = p("SW"), DH = p("DH"), DW = p("DW");
+	unsigned OH = outputSize(H, KH, SH, DH, p("SAME")), OW = outputSize(W, KW, SW, DW, p("SAME"));
+	unsigned PH = padding(H, KH, SH, DH, OH), PW = padding(W, KW, SW, DW, OW);
+	TensorShape inputShape = {N, H, W, C}, filterShape = {1, KH, KW, C*MULT}, biasShape = {C*MULT}, outputShape = {N, OH, OW, C*MULT};
+	auto input = randomData(inputShape), filter = randomData(filterShape), bias = randomData(biasShape);
+	auto act = activation(p("ACT"));
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	NnOperators::Reference::DepthwiseConv2D(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.expected.data(),
+		PW, PH, SW, SH, DW, DH, MULT, -Inf, Inf);
+	finishReference(act, outputs.expected, outputs.scale);
+
+	outputs.output.resize(outputs.expected.size());
+	NnOperators::DepthwiseConv2D(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.output.data(),
+		PW, PH, SW, SH, DW, DH, MULT, act);
+}
+
+static void runFullyConnected(const Params &p, bool float16, Outputs &outputs) {
+	unsigned N = p("N"), I = p("I"), O = p("O");
+	TensorShape inputShape = {N, I}, filterShape = {O, I}, biasShape = {O}, outputShape = {N, O};
+	auto input = randomData(inputShape), filter = randomData(filterShape), bias = randomData(biasShape);
+	auto act = activation(p("ACT"));
+
+	std::vector<half_float::half> filter16;
+	if (float16)
+		for (auto &f : filter) {
+			filter16.push_back(half_float::half(f));
+			f = float(filter16.back());
+		}
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	NnOperators::Reference::FullyConnected(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.expected.data(),
+		-Inf, Inf);
+	finishReference(act, outputs.expected, outputs.scale);
+
+	outputs.output.resize(outputs.expected.size());
+	if (float16)
+		NnOperators::FullyConnected(inputShape, input.data(), filterShape, filter16.data(), biasShape, bias.data(), outputShape, outputs.output.data(), act);
+	else
+		NnOperators::FullyConnected(inputShape, input.data(), filterShape, filter.data(), biasShape, bias.data(), outputShape, outputs.output.data(), act);
+}
+
+template<typename Fn, typename RefFn>
+static void runPool(const Params &p, Fn fn, RefFn refFn, Outputs &outputs) {
+	unsigned N = p("N"), H = p("H"), W = p("W"), C = p("C"), FH = p("FH"), FW = p("FW"), SH = p("SH"), SW = p("SW");
+	unsigned OH = outputSize(H, FH, SH, 1, p("SAME")), OW = outputSize(W, FW, SW, 1, p("SAME"));
+	unsigned PH = padding(H, FH, SH, 1, OH), PW = padding(W, FW, SW, 1, OW);
+	TensorShape inputShape = {N, H, W, C}, outputShape = {N, OH, OW, C};
+	auto input = randomData(inputShape, 8);
+	auto act = activation(p("ACT"));
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	refFn(inputShape, input.data(), outputShape, outputs.expected.data(), PW, PH, SW, SH, FW, FH, -Inf, Inf);
+	finishReference(act, outputs.expected, outputs.scale);
+
+	outputs.output.resize(outputs.expected.size());
+	fn(inputShape, input.data(), outputShape, outputs.output.data(), PW, PH, SW, SH, FW, FH, act);
+}
+
+static Params generatePool() {
+	Params p;
+	p.set("N", uniform(1, 2));
+	p.set("H", uniform(1, 30));
+	p.set("W", uniform(1, 30));
+	p.set("C", uniform(1, 40));
+	p.set("FH", uniform(1, 4));
+	p.set("FW", uniform(1, 4));
+	p.set("SH", uniform(1, 3));
+	p.set("SW", uniform(1, 3));
+	p.set("SAME", uniform(0, 1));
+	p.set("ACT", uniform(0, NumActivations-1));
+	if (!p("SAME")) {
+		p.set("H", std::max(p("H"), p("FH")));
+		p.set("W", std::max(p("W"), p("FW")));
+	}
+	return p;
+}
+
+static bool validPool(const Params &p) {
+	for (auto name : {"N", "H", "W", "C", "FH", "FW", "SH", "SW"})
+		if (p(name) < 1)
+			return false;
+	return p("SAME") >= 0 && p("SAME") <= 1 && p("ACT") >= 0 && p("ACT") < NumActivations &&
+		outputSize(p("H"), p("FH"), p("SH"), 1, p("SAME")) > 0 && outputSize(p("W"), p("FW"), p("SW"), 1, p("SAME")) > 0;
+}
+
+template<typename Fn, typename RefFn>
+static void runResize(const Params &p, Fn fn, RefFn refFn, Outputs &outputs) {
+	TensorShape inputShape = {(unsigned)p("N"), (unsigned)p("H"), (unsigned)p("W"), (unsigned)p("C")};
+	TensorShape outputShape = {(unsigned)p("N"), (unsigned)p("OH"), (unsigned)p("OW"), (unsigned)p("C")};
+	auto input = randomData(inputShape);
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	refFn(inputShape, input.data(), outputShape, outputs.expected.data(), p("ALIGN"));
+
+	outputs.output.resize(outputs.expected.size());
+	fn(inputShape, input.data(), outputShape, outputs.output.data(), p("ALIGN"));
+}
+
+static Params generateResize() {
+	Params p;
+	p.set("N", uniform(1, 2));
+	p.set("H", uniform(1, 16));
+	p.set("W", uniform(1, 16));
+	p.set("C", uniform(1, 24));
+	p.set("OH", uniform(1, 40));
+	p.set("OW", uniform(1, 40));
+	p.set("ALIGN", uniform(0, 1));
+	return p;
+}
+
+static bool validResize(const Params &p) {
+	for (auto name : {"N", "H", "W", "C", "OH", "OW"})
+		if (p(name) < 1)
+			return false;
+	return p("ALIGN") >= 0 && p("ALIGN") <= 1;
+}
+
+static bool allPositive(const Params &p, std::initializer_list<const char*> names) {
+	for (auto name : names)
+		if (p(name) < 1)
+			return false;
+	return true;
+}
+
+/// elementwise operators with broadcasting
+
+static const int NumElementwiseOps = 7; // see Kernels::Elementwise::Op
+
+static Params generateElementwise() {
+	Params p;
+	p.set("OP", uniform(0, NumElementwiseOps-1));
+	p.set("R", uniform(1, 4)); // the rank of the output, its dimensions are those of inputs
+	for (auto name : {"D0", "D1", "D2", "D3"})
+		p.set(name, chance(20) ? 1 : uniform(2, 9));
+	p.set("R1", uniform(1, p("R"))); // ranks of inputs: missing outer dimensions are broadcast
+	p.set("R2", uniform(1, p("R")));
+	p.set("M1", chance(30) ? 0 : uniform(0, 15)); // bits of output dimensions that are 1 in inputs
+	p.set("M2", chance(30) ? 0 : uniform(0, 15));
+	p.set("ACT", uniform(0, NumActivations-1));
+	return p;
+}
+
+static bool validElementwise(const Params &p) {
+	return allPositive(p, {"R", "D0", "D1", "D2", "D3", "R1", "R2"}) && p("OP") >= 0 && p("OP") < NumElementwiseOps &&
+		p("R") <= 4 && p("R1") <= p("R") && p("R2") <= p("R") &&
+		p("M1") >= 0 && p("M1") <= 15 && p("M2") >= 0 && p("M2") <= 15 && p("ACT") >= 0 && p("ACT") < NumActivations;
+}
+
+static void runElementwise(const Params &p, Outputs &outputs) {
+	unsigned R = p("R");
+	TensorShape fullShape;
+	for (unsigned d = 0; d < R; d++)
+		fullShape.push_back(p(STR("D" << d)));
+	auto inputShape = [&](unsigned rank, unsigned mask) {
+		TensorShape shape;
+		for (unsigned d = R - rank; d < R; d++)
+			shape.push_back(mask & (1 << d) ? 1 : fullShape[d]);
+		return shape;
+	};
+	auto shape1 = inputShape(p("R1"), p("M1")), shape2 = inputShape(p("R2"), p("M2"));
+	TensorShape outputShape(R, 1); // dimensions that neither input has are 1
+	for (auto shape : {&shape1, &shape2})
+		for (unsigned d = 0; d < shape->size(); d++)
+			outputShape[R - shape->size() + d] = std::max(outputShape[R - shape->size() + d], (*shape)[d]);
+	auto op = (Kernels::Elementwise::Op)p("OP");
+	auto input1 = randomData(shape1), input2 = randomData(shape2);
+	if (op == Kernels::Elementwise::Div) // divisors away from zero
+		for (auto &d : input2)
+			d += d < 0 ? -0.5f : 0.5f;
+	auto act = activation(p("ACT"));
+
+	// the naive loop: every output value is computed from input values at its indexes, that are 0 in broadcast dimensions
+	auto apply = [op](float a, float b) {
+		switch (op) {
+		case Kernels::Elementwise::Add:
+			return a + b;
+		case Kernels::Elementwise::Sub:
+			return a - b;
+		case Kernels::Elementwise::Mul:
+			return a*b;
+		case Kernels::Elementwise::Div:
+			return a/b;
+		case Kernels::Elementwise::Maximum:
+			return std::max(a, b);
+		case Kernels::Elementwise::Minimum:
+			return std::min(a, b);
+		case Kernels::Elementwise::SquaredDifference:
+			break;
+		}
+		return (a - b)*(a - b);
+	};
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	for (size_t i = 0; i < outputs.expected.size(); i++) {
+		size_t rest = i, index1 = 0, index2 = 0, stride1 = 1, stride2 = 1;
+		for (unsigned d = R; d-- > 0;) {
+			auto index = rest%outputShape[d];
+			rest /= outputShape[d];
+			auto accumulate = [R,d,index](const TensorShape &shape, size_t &flatIndex, size_t &stride) {
+				if (d + shape.size() < R)
+					return; // the input doesn't have this dimension
+				auto dim = shape[d + shape.size() - R];
+				flatIndex += (dim == 1 ? 0 : index)*stride;
+				stride *= dim;
+			};
+			accumulate(shape1, index1, stride1);
+			accumulate(shape2, index2, stride2);
+		}
+		outputs.expected[i] = apply(input1[index1], input2[index2]);
+	}
+	finishReference(act, outputs.expected, outputs.scale);
+
+	outputs.output.assign(outputs.expected.size(), Untouched);
+	if (!Kernels::Elementwise::compute(op, shape1, input1.data(), shape2, input2.data(), outputShape, outputs.output.data(), act))
+		outputs.output.assign(outputs.expected.size(), Untouched); // every value mismatches
+}
+
+/// quantized kernels: inputs are dequantized and computed by the reference implementation, its results are quantized
+
+using Kernels::Quantized::Quantization;
+
+// quantized outputs are compared as their integer values: they can be one step apart after different rounding
+static const Tolerance OneStep = {0, 1};
+
+// the real range of a clamping activation
+static void activationRange(int a, float &min, float &max) {
+	min = a == 1 || a == 2 ? 0 : a == 3 ? -1 : -Inf;
+	max = a == 2 ? 6 : a == 3 ? 1 : Inf;
+}
+
+// int8 tensors have zero points close to 0, uint8 ones close to 128
+template<typename T>
+static Quantization randomQuantization(float minScale, float maxScale) {
+	return {uniformReal(minScale, maxScale), std::is_signed<T>::value ? uniform(-20, 20) : uniform(108, 148)};
+}
+template<typename T>
+static std::vector<T> randomQuantized(const TensorShape &shape) {
+	std::vector<T> data(Tensor::flatSize(shape));
+	for (auto &d : data)
+		d = (T)uniform(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+	return data;
+}
+template<typename T>
+static std::vector<float> dequantized(const std::vector<T> &data, Quantization quantization) {
+	std::vector<float> real(data.size());
+	for (size_t i = 0; i < data.size(); i++)
+		real[i] = quantization.scale*((int32_t)data[i] - quantization.zeroPoint);
+	return real;
+}
+
+// the output quantization spans the values that the reference computed, so that outputs use most of the range of T
+template<typename T>
+static Quantization outputQuantization(const std::vector<float> &expected) {
+	float max = 0;
+	for (auto e : expected)
+		max = std::max(max, std::abs(e));
+	return {std::max(max, 1e-3f)/120, std::is_signed<T>::value ? uniform(-8, 8) : uniform(120, 136)};
+}
+
+// real values that the reference computed become quantized values in the range of the activation, like outputs of kernels
+template<typename T>
+static void quantizeReference(Quantization quantization, int activation, Outputs &outputs, int32_t &qmin, int32_t &qmax) {
+	float min, max;
+	activationRange(activation, min, max);
+	Kernels::Quantized::activationRange<T>(quantization, min, max, qmin, qmax);
+	for (auto &e : outputs.expected)
+		e = (float)std::clamp(quantization.zeroPoint + (int32_t)std::round(e/quantization.scale), qmin, qmax);
+	outputs.scale = 1;
+}
+
+// filters: int8 ones are symmetric like in TF Lite, with a scale per output channel or with one scale, uint8 ones have a zero point
+template<typename T>
+struct QuantizedFilter {
+	std::vector<T>       data;
+	std::vector<float>   scales;    // by output channel, or one
+	int32_t              zeroPoint;
+	std::vector<int16_t> offset;    // relative to the zero point, like kernels take them
+	std::vector<float>   real;
+};
+
+template<typename T>
+static QuantizedFilter<T> randomFilter(const TensorShape &shape, unsigned channelDim, bool perChannel) {
+	QuantizedFilter<T> filter;
+	filter.data = randomQuantized<T>(shape);
+	if constexpr (std::is_signed<T>::value)
+		for (auto &d : filter.data)
+			d = std::max(d, (T)-127);
+	for (unsigned c = 0, ce = perChannel ? shape[channelDim] : 1; c < ce; c++)
+		filter.scales.push_back(uniformReal(0.002, 0.02));
+	filter.zeroPoint = std::is_signed<T>::value ? 0 : uniform(108, 148);
+	filter.offset.resize(filter.data.size());
+	Kernels::Quantized::offsetValues(filter.data.data(), filter.data.size(), filter.zeroPoint, filter.offset.data());
+	auto inner = Tensor::sizeBetweenDims(shape, channelDim+1, shape.size()-1); // values of one channel are this far apart
+	for (size_t i = 0; i < filter.data.size(); i++) {
+		auto channel = filter.scales.size() == 1 ? 0 : (i/inner)%shape[channelDim];
+		filter.real.push_back(filter.scales[channel]*filter.offset[i]);
+	}
+	return filter;
+}
+
+// biases are int32 values with the scale inputScale*filterScale
+static std::vector<int32_t> randomBias(unsigned size) {
+	std::vector<int32_t> bias(size);
+	for (auto &b : bias)
+		b = uniform(-2000, 2000);
+	return bias;
+}
+template<typename T>
+static std::vector<float> realBias(const std::vector<int32_t> &bias, float inputScale, const QuantizedFilter<T> &filter) {
+	std::vector<float> real;
+	for (size_t c = 0; c < bias.size(); c++)
+		real.push_back(bias[c]*inputScale*filter.scales[filter.scales.size() == 1 ? 0 : c]);
+	return real;
+}
+
+template<typename T>
+static Kernels::Quantized::Requantization requantization(float inputScale, const QuantizedFilter<T> &filter, Quantization output, int32_t qmin, int32_t qmax) {
+	Kernels::Quantized::Requantization r;
+	for (auto scale : filter.scales)
+		r.multipliers.push_back(Kernels::Quantized::Multiplier((double)inputScale*scale/output.scale));
+	r.zeroPoint = output.zeroPoint;
+	r.min = qmin;
+	r.max = qmax;
+	return r;
+}
+
+template<typename T>
+static void runQuantizedConv2D(const Params &p, bool depthwise, Outputs &outputs) {
+	unsigned N = p("N"), H = p("H"), W = p("W"), KH = p("KH"), KW = p("KW");
+	unsigned C = depthwise ? p("C") : p("I"), MULT = depthwise ? p("MULT") : 1, O = depthwise ? C*MULT : p("O");
+	unsigned SH = p("SH"), SW = p("SW"), DH = p("DH"), DW = p("DW");
+	unsigned OH = outputSize(H, KH, SH, DH, p("SAME")), OW = outputSize(W, KW, SW, DW, p("SAME"));
+	unsigned PH = padding(H, KH, SH, DH, OH), PW = padding(W, KW, SW, DW, OW);
+	TensorShape inputShape = {N, H, W, C}, biasShape = {O}, outputShape = {N, OH, OW, O};
+	TensorShape filterShape = depthwise ? TensorShape{1, KH, KW, O} : TensorShape{O, KH, KW, C};
+	auto inputQuantization = randomQuantization<T>(0.005, 0.05);
+	auto input = randomQuantized<T>(inputShape);
+	auto filter = randomFilter<T>(filterShape, depthwise ? 3 : 0, p("PC"));
+	auto bias = randomBias(O);
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	if (depthwise)
+		NnOperators::Reference::DepthwiseConv2D(inputShape, dequantized(input, inputQuantization).data(), filterShape, filter.real.data(),
+			biasShape, realBias(bias, inputQuantization.scale, filter).data(), outputShape, outputs.expected.data(),
+			PW, PH, SW, SH, DW, DH, MULT, -Inf, Inf);
+	else
+		NnOperators::Reference::Conv2D(inputShape, dequantized(input, inputQuantization).data(), filterShape, filter.real.data(),
+			biasShape, realBias(bias, inputQuantization.scale, filter).data(), outputShape, outputs.expected.data(),
+			PW, PH, SW, SH, DW, DH, -Inf, Inf);
+	auto output = outputQuantization<T>(outputs.expected);
+	int32_t qmin, qmax;
+	quantizeReference<T>(output, p("ACT"), outputs, qmin, qmax);
+
+	std::vector<T> result(outputs.expected.size());
+	if (depthwise)
+		Kernels::Quantized::DepthwiseConv2D(inputShape, input.data(), inputQuantization.zeroPoint, filterShape, filter.offset.data(), bias.data(),
+			outputShape, result.data(), requantization(inputQuantization.scale, filter, output, qmin, qmax), PW, PH, SW, SH, DW, DH, MULT);
+	else
+		Kernels::Quantized::Conv2D(inputShape, input.data(), inputQuantization.zeroPoint, filterShape, filter.offset.data(), bias.data(),
+			outputShape, result.data(), requantization(inputQuantization.scale, filter, output, qmin, qmax), PW, PH, SW, SH, DW, DH);
+	outputs.output.assign(result.begin(), result.end());
+}
+
+template<typename T>
+static void runQuantizedFullyConnected(const Params &p, Outputs &outputs) {
+	unsigned N = p("N"), I = p("I"), O = p("O");
+	TensorShape inputShape = {N, I}, filterShape = {O, I}, biasShape = {O}, outputShape = {N, O};
+	auto inputQuantization = randomQuantization<T>(0.005, 0.05);
+	auto input = randomQuantized<T>(inputShape);
+	auto filter = randomFilter<T>(filterShape, 0, p("PC"));
+	auto bias = randomBias(O);
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	NnOperators::Reference::FullyConnected(inputShape, dequantized(input, inputQuantization).data(), filterShape, filter.real.data(),
+		biasShape, realBias(bias, inputQuantization.scale, filter).data(), outputShape, outputs.expected.data(), -Inf, Inf);
+	auto output = outputQuantization<T>(outputs.expected);
+	int32_t qmin, qmax;
+	quantizeReference<T>(output, p("ACT"), outputs, qmin, qmax);
+
+	std::vector<T> result(outputs.expected.size());
+	std::vector<int16_t> inputScratch(input.size());
+	Kernels::Quantized::FullyConnected(inputShape, input.data(), inputQuantization.zeroPoint, inputScratch.data(), filterShape, filter.offset.data(),
+		bias.data(), outputShape, result.data(), requantization(inputQuantization.scale, filter, output, qmin, qmax));
+	outputs.output.assign(result.begin(), result.end());
+}
+
+template<typename T>
+static void runQuantizedAdd(const Params &p, Outputs &outputs) {
+	size_t size = p("N"), size2 = p("SCALAR") ? 1 : size;
+	auto quantization1 = randomQuantization<T>(0.005, 0.05), quantization2 = randomQuantization<T>(0.005, 0.05);
+	auto input1 = randomQuantized<T>({(unsigned)size}), input2 = randomQuantized<T>({(unsigned)size2});
+
+	auto real1 = dequantized(input1, quantization1), real2 = dequantized(input2, quantization2);
+	for (size_t i = 0; i < size; i++)
+		outputs.expected.push_back(real1[i] + real2[size2 == 1 ? 0 : i]);
+	auto output = outputQuantization<T>(outputs.expected);
+	int32_t qmin, qmax;
+	quantizeReference<T>(output, p("ACT"), outputs, qmin, qmax);
+
+	std::vector<T> result(size);
+	Kernels::Quantized::Add(size, input1.data(), quantization1, size2, input2.data(), quantization2, result.data(), output, qmin, qmax);
+	outputs.output.assign(result.begin(), result.end());
+}
+
+template<typename T, typename Fn, typename RefFn>
+static void runQuantizedPool(const Params &p, Fn fn, RefFn refFn, Outputs &outputs) {
+	unsigned N = p("N"), H = p("H"), W = p("W"), C = p("C"), FH = p("FH"), FW = p("FW"), SH = p("SH"), SW = p("SW");
+	unsigned OH = outputSize(H, FH, SH, 1, p("SAME")), OW = outputSize(W, FW, SW, 1, p("SAME"));
+	unsigned PH = padding(H, FH, SH, 1, OH), PW = padding(W, FW, SW, 1, OW);
+	TensorShape inputShape = {N, H, W, C}, outputShape = {N, OH, OW, C};
+	auto quantization = randomQuantization<T>(0.01, 0.1); // pools keep it
+	auto input = randomQuantized<T>(inputShape);
+
+	outputs.expected.resize(Tensor::flatSize(outputShape));
+	refFn(inputShape, dequantized(input, quantization).data(), outputShape, outputs.expected.data(), PW, PH, SW, SH, FW, FH, -Inf, Inf);
+	int32_t qmin, qmax;
+	quantizeReference<T>(quantization, p("ACT"), outputs, qmin, qmax);
+
+	std::vector<T> result(outputs.expected.size());
+	fn(inputShape, input.data(), outputShape, result.data(), PW, PH, SW, SH, FW, FH, qmin, qmax);
+	outputs.output.assign(result.begin(), result.end());
+}
+
+template<typename T>
+static void runQuantizedSoftmax(const Params &p, Outputs &outputs) {
+	TensorShape shape = {(unsigned)p("N"), (unsigned)p("C")};
+	auto inputQuantization = randomQuantization<T>(0.01, 0.2);
+	auto input = randomQuantized<T>(shape);
+	Quantization output = {1.f/256, std::is_signed<T>::value ? -128 : 0}; // like in TF Lite
+
+	outputs.expected.resize(input.size());
+	NnOperators::Reference::Softmax(shape, dequantized(input, inputQuantization).data(), shape, outputs.expected.data(), p("BETA")/8.f);
+	int32_t qmin, qmax;
+	quantizeReference<T>(output, 0/*none*/, outputs, qmin, qmax);
+
+	std::vector<T> result(input.size());
+	Kernels::Quantized::Softmax(shape, input.data(), inputQuantization.scale, p("BETA")/8.f, result.data(), output);
+	outputs.output.assign(result.begin(), result.end());
+}
+
+// variants of quantized kernels: U selects uint8 instead of int8, PC selects a filter scale per output channel
+static Params generateQuantized(Params p) {
+	p.set("ACT", uniform(0, NumClampActivations-1));
+	p.set("U", uniform(0, 1));
+	return p;
+}
+static bool validQuantized(const Params &p) {
+	return p("ACT") >= 0 && p("ACT") < NumClampActivations && p("U") >= 0 && p("U") <= 1;
+}
+static Params generateQuantizedWithFilter(Params p) {
+	p = generateQuantized(p);
+	p.set("PC", uniform(0, 1));
+	return p;
+}
+static bool validQuantizedWithFilter(const Params &p) {
+	return validQuantized(p) && p("PC") >= 0 && p("PC") <= 1;
+}
+
+static const std::vector<Check>& allChecks() {
+	static const std::vector<Check> checks = {
+		{"Conv2D", {4, 1e-5},
+			[]() {return generateConvolution(false);},
+			[](const Params &p) {return validConvolution(p, false);},
+			[](const Params &p, Outputs &outputs) {runConv2D(p, Float32, outputs);}
+		},
+		{"Conv2D/float16", {4, 1e-5},
+			[]() {return generateConvolution(false);},
+			[](const Params &p) {return validConvolution(p, false);},
+			[](const Params &p, Outputs &outputs) {runConv2D(p, Float16, outputs);}
+		},
+		{"Conv2D/outputStride", {4, 1e-5},
+			[]() {return generateConvolution(false);},
+			[](const Params &p) {return validConvolution(p, false);},
+			[](const Params &p, Outputs &outputs) {runConv2D(p, OutputStride, outputs);}
+		},
+		{"Conv2D/Winograd", {4, 1e-4}, // transforms add rounding errors, F(4x4,3x3) more than F(2x2,3x3)
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 2));
+				p.set("H", uniform(1, 24));
+				p.set("W", uniform(1, 24));
+				p.set("I", uniform(1, 48));
+				p.set("O", uniform(1, 48));
+				p.set("M", chance(50) ? 2 : 4);
+				p.set("SAME", uniform(0, 1));
+				p.set("ACT", uniform(0, NumActivations-1));
+				p.set("X", uniform(0, 8));
+				if (!p("SAME")) {
+					p.set("H", std::max(p("H"), 3));
+					p.set("W", std::max(p("W"), 3));
+				}
+				return p;
+			},
+			[](const Params &p) {
+				return allPositive(p, {"N", "H", "W", "I", "O"}) && (p("M") == 2 || p("M") == 4) && p("X") >= 0 &&
+					p("SAME") >= 0 && p("SAME") <= 1 && p("ACT") >= 0 && p("ACT") < NumActivations &&
+					outputSize(p("H"), 3, 1, 1, p("SAME")) > 0 && outputSize(p("W"), 3, 1, 1, p("SAME")) > 0;
+			},
+			runWinograd
+		},
+		{"DepthwiseConv2D", {4, 1e-5},
+			[]() {return generateConvolution(true);},
+			[](const Params &p) {return validConvolution(p, true);},
+			runDepthwiseConv2D
+		},
+		{"FullyConnected", {4, 1e-5},
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 4));
+				p.set("I", uniform(1, 300));
+				p.set("O", uniform(1, 300));
+				p.set("ACT", uniform(0, NumActivations-1));
+				return p;
+			},
+			[](const Params &p) {return allPositive(p, {"N", "I", "O"}) && p("ACT") >= 0 && p("ACT") < NumActivations;},
+			[](const Params &p, Outputs &outputs) {runFullyConnected(p, false, outputs);}
+		},
+		{"FullyConnected/float16", {4, 1e-5},
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 4));
+				p.set("I", uniform(1, 300));
+				p.set("O", uniform(1, 300));
+				p.set("ACT", uniform(0, NumActivations-1));
+				return p;
+			},
+			[](const Params &p) {return allPositive(p, {"N", "I", "O"}) && p("ACT") >= 0 && p("ACT") < NumActivations;},
+			[](const Params &p, Outputs &outputs) {runFullyConnected(p, true, outputs);}
+		},
+		{"MaxPool", {0, 0},
+			generatePool,
+			validPool,
+			[](const Params &p, Outputs &outputs) {
+				runPool(p, NnOperators::MaxPool, NnOperators::Reference::MaxPool, outputs);
+			}
+		},
+		{"AveragePool", {4, 1e-6},
+			generatePool,
+			validPool,
+			[](const Params &p, Outputs &outputs) {
+				runPool(p, NnOperators::AveragePool, NnOperators::Reference::AveragePool, outputs);
+			}
+		},
+		{"Softmax", {4, 1e-6},
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 6));
+				p.set("C", uniform(1, 1100));
+				p.set("BETA", uniform(1, 16)); // in eighths
+				return p;
+			},
+			[](const Params &p) {return allPositive(p, {"N", "C", "BETA"});},
+			[](const Params &p, Outputs &outputs) {
+				TensorShape shape = {(unsigned)p("N"), (unsigned)p("C")};
+				auto input = randomData(shape, 8);
+				outputs.expected.resize(input.size());
+				NnOperators::Reference::Softmax(shape, input.data(), shape, outputs.expected.data(), p("BETA")/8.f);
+				outputs.output.resize(input.size());
+				NnOperators::Softmax(shape, input.data(), shape, outputs.output.data(), p("BETA")/8.f);
+			}
+		},
+		{"ResizeBilinear", {4, 1e-6},
+			generateResize,
+			validResize,
+			[](const Params &p, Outputs &outputs) {
+				runResize(p, NnOperators::ResizeBilinear, NnOperators::Reference::ResizeBilinear, outputs);
+			}
+		},
+		{"ResizeNearestNeighbor", {0, 0},
+			[]() {
+				auto p = generateResize();
+				p.set("ALIGN", 0); // the reference implementation doesn't support aligned corners
+				return p;
+			},
+			[](const Params &p) {return validResize(p) && p("ALIGN") == 0;},
+			[](const Params &p, Outputs &outputs) {
+				runResize(p, NnOperators::ResizeNearestNeighbor, NnOperators::Reference::ResizeNearestNeighbor, outputs);
+			}
+		},
+		{"LocalResponseNormalization", {4, 1e-6},
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 2));
+				p.set("H", uniform(1, 12));
+				p.set("W", uniform(1, 12));
+				p.set("C", uniform(1, 100));
+				p.set("R", uniform(0, 6));
+				return p;
+			},
+			[](const Params &p) {return allPositive(p, {"N", "H", "W", "C"}) && p("R") >= 0;},
+			[](const Params &p, Outputs &outputs) {
+				TensorShape shape = {(unsigned)p("N"), (unsigned)p("H"), (unsigned)p("W"), (unsigned)p("C")};
+				auto input = randomData(shape, 4);
+				auto alpha = uniformReal(1e-4, 1e-1), beta = uniformReal(0.5, 1), bias = uniformReal(0.5, 2);
+				outputs.expected.resize(input.size());
+				NnOperators::Reference::LocalResponseNormalization(shape, input.data(), shape, outputs.expected.data(), p("R"), alpha, beta, bias);
+				outputs.output.resize(input.size());
+				NnOperators::LocalResponseNormalization(shape, input.data(), shape, outputs.output.data(), p("R"), alpha, beta, bias);
+			}
+		},
+		{"Mean", {4, 1e-6},
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 3));
+				p.set("H", uniform(1, 16));
+				p.set("W", uniform(1, 16));
+				p.set("C", uniform(1, 300));
+				p.set("SWAP", uniform(0, 1)); // axes are {2,1} instead of {1,2}
+				return p;
+			},
+			[](const Params &p) {return allPositive(p, {"N", "H", "W", "C"}) && p("SWAP") >= 0 && p("SWAP") <= 1;},
+			[](const Params &p, Outputs &outputs) {
+				TensorShape inputShape = {(unsigned)p("N"), (unsigned)p("H"), (unsigned)p("W"), (unsigned)p("C")};
+				TensorShape outputShape = {(unsigned)p("N"), 1, 1, (unsigned)p("C")};
+				int32_t axis[2] = {1, 2};
+				if (p("SWAP"))
+					std::swap(axis[0], axis[1]);
+				auto input = randomData(inputShape);
+				outputs.expected.resize(Tensor::flatSize(outputShape));
+				NnOperators::Reference::Mean(inputShape, input.data(), outputShape, outputs.expected.data(), axis, 2);
+				outputs.output.resize(outputs.expected.size());
+				NnOperators::Mean(inputShape, input.data(), outputShape, outputs.output.data(), axis, 2);
+			}
+		},
+		{"Pad", {0, 0},
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 2));
+				p.set("H", uniform(1, 16));
+				p.set("W", uniform(1, 16));
+				p.set("C", uniform(1, 24));
+				for (auto name : {"PN0", "PN1", "PH0", "PH1", "PW0", "PW1", "PC0", "PC1"})
+					p.set(name, chance(30) ? 0 : uniform(0, 3));
+				return p;
+			},
+			[](const Params &p) {
+				for (auto name : {"PN0", "PN1", "PH0", "PH1", "PW0", "PW1", "PC0", "PC1"})
+					if (p(name) < 0)
+						return false;
+				return allPositive(p, {"N", "H", "W", "C"});
+			},
+			[](const Params &p, Outputs &outputs) {
+				std::array<int32_t,2> paddings[4] = {{p("PN0"), p("PN1")}, {p("PH0"), p("PH1")}, {p("PW0"), p("PW1")}, {p("PC0"), p("PC1")}};
+				TensorShape inputShape = {(unsigned)p("N"), (unsigned)p("H"), (unsigned)p("W"), (unsigned)p("C")}, outputShape;
+				for (unsigned i = 0; i < 4; i++)
+					outputShape.push_back(inputShape[i] + paddings[i][0] + paddings[i][1]);
+				auto input = randomData(inputShape);
+				outputs.expected.resize(Tensor::flatSize(outputShape));
+				NnOperators::Reference::Pad(paddings, inputShape, input.data(), outputShape, outputs.expected.data());
+				outputs.output.assign(outputs.expected.size(), Untouched); // all values have to be written
+				NnOperators::Pad(paddings, inputShape, input.data(), outputShape, outputs.output.data());
+			}
+		},
+		{"Elementwise", {4, 1e-6},
+			generateElementwise,
+			validElementwise,
+			runElementwise
+		},
+		{"Conv2D/quantized", OneStep,
+			[]() {return generateQuantizedWithFilter(generateConvolution(false));},
+			[](const Params &p) {return validConvolution(p, false) && validQuantizedWithFilter(p);},
+			[](const Params &p, Outputs &outputs) {
+				p("U") ? runQuantizedConv2D<uint8_t>(p, false, outputs) : runQuantizedConv2D<int8_t>(p, false, outputs);
+			}
+		},
+		{"DepthwiseConv2D/quantized", OneStep,
+			[]() {return generateQuantizedWithFilter(generateConvolution(true));},
+			[](const Params &p) {return validConvolution(p, true) && validQuantizedWithFilter(p);},
+			[](const Params &p, Outputs &outputs) {
+				p("U") ? runQuantizedConv2D<uint8_t>(p, true, outputs) : runQuantizedConv2D<int8_t>(p, true, outputs);
+			}
+		},
+		{"FullyConnected/quantized", OneStep,
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 4));
+				p.set("I", uniform(1, 300));
+				p.set("O", uniform(1, 300));
+				return generateQuantizedWithFilter(p);
+			},
+			[](const Params &p) {return allPositive(p, {"N", "I", "O"}) && validQuantizedWithFilter(p);},
+			[](const Params &p, Outputs &outputs) {
+				p("U") ? runQuantizedFullyConnected<uint8_t>(p, outputs) : runQuantizedFullyConnected<int8_t>(p, outputs);
+			}
+		},
+		{"Add/quantized", OneStep,
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 1000));
+				p.set("SCALAR", chance(20));
+				return generateQuantized(p);
+			},
+			[](const Params &p) {return allPositive(p, {"N"}) && p("SCALAR") >= 0 && p("SCALAR") <= 1 && validQuantized(p);},
+			[](const Params &p, Outputs &outputs) {
+				p("U") ? runQuantizedAdd<uint8_t>(p, outputs) : runQuantizedAdd<int8_t>(p, outputs);
+			}
+		},
+		{"MaxPool/quantized", OneStep,
+			[]() {return generateQuantized(generatePool());},
+			[](const Params &p) {return validPool(p) && validQuantized(p);},
+			[](const Params &p, Outputs &outputs) {
+				if (p("U"))
+					runQuantizedPool<uint8_t>(p, Kernels::Quantized::MaxPool<uint8_t>, NnOperators::Reference::MaxPool, outputs);
+				else
+					runQuantizedPool<int8_t>(p, Kernels::Quantized::MaxPool<int8_t>, NnOperators::Reference::MaxPool, outputs);
+			}
+		},
+		{"AveragePool/quantized", OneStep,
+			[]() {return generateQuantized(generatePool());},
+			[](const Params &p) {return validPool(p) && validQuantized(p);},
+			[](const Params &p, Outputs &outputs) {
+				if (p("U"))
+					runQuantizedPool<uint8_t>(p, Kernels::Quantized::AveragePool<uint8_t>, NnOperators::Reference::AveragePool, outputs);
+				else
+					runQuantizedPool<int8_t>(p, Kernels::Quantized::AveragePool<int8_t>, NnOperators::Reference::AveragePool, outputs);
+			}
+		},
+		{"Softmax/quantized", OneStep,
+			[]() {
+				Params p;
+				p.set("N", uniform(1, 6));
+				p.set("C", uniform(1, 1100));
+				p.set("BETA", uniform(1, 16)); // in eighths
+				p.set("U", uniform(0, 1));
+				return p;
+			},
+			[](const Params &p) {return allPositive(p, {"N", "C", "BETA"}) && p("U") >= 0 && p("U") <= 1;},
+			[](const Params &p, Outputs &outputs) {
+				p("U") ? runQuantizedSoftmax<uint8_t>(p, outputs) : runQuantizedSoftmax<int8_t>(p, outputs);
+			}
+		}
+	};
+	return checks;
+}
+
+/// running cases
+
+static bool passes(const Check &check, const Params &params, unsigned seed, Mismatch &mismatch) {
+	Rng::generator.seed(seed);
+	Outputs outputs;
+	check.run(params, outputs);
+	return compare(outputs, check.tolerance, mismatch);
+}
+
+// greedily makes parameters smaller while the case still fails: halving first, then decrementing
+static Params shrink(const Check &check, Params params, unsigned seed) {
+	Mismatch mismatch;
+	for (bool shrunk = true; shrunk;) {
+		shrunk = false;
+		for (size_t i = 0; i < params.size(); i++)
+			for (auto smaller : {params[i]/2, params[i]-1}) {
+				if (smaller < 0 || smaller >= params[i])
+					continue;
+				auto p = params;
+				p[i] = smaller;
+				if (check.valid(p) && !passes(check, p, seed, mismatch)) {
+					params = p;
+					shrunk = true;
+					break;
+				}
+			}
+	}
+	return params;
+}
+
+static void printReproducer(const Check &check, const Params &params, unsigned seed, const Mismatch &mismatch) {
+	PRINT(check.kernel << ": FAILED with the seed " << seed << " and parameters " << params.str())
+	PRINT("  output value #" << mismatch.index << " is " << mismatch.value << " instead of " << mismatch.expected <<
+	      " (" << ulpDistance(mismatch.value, mismatch.expected) << " ULPs apart, the difference of " << mismatch.allowed << " is allowed)")
+	PRINT("  reproduce with: nn-operators-bench --check --kernel " << check.kernel << " --seed " << seed << " --case " << params.str())
+}
+
+static bool matches(const std::string &variant, const std::string &kernel) { // "Conv2D" selects all Conv2D variants
+	return kernel.empty() || variant == kernel || variant.compare(0, kernel.size()+1, kernel + "/") == 0;
+}
+
+unsigned checkRandomCases(const std::string &kernel, unsigned iterations, unsigned seed) {
+	unsigned numVariants = 0, numFailed = 0;
+	for (auto &check : allChecks()) {
+		if (!matches(check.kernel, kernel))
+			continue;
+		numVariants++;
+		unsigned numPassed = 0;
+		for (unsigned i = 0; i < iterations; i++) {
+			auto caseSeed = seed + i; // every case is reproducible on its own
+			Rng::generator.seed(caseSeed);
+			auto params = check.generate();
+			assert(check.valid(params));
+			Mismatch mismatch;
+			if (passes(check, params, caseSeed, mismatch)) {
+				numPassed++;
+				continue;
+			}
+			params = shrink(check, params, caseSeed);
+			passes(check, params, caseSeed, mismatch);
+			printReproducer(check, params, caseSeed, mismatch);
+		}
+		PRINT(check.kernel << ": " << numPassed << " out of " << iterations << " cases passed")
+		numFailed += iterations - numPassed;
+	}
+	if (numVariants == 0)
+		FAIL("no kernel variants match '" << kernel << "'")
+	return numFailed;
+}
+
+bool checkCase(const std::string &kernel, const std::string &params, unsigned seed) {
+	for (auto &check : allChecks()) {
+		if (check.kernel != kernel)
+			continue;
+		Params p;
+		if (!Params::parse(params, p) || !check.valid(p))
+			FAIL("invalid parameters '" << params << "' for the kernel variant " << kernel)
+		Mismatch mismatch;
+		if (!passes(check, p, seed, mismatch)) {
+			printReproducer(check, p, seed, mismatch);
+			return false;
+		}
+		PRINT(check.kernel << ": the case passed")
+		return true;
+	}
+	FAIL("no kernel variant '" << kernel << "'")
+}
+
+}
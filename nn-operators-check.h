@@ -0,0 +1,23 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include <string>
+
+//
+// NnOperatorsCheck: compares optimized kernels with the TF Lite reference implementation on random cases
+//                   elementwise kernels are compared with a naive broadcasting loop, integer kernels with the reference
+//                   on dequantized values whose results are quantized, within one quantization step
+//                   every case is defined by a few integer parameters and a seed that random data is generated from,
+//                   failing cases are shrunk to the smallest parameters that still fail and are printed as reproducers
+//
+
+namespace NnOperatorsCheck {
+
+// runs 'iterations' random cases of every kernel variant, or of variants of 'kernel' only, returns the number of failed cases
+unsigned checkRandomCases(const std::string &kernel, unsigned iterations, unsigned seed);
+
+// runs one case given as printed by a reproducer: 'params' is like "N=1,H=5,W=3", returns whether it has passed
+bool checkCase(const std::string &kernel, const std::string &params, unsigned seed);
+
+}
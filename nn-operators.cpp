@@ -1,13 +1,343 @@
 // Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
 
 #include "nn-operators.h"
+#include "thread-pool.h"
+#include "kernels/conv.h"
+#include "kernels/depthwise.h"
+#include "kernels/fully-connected.h"
 #include "misc.h"
 #include "tensor.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstring>
+#include <functional>
+#include <limits>
+
+#include <assert.h>
 
 namespace NnOperators {
+
+//
+// local helpers
+//
+
+// work (multiply-adds or touched elements) below which it isn't worth handing a slice to another thread
+static const size_t MinWorkPerSlice = 32*1024;
+
+static size_t grainFor(size_t workPerItem) {
+	return std::max(MinWorkPerSlice/std::max(workPerItem, (size_t)1), (size_t)1);
+}
+
+// splits the range [begin,end) of items counted across all outer indexes (batches, etc) into per-outer slices
+static void forEachSlice(size_t begin, size_t end, unsigned itemsPerOuter, const std::function<void(unsigned outer, unsigned i0, unsigned i1)> &fn) {
+	while (begin < end) {
+		unsigned outer = begin/itemsPerOuter, i0 = begin%itemsPerOuter;
+		unsigned i1 = std::min((size_t)itemsPerOuter, i0 + (end-begin));
+		fn(outer, i0, i1);
+		begin += i1-i0;
+	}
+}
+
+// row slices shift the padding by (firstRow*stride), the reference implementation keeps padding values in int16
+static bool canSliceRows(unsigned rows, unsigned stride) {
+	return (size_t)rows*stride <= (size_t)std::numeric_limits<int16_t>::max();
+}
+
+// the reference implementations clamp values when they store them, other activations are applied to slices that they just computed
+static float activationMin(const Kernels::Activation &activation) {
+	return activation.kind == Kernels::Activation::Clamp ? activation.min : -std::numeric_limits<float>::infinity();
+}
+static float activationMax(const Kernels::Activation &activation) {
+	return activation.kind == Kernels::Activation::Clamp ? activation.max : std::numeric_limits<float>::infinity();
+}
+static void finishSlice(const Kernels::Activation &activation, float *data, size_t size) {
+	if (activation.kind != Kernels::Activation::Clamp)
+		activation.apply(data, size);
+}
+
+//
+// operators: work is split by batches and output rows (depthwise convolutions, pools, resize), by channels (Mean) or by outer rows
+//
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Kernels::Activation &activation,
+	unsigned outputStride
+) {
+	Kernels::Conv2D(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData,
+		paddingWidth, paddingHeight, strideWidth, strideHeight, dilationWidthFactor, dilationHeightFactor, activation, outputStride); // splits its work itself
+}
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Kernels::Activation &activation,
+	unsigned outputStride
+) {
+	Kernels::Conv2D(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData,
+		paddingWidth, paddingHeight, strideWidth, strideHeight, dilationWidthFactor, dilationHeightFactor, activation, outputStride); // splits its work itself
+}
+
+void DepthwiseConv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	unsigned depthMultiplier,
+	const Kernels::Activation &activation
+) {
+	if (Kernels::Depthwise::applicable(filterShape, strideWidth, strideHeight, dilationWidthFactor, dilationHeightFactor, depthMultiplier))
+		return Kernels::Depthwise::Conv2D(inputShape, inputData, filterShape, filterData, biasData, outputShape, outputData,
+			paddingWidth, paddingHeight, strideWidth, strideHeight, activation); // splits its work itself
+
+	// unusual shapes: the reference implementation
+	auto batches = outputShape[0], rows = outputShape[1];
+	if (!canSliceRows(rows, strideHeight)) {
+		Reference::DepthwiseConv2D(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData,
+			paddingWidth, paddingHeight, strideWidth, strideHeight, dilationWidthFactor, dilationHeightFactor, depthMultiplier,
+			activationMin(activation), activationMax(activation));
+		return finishSlice(activation, outputData, Tensor::flatSize(outputShape));
+	}
+
+	auto inputBatchSize = Tensor::sizeBetweenDims(inputShape, 1, 3);
+	auto outputRowSize = outputShape[2]*outputShape[3];
+	TensorShape inputBatchShape = {1, inputShape[1], inputShape[2], inputShape[3]};
+
+	ThreadPool::parallelFor(batches*rows, grainFor(outputRowSize*filterShape[1]*filterShape[2]), [&](size_t begin, size_t end) {
+		forEachSlice(begin, end, rows, [&](unsigned b, unsigned r0, unsigned r1) {
+			Reference::DepthwiseConv2D(
+				inputBatchShape, inputData + b*inputBatchSize,
+				filterShape, filterData,
+				biasShape, biasData,
+				{1, r1-r0, outputShape[2], outputShape[3]}, outputData + (b*rows + r0)*outputRowSize,
+				paddingWidth, (int)paddingHeight - (int)(r0*strideHeight),
+				strideWidth, strideHeight,
+				dilationWidthFactor, dilationHeightFactor,
+				depthMultiplier,
+				activationMin(activation), activationMax(activation)
+			);
+			finishSlice(activation, outputData + (b*rows + r0)*outputRowSize, (r1-r0)*outputRowSize);
+		});
+	});
+}
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Kernels::Activation &activation
+) {
+	Kernels::FullyConnected(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData, activation); // splits its work itself
+}
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Kernels::Activation &activation
+) {
+	Kernels::FullyConnected(inputShape, inputData, filterShape, filterData, biasShape, biasData, outputShape, outputData, activation); // splits its work itself
+}
+
+template<void(*ReferencePool)(const TensorShape&, const float*, const TensorShape&, float*, int, int, unsigned, unsigned, unsigned, unsigned, float, float)>
+static void Pool(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	const Kernels::Activation &activation
+) {
+	auto batches = outputShape[0], rows = outputShape[1];
+	if (!canSliceRows(rows, strideHeight)) {
+		ReferencePool(inputShape, inputData, outputShape, outputData,
+			paddingWidth, paddingHeight, strideWidth, strideHeight, filterWidth, filterHeight,
+			activationMin(activation), activationMax(activation));
+		return finishSlice(activation, outputData, Tensor::flatSize(outputShape));
+	}
+
+	auto inputBatchSize = Tensor::sizeBetweenDims(inputShape, 1, 3);
+	auto outputRowSize = outputShape[2]*outputShape[3];
+	TensorShape inputBatchShape = {1, inputShape[1], inputShape[2], inputShape[3]};
+
+	ThreadPool::parallelFor(batches*rows, grainFor(outputRowSize*filterWidth*filterHeight), [&](size_t begin, size_t end) {
+		forEachSlice(begin, end, rows, [&](unsigned b, unsigned r0, unsigned r1) {
+			ReferencePool(
+				inputBatchShape, inputData + b*inputBatchSize,
+				{1, r1-r0, outputShape[2], outputShape[3]}, outputData + (b*rows + r0)*outputRowSize,
+				paddingWidth, (int)paddingHeight - (int)(r0*strideHeight),
+				strideWidth, strideHeight,
+				filterWidth, filterHeight,
+				activationMin(activation), activationMax(activation)
+			);
+			finishSlice(activation, outputData + (b*rows + r0)*outputRowSize, (r1-r0)*outputRowSize);
+		});
+	});
+}
+
+void MaxPool(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	const Kernels::Activation &activation
+) {
+	Pool<Reference::MaxPool>(inputShape, inputData, outputShape, outputData,
+		paddingWidth, paddingHeight, strideWidth, strideHeight, filterWidth, filterHeight, activation);
+}
+
+void AveragePool(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	const Kernels::Activation &activation
+) {
+	Pool<Reference::AveragePool>(inputShape, inputData, outputShape, outputData,
+		paddingWidth, paddingHeight, strideWidth, strideHeight, filterWidth, filterHeight, activation);
+}
+
+void Softmax(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	float beta
+) {
+	auto depth = *inputShape.rbegin();
+	ThreadPool::parallelFor(Tensor::flatSize(inputShape)/depth, grainFor(depth*8), [&](size_t begin, size_t end) {
+		Reference::Softmax(
+			{unsigned(end-begin), depth}, inputData + begin*depth,
+			{unsigned(end-begin), depth}, outputData + begin*depth,
+			beta
+		);
+	});
+}
+
+void ResizeBilinear(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	bool alignCorners
+) {
+	if (inputShape.size() != 4 || outputShape.size() != 4)
+		return Reference::ResizeBilinear(inputShape, inputData, outputShape, outputData, alignCorners);
+
+	// same arithmetic as in the reference implementation, rows are computed in parallel
+	int batches = outputShape[0], depth = outputShape[3];
+	int inputHeight = inputShape[1], inputWidth = inputShape[2];
+	int outputHeight = outputShape[1], outputWidth = outputShape[2];
+	assert(inputShape[0]==outputShape[0] && inputShape[3]==outputShape[3]);
+
+	float heightScale = static_cast<float>(inputHeight) / outputHeight;
+	float widthScale = static_cast<float>(inputWidth) / outputWidth;
+	if (alignCorners && outputHeight > 1)
+		heightScale = static_cast<float>(inputHeight - 1) / (outputHeight - 1);
+	if (alignCorners && outputWidth > 1)
+		widthScale = static_cast<float>(inputWidth - 1) / (outputWidth - 1);
+
+	ThreadPool::parallelFor(batches*outputHeight, grainFor(outputWidth*depth*4), [&](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; row++) {
+			int b = row/outputHeight, y = row%outputHeight;
+			auto input = inputData + (size_t)b*inputHeight*inputWidth*depth;
+			auto output = outputData + row*outputWidth*depth;
+			float inputY = y * heightScale;
+			int y0 = static_cast<int>(std::floor(inputY));
+			int y1 = std::min(y0 + 1, inputHeight - 1);
+			for (int x = 0; x < outputWidth; x++) {
+				float inputX = x * widthScale;
+				int x0 = static_cast<int>(std::floor(inputX));
+				int x1 = std::min(x0 + 1, inputWidth - 1);
+				auto in00 = input + (y0*inputWidth + x0)*depth;
+				auto in10 = input + (y1*inputWidth + x0)*depth;
+				auto in01 = input + (y0*inputWidth + x1)*depth;
+				auto in11 = input + (y1*inputWidth + x1)*depth;
+				for (int c = 0; c < depth; c++)
+					*output++ =
+						in00[c] * (1 - (inputY - y0)) * (1 - (inputX - x0)) +
+						in10[c] * (inputY - y0) * (1 - (inputX - x0)) +
+						in01[c] * (1 - (inputY - y0)) * (inputX - x0) +
+						in11[c] * (inputY - y0) * (inputX - x0);
+			}
+		}
+	});
+}
+
+void ResizeNearestNeighbor(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	bool alignCorners
+) {
+	Reference::ResizeNearestNeighbor(inputShape, inputData, outputShape, outputData, alignCorners); // only copies data
+}
+
+void LocalResponseNormalization(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	int radius, float alpha, float beta, float bias
+) {
+	auto depth = *inputShape.rbegin();
+	ThreadPool::parallelFor(Tensor::flatSize(inputShape)/depth, grainFor(depth*(2*radius+8)), [&](size_t begin, size_t end) {
+		Reference::LocalResponseNormalization(
+			{unsigned(end-begin), depth}, inputData + begin*depth,
+			{unsigned(end-begin), depth}, outputData + begin*depth,
+			radius, alpha, beta, bias
+		);
+	});
+}
+
+void Mean(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	const int32_t *axis, unsigned axis_count
+) {
+	// only averaging over height and width is supported, like in the reference implementation
+	if (inputShape.size() != 4 || axis_count != 2 || !((axis[0]==1 && axis[1]==2) || (axis[0]==2 && axis[1]==1)))
+		return Reference::Mean(inputShape, inputData, outputShape, outputData, axis, axis_count);
+
+	// the summation order for every channel is the same as in the reference implementation
+	unsigned batches = inputShape[0], height = inputShape[1], width = inputShape[2], depth = inputShape[3];
+	assert(Tensor::flatSize(outputShape) == batches*depth);
+
+	ThreadPool::parallelFor(batches*depth, grainFor(height*width), [&](size_t begin, size_t end) {
+		forEachSlice(begin, end, depth, [&](unsigned b, unsigned c0, unsigned c1) {
+			float sums[c1-c0];
+			std::fill(sums, sums+(c1-c0), 0);
+			auto input = inputData + (size_t)b*height*width*depth;
+			for (unsigned p = 0, pe = height*width; p < pe; p++, input += depth)
+				for (unsigned c = c0; c < c1; c++)
+					sums[c-c0] += input[c];
+			for (unsigned c = c0; c < c1; c++)
+				outputData[b*depth + c] = sums[c-c0] / (width * height);
+		});
+	});
+}
+
+void Pad(
+	const std::array<int32_t,2>* paddings,
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData
+) {
+	Reference::Pad(paddings, inputShape, inputData, outputShape, outputData); // only copies data
+}
+
 /*
 void MirrorPad(
 	const std::array<int32_t,2>* paddings,
@@ -3,9 +3,12 @@
 #pragma once
 
 #include "tensor.h"
+#include "kernels/activation.h"
 
 #include <array>
 
+#include <half.hpp>
+
 namespace NnOperators {
 
 void Conv2D(
@@ -15,7 +18,21 @@ void Conv2D(
 	const TensorShape &outputShape, float *outputData,
 	unsigned paddingWidth, unsigned paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
-	unsigned dilationWidthFactor, unsigned dilationHeightFactor
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Kernels::Activation &activation,
+	unsigned outputStride = 0 // floats between output pixels when the output is a part of a wider tensor
+);
+
+void Conv2D( // float16 filter
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	unsigned paddingWidth, unsigned paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	const Kernels::Activation &activation,
+	unsigned outputStride = 0
 );
 
 void DepthwiseConv2D(
@@ -26,14 +43,24 @@ void DepthwiseConv2D(
 	unsigned paddingWidth, unsigned paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
 	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
-	unsigned depthMultiplier
+	unsigned depthMultiplier,
+	const Kernels::Activation &activation
 );
 
 void FullyConnected(
 	const TensorShape &inputShape, const float *inputData,
 	const TensorShape &filterShape, const float *filterData,
 	const TensorShape &biasShape, const float *biasData,
-	const TensorShape &outputShape, float *outputData
+	const TensorShape &outputShape, float *outputData,
+	const Kernels::Activation &activation
+);
+
+void FullyConnected( // float16 filter
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const half_float::half *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	const Kernels::Activation &activation
 );
 
 void MaxPool(
@@ -41,7 +68,8 @@ void MaxPool(
 	const TensorShape &outputShape, float *outputData,
 	unsigned paddingWidth, unsigned paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
-	unsigned filterWidth, unsigned filterHeight
+	unsigned filterWidth, unsigned filterHeight,
+	const Kernels::Activation &activation
 );
 
 void AveragePool(
@@ -49,7 +77,100 @@ void AveragePool(
 	const TensorShape &outputShape, float *outputData,
 	unsigned paddingWidth, unsigned paddingHeight,
 	unsigned strideWidth, unsigned strideHeight,
-	unsigned filterWidth, unsigned filterHeight
+	unsigned filterWidth, unsigned filterHeight,
+	const Kernels::Activation &activation
+);
+
+void Softmax(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	float beta
+);
+
+void ResizeBilinear(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	bool alignCorners
+);
+
+void ResizeNearestNeighbor(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	bool alignCorners
+);
+
+void LocalResponseNormalization(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	int radius, float alpha, float beta, float bias
+);
+
+void Mean(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	const int32_t *axis, unsigned axis_count
+);
+
+void Pad(
+	const std::array<int32_t,2>* paddings,
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData
+);
+
+//
+// Reference: serial TF Lite reference implementations (3rdparty/tensorflow/tflite-reference-implementation.cpp)
+// the above operators split their work into slices computed by these functions
+//
+
+namespace Reference {
+
+void Conv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	int paddingWidth, int paddingHeight, // signed: slices of the output have shifted origins
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	float activationMin, float activationMax // fused activation: the output is clamped to [activationMin,activationMax]
+);
+
+void DepthwiseConv2D(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	int paddingWidth, int paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned dilationWidthFactor, unsigned dilationHeightFactor,
+	unsigned depthMultiplier,
+	float activationMin, float activationMax
+);
+
+void FullyConnected(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &filterShape, const float *filterData,
+	const TensorShape &biasShape, const float *biasData,
+	const TensorShape &outputShape, float *outputData,
+	float activationMin, float activationMax
+);
+
+void MaxPool(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	int paddingWidth, int paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	float activationMin, float activationMax
+);
+
+void AveragePool(
+	const TensorShape &inputShape, const float *inputData,
+	const TensorShape &outputShape, float *outputData,
+	int paddingWidth, int paddingHeight,
+	unsigned strideWidth, unsigned strideHeight,
+	unsigned filterWidth, unsigned filterHeight,
+	float activationMin, float activationMax
 );
 
 void Softmax(
@@ -89,3 +210,5 @@ void Pad(
 );
 
 }
+
+}
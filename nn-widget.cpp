@@ -5,6 +5,10 @@
 
 #include <QMouseEvent>
 #include <QByteArray>
+#include <QPainter>
+#include <QPaintEvent>
+
+#include <algorithm>
 
 
 NnWidget::NnWidget(QWidget *parent)
@@ -19,15 +23,27 @@ void NnWidget::open(const PluginInterface::Model *model_) {
 	load(SvgGraphics::generateModelSvg(model_,
 		{&modelIndexes.allOperatorBoxes, &modelIndexes.allTensorLabelBoxes, &modelIndexes.allInputBoxes, &modelIndexes.allOutputBoxes}));
 	model = model_;
+	operatorHeat.clear();
 }
 
 void NnWidget::close() {
 	clearIndices();
+	operatorHeat.clear();
 	model = nullptr;
 	load(QByteArray());
 	resize(0,0);
 }
 
+void NnWidget::setOperatorHeat(const std::vector<float> &heat) {
+	operatorHeat = heat;
+	update();
+}
+
+void NnWidget::clearOperatorHeat() {
+	operatorHeat.clear();
+	update();
+}
+
 /// overridden
 
 void NnWidget::mousePressEvent(QMouseEvent *event) {
@@ -49,6 +65,21 @@ void NnWidget::mousePressEvent(QMouseEvent *event) {
 	ZoomableSvgWidget::mousePressEvent(event);
 }
 
+void NnWidget::paintEvent(QPaintEvent *event) {
+	// pass
+	ZoomableSvgWidget::paintEvent(event);
+
+	// heat overlay: operator boxes are tinted from transparent to red
+	if (!operatorHeat.empty()) {
+		QPainter painter(this);
+		auto scalingFactor = getScalingFactor();
+		for (PluginInterface::OperatorId oid = 0, oide = std::min(operatorHeat.size(), modelIndexes.allOperatorBoxes.size()); oid < oide; oid++) {
+			auto &box = modelIndexes.allOperatorBoxes[oid];
+			painter.fillRect(QRectF(box.topLeft()*scalingFactor, box.size()*scalingFactor), QColor(255, 0, 0, (int)(200*operatorHeat[oid])));
+		}
+	}
+}
+
 /// internals
 
 void NnWidget::clearIndices() {
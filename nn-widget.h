@@ -9,6 +9,7 @@
 
 #include <QRectF>
 class QMouseEvent;
+class QPaintEvent;
 
 class NnWidget : public ZoomableSvgWidget {
 	Q_OBJECT
@@ -20,6 +21,7 @@ class NnWidget : public ZoomableSvgWidget {
 		std::vector<QRectF> allInputBoxes;       // indexed based on input id
 		std::vector<QRectF> allOutputBoxes;      // indexed based on output id
 	} modelIndexes;
+	std::vector<float> operatorHeat; // by OperatorId in [0..1], operator boxes are tinted by it, empty when there's no overlay
 
 private: // types
 	struct AnyObject {
@@ -35,9 +37,12 @@ public: // constructor
 public: // interface
 	void open(const PluginInterface::Model *model_);
 	void close();
+	void setOperatorHeat(const std::vector<float> &heat); // for example, shares of time of the slowest operator
+	void clearOperatorHeat();
 
 public: // overridden
 	void mousePressEvent(QMouseEvent *event) override;
+	void paintEvent(QPaintEvent *event) override;
 
 signals:
 	void clickedOnOperator(PluginInterface::OperatorId oid);
@@ -18,12 +18,19 @@ enum OperatorsListColumns {
 	OperatorsListColumns_InsOuts,
 	OperatorsListColumns_Complexity,
 	OperatorsListColumns_StaticData,
+	OperatorsListColumns_Time,
+	OperatorsListColumns_Performance,
+	OperatorsListColumns_BytesTouched,
 	OperatorsListColumns_DataRatio,
 	OperatorsListColumns_Count_ // pseudo-element = count of items
 };
 
+static const int SortRole = Qt::UserRole; // numeric values that columns are sorted by
+
 class OperatorsListModel : public QAbstractTableModel {
 	const PluginInterface::Model *model;
+	std::vector<double>           times;        // by operator, negative for operators that weren't timed
+	std::vector<size_t>           bytesTouched; // by operator
 
 public:
 	OperatorsListModel(const PluginInterface::Model *model_, QObject *parent)
@@ -32,6 +39,24 @@ public:
 	{
 	}
 
+	void setProfile(const Compute::Profile &profile) {
+		times.assign(model->numOperators(), -1);
+		bytesTouched.assign(model->numOperators(), 0);
+		for (auto &p : profile) {
+			times[p.oid] = p.time;
+			bytesTouched[p.oid] = p.bytesTouched;
+		}
+		emit dataChanged(index(0, OperatorsListColumns_Time), index(model->numOperators()-1, OperatorsListColumns_BytesTouched));
+	}
+
+private: // helpers
+	bool isTimed(PluginInterface::OperatorId oid) const {
+		return !times.empty() && times[oid] >= 0;
+	}
+	double gflops(PluginInterface::OperatorId oid) const { // achieved performance
+		return times[oid] > 0 ? ModelFunctions::computeOperatorFlops(model, oid)/times[oid]/1e9 : 0;
+	}
+
 private: // QAbstractTableModel interface implementation
 	int rowCount(const QModelIndex &parent = QModelIndex()) const override {
 		return model->numOperators();
@@ -46,6 +71,9 @@ private: // QAbstractTableModel interface implementation
 			tr("Ins/Outs"),
 			tr("Complexity"),
 			tr("Static Data"),
+			tr("Time"),
+			tr("GFLOP/s"),
+			tr("Bytes Touched"),
 			tr("Data Ratio")
 		};
 		switch (orientation) {
@@ -78,6 +106,18 @@ private: // QAbstractTableModel interface implementation
 				unsigned unused;
 				return QString("%1 bytes").arg(S2Q(Util::formatUIntHumanReadable(
 					ModelFunctions::sizeOfOperatorStaticData(model, (PluginInterface::OperatorId)index.row(), unused))));
+			} case OperatorsListColumns_Time: {
+				if (!isTimed(index.row()))
+					return QVariant();
+				return QString("%1 ms").arg(times[index.row()]*1000, 0, 'f', 3);
+			} case OperatorsListColumns_Performance: {
+				if (!isTimed(index.row()))
+					return QVariant();
+				return QString::number(gflops(index.row()), 'f', 2);
+			} case OperatorsListColumns_BytesTouched: {
+				if (!isTimed(index.row()))
+					return QVariant();
+				return QString("%1 bytes").arg(S2Q(Util::formatUIntHumanReadable(bytesTouched[index.row()])));
 			} case OperatorsListColumns_DataRatio: {
 				float dataRateIncreaseAboveInput, modelInputToOut;
 				return S2Q(ModelFunctions::dataRatioOfOperatorStr(model, (PluginInterface::OperatorId)index.row(),
@@ -85,6 +125,32 @@ private: // QAbstractTableModel interface implementation
 			} default:
 				return QVariant();
 			}
+		case SortRole:
+			switch ((OperatorsListColumns)index.column()) {
+			case OperatorsListColumns_No:
+				return QVariant(index.row());
+			case OperatorsListColumns_Kind:
+				return data(index, Qt::DisplayRole);
+			case OperatorsListColumns_InsOuts: {
+				std::vector<PluginInterface::TensorId> inputs, outputs;
+				model->getOperatorIo(index.row(), inputs, outputs);
+				return QVariant((unsigned)(inputs.size() + outputs.size()));
+			} case OperatorsListColumns_Complexity:
+				return QVariant((qulonglong)ModelFunctions::computeOperatorFlops(model, (PluginInterface::OperatorId)index.row()));
+			case OperatorsListColumns_StaticData: {
+				unsigned unused;
+				return QVariant((qulonglong)ModelFunctions::sizeOfOperatorStaticData(model, (PluginInterface::OperatorId)index.row(), unused));
+			} case OperatorsListColumns_Time:
+				return QVariant(isTimed(index.row()) ? times[index.row()] : -1.);
+			case OperatorsListColumns_Performance:
+				return QVariant(isTimed(index.row()) ? gflops(index.row()) : -1.);
+			case OperatorsListColumns_BytesTouched:
+				return QVariant((qulonglong)(isTimed(index.row()) ? bytesTouched[index.row()] : 0));
+			case OperatorsListColumns_DataRatio:
+				return QVariant(ModelFunctions::dataRatioOfOperator(model, (PluginInterface::OperatorId)index.row()));
+			default:
+				return QVariant();
+			}
 		case Qt::DecorationRole: // icon
 			switch ((OperatorsListColumns)index.column()) {
 			case OperatorsListColumns_DataRatio: {
@@ -141,7 +207,7 @@ void OperatorsListWidget::selectionChanged(const QItemSelection &selected, const
 
 	// emit signal
 	if (!self && selected.indexes().size() == OperatorsListColumns_Count_)
-		emit operatorSelected((PluginInterface::OperatorId)selected.indexes()[0].row());
+		emit operatorSelected((PluginInterface::OperatorId)sortModel->mapToSource(selected.indexes()[0]).row());
 
 	// pass
 	QTableView::selectionChanged(selected, deselected);
@@ -151,7 +217,12 @@ void OperatorsListWidget::selectionChanged(const QItemSelection &selected, const
 
 void OperatorsListWidget::setNnModel(const PluginInterface::Model *model) {
 	tableModel.reset(new OperatorsListModel(model, this));
-	setModel(tableModel.get());
+	sortModel.reset(new QSortFilterProxyModel(this));
+	sortModel->setSourceModel(tableModel.get());
+	sortModel->setSortRole(SortRole);
+	setModel(sortModel.get());
+	setSortingEnabled(true);
+	sortByColumn(OperatorsListColumns_No, Qt::AscendingOrder);
 
 	// set width/stretching behavior
 	for (unsigned s = OperatorsListColumns_No; s < OperatorsListColumns_DataRatio; s++)
@@ -160,12 +231,18 @@ void OperatorsListWidget::setNnModel(const PluginInterface::Model *model) {
 }
 
 void OperatorsListWidget::clearNnModel() {
-	tableModel.reset(nullptr);
 	setModel(nullptr);
+	sortModel.reset(nullptr);
+	tableModel.reset(nullptr);
 }
 
 void OperatorsListWidget::selectOperator(PluginInterface::OperatorId operatorId) {
 	self = true;
-	selectRow((int)operatorId);
+	selectRow(sortModel->mapFromSource(tableModel->index((int)operatorId, 0)).row());
 	self = false;
 }
+
+void OperatorsListWidget::setProfile(const Compute::Profile &profile) {
+	if (tableModel)
+		static_cast<OperatorsListModel*>(tableModel.get())->setProfile(profile);
+}
@@ -4,15 +4,18 @@
 
 #include <QTableView>
 #include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
 
 #include <memory>
 
+#include "compute.h"
 #include "plugin-interface.h"
 
 class OperatorsListWidget : public QTableView {
 	Q_OBJECT
 
 	std::unique_ptr<QAbstractTableModel>    tableModel;
+	std::unique_ptr<QSortFilterProxyModel>  sortModel;   // rows are sorted by any column, they are mapped to operators through it
 	bool                                    self;        // to prevent signals from programmatically changed values
 
 public: // constructor
@@ -25,6 +28,7 @@ public: // interface
 	void setNnModel(const PluginInterface::Model *model);
 	void clearNnModel();
 	void selectOperator(PluginInterface::OperatorId operatorId);
+	void setProfile(const Compute::Profile &profile); // timings of the last computation
 
 signals:
 	void operatorSelected(PluginInterface::OperatorId operatorId);
@@ -4,6 +4,7 @@
 #include "options-dialog.h"
 
 #include <QDoubleValidator>
+#include <QIntValidator>
 
 #include <limits>
 
@@ -15,6 +16,18 @@ OptionsDialog::OptionsDialog(Options &options_, QWidget *parent)
 , closeModelForTrainingModelCheckBox(this)
 , nearZeroCoefficientLabel(tr("Near Zero Coefficient"), this)
 , nearZeroCoefficientEditBox(this)
+, numComputeThreadsLabel(tr("Compute Threads"), this)
+, numComputeThreadsEditBox(this)
+, deterministicComputeLabel(tr("Deterministic Compute"), this)
+, deterministicComputeCheckBox(this)
+, compareQuantizedLabel(tr("Compare Quantized With Float Reference"), this)
+, compareQuantizedCheckBox(this)
+, fuseOperatorsLabel(tr("Fuse Operators"), this)
+, fuseOperatorsCheckBox(this)
+, tensorRetentionLabel(tr("Keep Computed Tensors"), this)
+, tensorRetentionComboBox(this)
+, checkpointIntervalLabel(tr("Checkpoint Interval"), this)
+, checkpointIntervalEditBox(this)
 , buttonBox(QDialogButtonBox::Ok, Qt::Horizontal, this)
 {
 	// title
@@ -25,24 +38,62 @@ OptionsDialog::OptionsDialog(Options &options_, QWidget *parent)
 	layout.addWidget(&closeModelForTrainingModelCheckBox,        0/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
 	layout.addWidget(&nearZeroCoefficientLabel,                  1/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
 	layout.addWidget(&nearZeroCoefficientEditBox,                1/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
-	layout.addWidget(&buttonBox,                                 2/*row*/, 1/*col*/, 1/*rowSpan*/, 2/*columnSpan*/);
+	layout.addWidget(&numComputeThreadsLabel,                    2/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&numComputeThreadsEditBox,                  2/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&deterministicComputeLabel,                 3/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&deterministicComputeCheckBox,              3/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&compareQuantizedLabel,                     4/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&compareQuantizedCheckBox,                  4/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&fuseOperatorsLabel,                        5/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&fuseOperatorsCheckBox,                     5/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&tensorRetentionLabel,                      6/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&tensorRetentionComboBox,                   6/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&checkpointIntervalLabel,                   7/*row*/, 0/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&checkpointIntervalEditBox,                 7/*row*/, 1/*col*/, 1/*rowSpan*/, 1/*columnSpan*/);
+	layout.addWidget(&buttonBox,                                 8/*row*/, 1/*col*/, 1/*rowSpan*/, 2/*columnSpan*/);
 
 	// alignment
-	for (auto l : {&closeModelForTrainingModelLabel,&nearZeroCoefficientLabel})
+	for (auto l : {&closeModelForTrainingModelLabel,&nearZeroCoefficientLabel,&numComputeThreadsLabel,&deterministicComputeLabel,&compareQuantizedLabel,&fuseOperatorsLabel,&tensorRetentionLabel,&checkpointIntervalLabel})
 		l->setAlignment(Qt::AlignRight|Qt::AlignVCenter);
 
+	// combobox items
+	tensorRetentionComboBox.addItem(tr("All"),                        Options::TensorRetention_KeepAll);
+	tensorRetentionComboBox.addItem(tr("Outputs and the viewed one"), Options::TensorRetention_KeepOutputs);
+	tensorRetentionComboBox.addItem(tr("Checkpoints"),                Options::TensorRetention_KeepCheckpoints);
+
 	// set values
 	closeModelForTrainingModelCheckBox.setCheckState(options.getCloseModelForTrainingModel() ? Qt::Checked : Qt::Unchecked);
 	nearZeroCoefficientEditBox.setText(QString("%1").arg(options.getNearZeroCoefficient()));
+	numComputeThreadsEditBox.setText(QString("%1").arg(options.getNumComputeThreads()));
+	deterministicComputeCheckBox.setCheckState(options.getDeterministicCompute() ? Qt::Checked : Qt::Unchecked);
+	compareQuantizedCheckBox.setCheckState(options.getCompareQuantized() ? Qt::Checked : Qt::Unchecked);
+	fuseOperatorsCheckBox.setCheckState(options.getFuseOperators() ? Qt::Checked : Qt::Unchecked);
+	tensorRetentionComboBox.setCurrentIndex(tensorRetentionComboBox.findData(options.getTensorRetention()));
+	checkpointIntervalEditBox.setText(QString("%1").arg(options.getCheckpointInterval()));
+	checkpointIntervalEditBox.setEnabled(options.getTensorRetention() == Options::TensorRetention_KeepCheckpoints);
 
 	// tooltips
 	for (auto w : {(QWidget*)&closeModelForTrainingModelLabel,(QWidget*)&closeModelForTrainingModelCheckBox})
 		w->setToolTip(tr("Close the trained model window when the training model is generated."));
 	for (auto w : {(QWidget*)&nearZeroCoefficientLabel,(QWidget*)&nearZeroCoefficientEditBox})
 		w->setToolTip(tr("Coefficient determining what values are considered to be near-zero. It is multiplied by a maximum of the absolute values of the value range."));
+	for (auto w : {(QWidget*)&numComputeThreadsLabel,(QWidget*)&numComputeThreadsEditBox})
+		w->setToolTip(tr("Number of threads that computations are split between. 0 means the number of hardware threads."));
+	for (auto w : {(QWidget*)&deterministicComputeLabel,(QWidget*)&deterministicComputeCheckBox})
+		w->setToolTip(tr("Compute operators one at a time in the order of the model instead of computing independent operators concurrently. Useful for debugging."));
+	for (auto w : {(QWidget*)&compareQuantizedLabel,(QWidget*)&compareQuantizedCheckBox})
+		w->setToolTip(tr("Also compute quantized models in floating point after every computation, and print how much their outputs differ from the integer kernels."));
+	for (auto w : {(QWidget*)&fuseOperatorsLabel,(QWidget*)&fuseOperatorsCheckBox})
+		w->setToolTip(tr("Fold Pad operators into the convolutions that follow them, and constant Mul, Add and Sub into the convolutions and fully connected operators that precede them. Applied to models opened afterwards."));
+	for (auto w : {(QWidget*)&tensorRetentionLabel,(QWidget*)&tensorRetentionComboBox})
+		w->setToolTip(tr("Computed tensors that stay in memory after the computation. Keeping fewer of them saves memory on large models, discarded tensors are recomputed when they are viewed."));
+	for (auto w : {(QWidget*)&checkpointIntervalLabel,(QWidget*)&checkpointIntervalEditBox})
+		w->setToolTip(tr("Outputs of every N-th operator are kept as checkpoints that discarded tensors are recomputed from."));
 
 	// validators
 	nearZeroCoefficientEditBox.setValidator(new QDoubleValidator(std::numeric_limits<double>::min(), std::numeric_limits<double>::max(), 3/*decimals*/, this));
+	numComputeThreadsEditBox.setValidator(new QIntValidator(0, 1024, this));
+	checkpointIntervalEditBox.setValidator(new QIntValidator(1, 1024, this));
 
 	// connect signals
 	connect(&closeModelForTrainingModelCheckBox, &QCheckBox::stateChanged, [this](int state) {
@@ -51,6 +102,26 @@ OptionsDialog::OptionsDialog(Options &options_, QWidget *parent)
 	connect(&nearZeroCoefficientEditBox, &QLineEdit::textChanged, [this](const QString &text) {
 		options.setNearZeroCoefficient(text.toDouble());
 	});
+	connect(&numComputeThreadsEditBox, &QLineEdit::editingFinished, [this]() {
+		options.setNumComputeThreads(numComputeThreadsEditBox.text().toUInt());
+	});
+	connect(&deterministicComputeCheckBox, &QCheckBox::stateChanged, [this](int state) {
+		options.setDeterministicCompute(state != 0);
+	});
+	connect(&compareQuantizedCheckBox, &QCheckBox::stateChanged, [this](int state) {
+		options.setCompareQuantized(state != 0);
+	});
+	connect(&fuseOperatorsCheckBox, &QCheckBox::stateChanged, [this](int state) {
+		options.setFuseOperators(state != 0);
+	});
+	connect(&tensorRetentionComboBox, QOverload<int>::of(&QComboBox::activated), [this](int) {
+		options.setTensorRetention((Options::TensorRetention)tensorRetentionComboBox.currentData().toUInt());
+		checkpointIntervalEditBox.setEnabled(options.getTensorRetention() == Options::TensorRetention_KeepCheckpoints);
+	});
+	connect(&checkpointIntervalEditBox, &QLineEdit::textChanged, [this](const QString &text) {
+		if (text.toUInt() > 0)
+			options.setCheckpointInterval(text.toUInt());
+	});
 	connect(&buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
 }
 
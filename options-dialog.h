@@ -10,6 +10,7 @@
 #include "options.h"
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDialog>
 #include <QDialogButtonBox>
 #include <QLineEdit>
@@ -26,6 +27,18 @@ class OptionsDialog : public QDialog {
 	QCheckBox                         closeModelForTrainingModelCheckBox;
 	QLabel                            nearZeroCoefficientLabel;
 	QLineEdit                         nearZeroCoefficientEditBox;
+	QLabel                            numComputeThreadsLabel;
+	QLineEdit                         numComputeThreadsEditBox;
+	QLabel                            deterministicComputeLabel;
+	QCheckBox                         deterministicComputeCheckBox;
+	QLabel                            compareQuantizedLabel;
+	QCheckBox                         compareQuantizedCheckBox;
+	QLabel                            fuseOperatorsLabel;
+	QCheckBox                         fuseOperatorsCheckBox;
+	QLabel                            tensorRetentionLabel;
+	QComboBox                         tensorRetentionComboBox;
+	QLabel                            checkpointIntervalLabel;
+	QLineEdit                         checkpointIntervalEditBox;
 	QDialogButtonBox                  buttonBox;
 
 public:
@@ -10,6 +10,12 @@
 Options::Options()
 : closeModelForTrainingModel(appSettings.value("Options.closeModelForTrainingModel", true).toBool())
 , nearZeroCoefficient(appSettings.value("Options.nearZeroCoefficient", 0.000001).toFloat())
+, numComputeThreads(appSettings.value("Options.numComputeThreads", 0).toUInt())
+, deterministicCompute(appSettings.value("Options.deterministicCompute", false).toBool())
+, compareQuantized(appSettings.value("Options.compareQuantized", false).toBool())
+, fuseOperators(appSettings.value("Options.fuseOperators", false).toBool())
+, tensorRetention((TensorRetention)appSettings.value("Options.tensorRetention", TensorRetention_KeepAll).toUInt())
+, checkpointInterval(appSettings.value("Options.checkpointInterval", 8).toUInt())
 {
 }
 
@@ -32,3 +38,32 @@ void Options::setNearZeroCoefficient(float val) {
 	appSettings.setValue(QString("Options.nearZeroCoefficient"), val);
 }
 
+void Options::setNumComputeThreads(unsigned val) {
+	numComputeThreads = val;
+	appSettings.setValue(QString("Options.numComputeThreads"), val);
+}
+
+void Options::setDeterministicCompute(bool val) {
+	deterministicCompute = val;
+	appSettings.setValue(QString("Options.deterministicCompute"), val);
+}
+
+void Options::setCompareQuantized(bool val) {
+	compareQuantized = val;
+	appSettings.setValue(QString("Options.compareQuantized"), val);
+}
+
+void Options::setFuseOperators(bool val) {
+	fuseOperators = val;
+	appSettings.setValue(QString("Options.fuseOperators"), val);
+}
+
+void Options::setTensorRetention(TensorRetention val) {
+	tensorRetention = val;
+	appSettings.setValue(QString("Options.tensorRetention"), (unsigned)val);
+}
+
+void Options::setCheckpointInterval(unsigned val) {
+	checkpointInterval = val;
+	appSettings.setValue(QString("Options.checkpointInterval"), val);
+}
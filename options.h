@@ -3,9 +3,22 @@
 #pragma once
 
 class Options {
-
+public: // types
+	enum TensorRetention { // which computed tensors stay in memory after the computation, discarded ones are recomputed when they are viewed
+		TensorRetention_KeepAll,        // all of them
+		TensorRetention_KeepOutputs,    // model outputs, and the tensor that is viewed
+		TensorRetention_KeepCheckpoints // also outputs of every N-th operator, discarded tensors are recomputed from the nearest ones
+	};
+
+private:
 	bool        closeModelForTrainingModel;
 	float       nearZeroCoefficient; // a coefficient that defines what "near-zero" is
+	unsigned    numComputeThreads;   // threads that computations use, 0 means the number of hardware threads, applied when the options dialog is closed
+	bool        deterministicCompute; // operators are computed one at a time in the model order, for debugging
+	bool        compareQuantized;    // quantized models are also computed in floating point, and differences of outputs are printed
+	bool        fuseOperators;       // Pad and affine operators are fused into neighboring convolutions, applied when a model is opened
+	TensorRetention tensorRetention;
+	unsigned    checkpointInterval;  // operators between checkpoints with TensorRetention_KeepCheckpoints
 
 public: // constr
 	Options();
@@ -16,10 +29,22 @@ public: // static options object
 public: // get-interface
 	bool        getCloseModelForTrainingModel() const {return closeModelForTrainingModel;}
 	float       getNearZeroCoefficient() const {return nearZeroCoefficient;}
+	unsigned    getNumComputeThreads() const {return numComputeThreads;}
+	bool        getDeterministicCompute() const {return deterministicCompute;}
+	bool        getCompareQuantized() const {return compareQuantized;}
+	bool        getFuseOperators() const {return fuseOperators;}
+	TensorRetention getTensorRetention() const {return tensorRetention;}
+	unsigned    getCheckpointInterval() const {return checkpointInterval;}
 
 private: // set-interface
 	void        setCloseModelForTrainingModel(bool val);
 	void        setNearZeroCoefficient(float val);
+	void        setNumComputeThreads(unsigned val);
+	void        setDeterministicCompute(bool val);
+	void        setCompareQuantized(bool val);
+	void        setFuseOperators(bool val);
+	void        setTensorRetention(TensorRetention val);
+	void        setCheckpointInterval(unsigned val);
 
 	friend class OptionsDialog;
 };
@@ -7,6 +7,7 @@
 //
 
 #include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -61,6 +62,7 @@ public:
 		KindSign,
 		// Data manipulations
 		KindDequantize,  // convert any type of qint8, quint8, qint32, qint16, quint16 float
+		KindQuantize,    // convert float to qint8 or quint8
 		// Misc
 		KindArgMax,
 		KindArgMin,
@@ -90,6 +92,12 @@ public:
 		// TODO? BOOL, STRING, COMPLEX64 are also supported in TfLite specification
 	};
 
+	struct TensorQuantization { // quantized values q of int8/uint8/int32 tensors represent real values scale*(q - zeroPoint)
+		std::vector<float>    scales;             // one for the whole tensor, or one per slice along quantizedDimension
+		std::vector<int64_t>  zeroPoints;         // as many as scales
+		unsigned              quantizedDimension; // only meaningful with per-slice scales
+	};
+
 	enum PaddingType {
 		PaddingType_SAME,    // pad with zeros where data isn't available, result has the same shape
 		PaddingType_VALID    // no padding, iterate only when all data is available for the extent of the kernel, result has a smaller shape
@@ -255,6 +263,12 @@ if (false) {
 		virtual void*                   getTensorDataWr(TensorId tensorId) const = 0;                                   // writable buffer, when writable, otherwise nullptr
 		virtual const float*            getTensorDataF32(TensorId tensorId) const = 0;                                  // can only be called when getTensorHasData()=true
 		virtual bool                    getTensorIsVariableFlag(TensorId tensorId) const = 0;                           // some tensors are variables that can be altered
+		virtual bool                    getTensorQuantization(TensorId tensorId, TensorQuantization &quantization) const = 0; // false when the tensor isn't quantized
+		// owning reference to the data of getTensorDataF32(): models that produce data on demand can release their own references
+		// to it, while the data stays valid for its users, by default the data lives as long as the model
+		virtual std::shared_ptr<const float> getTensorDataF32Shared(TensorId tensorId) const {
+			return std::shared_ptr<const float>(getTensorDataF32(tensorId), [](const float*) { });
+		}
 
 	public: // convenience functions
 		bool isTensorComputed(TensorId tensorId) const;
@@ -90,7 +90,7 @@ CASE(PAD, Pad)
 CASE(PADV2, Unknown)
 CASE(POW, Unknown)
 CASE(PRELU, Unknown)
-CASE(QUANTIZE, Unknown)
+CASE(QUANTIZE, Quantize)
 CASE(RANGE, Unknown)
 CASE(RANK, Unknown)
 CASE(REDUCE_ANY, Unknown)
@@ -176,6 +176,19 @@ class TfLitePlugin : public PluginInterface {
 			bool getTensorIsVariableFlag(TensorId tensorId) const override {
 				return subgraph->tensors()->Get(tensorId)->is_variable();
 			}
+			bool getTensorQuantization(TensorId tensorId, TensorQuantization &quantization) const override {
+				auto q = subgraph->tensors()->Get(tensorId)->quantization();
+				if (q == nullptr || q->scale() == nullptr || q->scale()->size() == 0 || q->details_type() != tflite::QuantizationDetails_NONE) // other quantization kinds aren't supported
+					return false;
+				quantization.scales.clear();
+				quantization.zeroPoints.clear();
+				Helpers::convertContainers(*q->scale(), quantization.scales);
+				if (q->zero_point() != nullptr)
+					Helpers::convertContainers(*q->zero_point(), quantization.zeroPoints);
+				quantization.zeroPoints.resize(quantization.scales.size(), 0); // zero points can be omitted
+				quantization.quantizedDimension = q->quantized_dimension();
+				return true;
+			}
 	};
 
 	std::string                           modelFileName;
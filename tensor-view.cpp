@@ -0,0 +1,98 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "tensor-view.h"
+
+#include <cstring>
+
+#include <assert.h>
+
+TensorView::TensorView(std::shared_ptr<const float> base_, const TensorShape &shape_)
+: base(base_),
+  offset(0),
+  shape(shape_),
+  strides(shape_.size())
+{
+	ptrdiff_t stride = 1;
+	for (int d = (int)shape.size() - 1; d >= 0; d--) {
+		strides[d] = stride;
+		stride *= shape[d];
+	}
+}
+
+bool TensorView::isContiguous() const {
+	ptrdiff_t stride = 1;
+	for (int d = (int)shape.size() - 1; d >= 0; d--) {
+		if (shape[d] != 1 && strides[d] != stride)
+			return false;
+		stride *= shape[d];
+	}
+	return true;
+}
+
+std::shared_ptr<const float> TensorView::contiguousData() const {
+	assert(isContiguous());
+	return std::shared_ptr<const float>(base, data());
+}
+
+TensorView TensorView::slice(unsigned dim, int begin, unsigned size, int step) const {
+	assert(dim < shape.size() && step != 0);
+	assert(size == 0 || (begin >= 0 && begin < (int)shape[dim] && begin + (int)(size - 1)*step >= 0 && begin + (int)(size - 1)*step < (int)shape[dim]));
+	TensorView view = *this;
+	view.offset += begin*strides[dim];
+	view.shape[dim] = size;
+	view.strides[dim] *= step;
+	return view;
+}
+
+TensorView TensorView::transpose(const std::vector<unsigned> &perm) const {
+	assert(perm.size() == shape.size());
+	TensorView view = *this;
+	for (unsigned d = 0; d < perm.size(); d++) {
+		view.shape[d] = shape[perm[d]];
+		view.strides[d] = strides[perm[d]];
+	}
+	return view;
+}
+
+TensorView TensorView::removeDim(unsigned dim) const {
+	assert(dim < shape.size() && shape[dim] == 1);
+	TensorView view = *this;
+	view.shape.erase(view.shape.begin() + dim);
+	view.strides.erase(view.strides.begin() + dim);
+	return view;
+}
+
+void TensorView::copyTo(float *output) const {
+	auto rank = shape.size();
+	if (Tensor::flatSize(shape) == 0)
+		return;
+	if (rank == 0 || isContiguous()) {
+		std::memcpy(output, data(), Tensor::flatSize(shape)*sizeof(float));
+		return;
+	}
+
+	// iterate over the outer dimensions like an odometer, the innermost dimension is copied by a loop
+	auto innerSize = shape[rank-1];
+	auto innerStride = strides[rank-1];
+	std::vector<unsigned> index(rank, 0);
+	auto input = data();
+	while (true) {
+		if (innerStride == 1)
+			std::memcpy(output, input, innerSize*sizeof(float));
+		else
+			for (unsigned i = 0; i < innerSize; i++)
+				output[i] = input[i*innerStride];
+		output += innerSize;
+
+		int d = (int)rank - 2;
+		for (; d >= 0; d--) {
+			input += strides[d];
+			if (++index[d] < shape[d])
+				break;
+			input -= strides[d]*shape[d];
+			index[d] = 0;
+		}
+		if (d < 0)
+			return;
+	}
+}
@@ -0,0 +1,35 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include "tensor.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//
+// TensorView: elements of another tensor addressed through strides, without copying them
+//             element [i0,i1,...] is at base + offset + i0*strides[0] + i1*strides[1] + ...
+//
+
+struct TensorView {
+	std::shared_ptr<const float> base;   // keeps the data alive, can be nullptr when only the layout is of interest
+	ptrdiff_t                    offset; // of the first element, in floats
+	TensorShape                  shape;
+	std::vector<ptrdiff_t>       strides; // in floats, by dimension, negative for reversed dimensions
+
+	TensorView() : offset(0) { }
+	TensorView(std::shared_ptr<const float> base_, const TensorShape &shape_); // the whole packed tensor
+
+	bool isContiguous() const; // elements are packed in the order of dimensions
+	const float* data() const {return base.get() + offset;}
+	std::shared_ptr<const float> contiguousData() const; // shares ownership of the base, only for contiguous views
+
+	// views of this view
+	TensorView slice(unsigned dim, int begin, unsigned size, int step = 1) const; // elements begin, begin+step, ... along dim
+	TensorView transpose(const std::vector<unsigned> &perm) const; // dimension d of the result is dimension perm[d] of this view
+	TensorView removeDim(unsigned dim) const; // the dimension should have size 1
+
+	void copyTo(float *output) const; // packs elements in the order of dimensions
+};
@@ -0,0 +1,267 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#include "thread-pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <assert.h>
+
+namespace ThreadPool {
+
+namespace {
+
+struct Job { // one parallelFor call, its chunks are grabbed by whichever threads are available
+	const std::function<void(size_t,size_t)> &fn;
+	size_t                                    size;
+	size_t                                    chunk;
+	size_t                                    numChunks;
+	std::atomic<size_t>                       nextChunk;
+	std::atomic<size_t>                       chunksDone;
+	std::mutex                                lock;
+	std::condition_variable                   done;
+
+	Job(const std::function<void(size_t,size_t)> &fn_, size_t size_, size_t chunk_)
+	: fn(fn_)
+	, size(size_)
+	, chunk(chunk_)
+	, numChunks((size_+chunk_-1)/chunk_)
+	, nextChunk(0)
+	, chunksDone(0)
+	{ }
+
+	bool exhausted() const {
+		return nextChunk >= numChunks;
+	}
+	void runChunks() { // runs chunks until none are left to grab
+		for (size_t c; (c = nextChunk++) < numChunks;) {
+			fn(c*chunk, std::min(size, (c+1)*chunk));
+			if (++chunksDone == numChunks) {
+				std::unique_lock<std::mutex> l(lock);
+				done.notify_all();
+			}
+		}
+	}
+	void wait() {
+		std::unique_lock<std::mutex> l(lock);
+		done.wait(l, [this]() {return chunksDone == numChunks;});
+	}
+};
+
+typedef std::function<void()> Task;
+
+thread_local int thisWorker = -1; // index of the pool thread that runs on this thread
+
+class Pool {
+	std::vector<std::thread>           workers; // the calling thread is the one more participant
+	std::atomic<unsigned>              numWorkers;
+	std::mutex                         lock;
+	std::condition_variable            signal;
+	std::condition_variable            idle;    // the pool has become idle while somebody waits for that, or resizing has finished
+	std::deque<std::shared_ptr<Job>>   jobs;
+	std::vector<std::deque<Task>>      taskQueues; // one per worker, and the last one is shared by other threads
+	size_t                             numQueuedTasks = 0;
+	size_t                             numRunningTasks = 0;
+	size_t                             numRunningJobs = 0; // parallelFor calls in progress
+	bool                               stopping = false;
+	unsigned                           numWaitingForIdle = 0;
+	bool                               resizing = false; // the pool is idle and restarted, new work waits for that
+
+public:
+	Pool() {
+		start(0);
+	}
+	~Pool() {
+		std::unique_lock<std::mutex> l(lock);
+		waitForIdle(l); // tasks can still be finishing after their submitters stopped waiting for them
+		l.unlock();
+		stop();
+	}
+	void resize(unsigned numThreads) {
+		std::unique_lock<std::mutex> l(lock);
+		waitForIdle(l);
+		resizing = true;
+		l.unlock();
+		stop();
+		start(numThreads);
+		l.lock();
+		resizing = false;
+		idle.notify_all();
+	}
+	unsigned numThreads() const {
+		return numWorkers+1;
+	}
+	void run(std::shared_ptr<Job> job) {
+		{
+			std::unique_lock<std::mutex> l(lock);
+			idle.wait(l, [this]() {return !resizing;});
+			jobs.push_back(job);
+			numRunningJobs++;
+		}
+		signal.notify_all();
+
+		job->runChunks();
+		job->wait();
+
+		// remove the job unless a worker already did that
+		std::unique_lock<std::mutex> l(lock);
+		auto it = std::find(jobs.begin(), jobs.end(), job);
+		if (it != jobs.end())
+			jobs.erase(it);
+		numRunningJobs--;
+		notifyIfIdle();
+	}
+	void submit(Task &&task) {
+		{
+			std::unique_lock<std::mutex> l(lock);
+			idle.wait(l, [this]() {return !resizing;});
+			taskQueues[ownQueue()].push_back(std::move(task));
+			numQueuedTasks++;
+		}
+		signal.notify_one();
+	}
+	bool runPendingTask() {
+		std::unique_lock<std::mutex> l(lock);
+		if (numQueuedTasks == 0)
+			return false;
+		auto task = takeTask(ownQueue());
+		l.unlock();
+		task();
+		l.lock();
+		taskDone();
+		return true;
+	}
+
+private:
+	void start(unsigned numThreads) {
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		stopping = false;
+		taskQueues.resize(numThreads);
+		for (unsigned t = 1; t < numThreads; t++)
+			workers.push_back(std::thread([this,t]() {work(t-1);}));
+		numWorkers = workers.size();
+	}
+	void stop() {
+		{
+			std::unique_lock<std::mutex> l(lock);
+			assert(isIdle());
+			stopping = true;
+		}
+		signal.notify_all();
+		for (auto &w : workers)
+			w.join();
+		workers.clear();
+		taskQueues.clear();
+	}
+	void waitForIdle(std::unique_lock<std::mutex> &l) {
+		// wait for a moment when no work is queued or running: blocking new work earlier could deadlock threads that run their
+		// own tasks while submitting more of them
+		numWaitingForIdle++;
+		idle.wait(l, [this]() {return !resizing && isIdle();});
+		numWaitingForIdle--;
+	}
+	bool isIdle() const { // called with the lock held
+		return jobs.empty() && numRunningJobs == 0 && numQueuedTasks == 0 && numRunningTasks == 0;
+	}
+	void notifyIfIdle() { // called with the lock held
+		if (numWaitingForIdle > 0 && isIdle())
+			idle.notify_all();
+	}
+	void taskDone() { // called with the lock held
+		numRunningTasks--;
+		notifyIfIdle();
+	}
+	unsigned ownQueue() const {
+		return thisWorker != -1 ? thisWorker : taskQueues.size()-1;
+	}
+	Task takeTask(unsigned own) { // the newest task from the own queue, or the oldest task from another queue (stealing)
+		assert(numQueuedTasks > 0);
+		numQueuedTasks--;
+		numRunningTasks++;
+		Task task;
+		if (!taskQueues[own].empty()) {
+			task = std::move(taskQueues[own].back());
+			taskQueues[own].pop_back();
+			return task;
+		}
+		for (unsigned q = (own+1)%taskQueues.size(); ; q = (q+1)%taskQueues.size())
+			if (!taskQueues[q].empty()) {
+				task = std::move(taskQueues[q].front());
+				taskQueues[q].pop_front();
+				return task;
+			}
+	}
+	void work(unsigned index) {
+		thisWorker = index;
+		std::unique_lock<std::mutex> l(lock);
+		while (true) {
+			signal.wait(l, [this]() {return stopping || !jobs.empty() || numQueuedTasks > 0;});
+			if (stopping)
+				return;
+			if (!jobs.empty()) { // parallelFor chunks first: their callers are waiting for them
+				auto job = jobs.front();
+				if (job->exhausted()) {
+					jobs.pop_front();
+					continue;
+				}
+				l.unlock();
+				job->runChunks();
+				l.lock();
+				continue;
+			}
+			auto task = takeTask(index);
+			l.unlock();
+			task();
+			l.lock();
+			taskDone();
+		}
+	}
+};
+
+Pool& pool() {
+	static Pool p;
+	return p;
+}
+
+}
+
+void setNumThreads(unsigned numThreads) {
+	pool().resize(numThreads);
+}
+
+unsigned getNumThreads() {
+	return pool().numThreads();
+}
+
+void parallelFor(size_t size, size_t grain, const std::function<void(size_t,size_t)> &fn) {
+	grain = std::max(grain, (size_t)1);
+	auto numThreads = getNumThreads();
+
+	// serial fallback for small problems
+	if (numThreads == 1 || size <= grain) {
+		if (size > 0)
+			fn(0, size);
+		return;
+	}
+
+	// a few chunks per thread balance the load when threads are busy with other work
+	auto chunk = std::max(grain, (size+4*numThreads-1)/(4*numThreads));
+	pool().run(std::make_shared<Job>(fn, size, chunk));
+}
+
+void submit(std::function<void()> task) {
+	pool().submit(std::move(task));
+}
+
+bool runPendingTask() {
+	return pool().runPendingTask();
+}
+
+}
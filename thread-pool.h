@@ -0,0 +1,29 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+//
+// ThreadPool is the process-wide pool of threads that compute kernels split their work on
+//
+
+namespace ThreadPool {
+
+// 0 selects the number of hardware threads. Waits until the pool has no work, and new work waits
+// until the pool is resized. It can't be called from tasks or from kernels.
+void setNumThreads(unsigned numThreads);
+unsigned getNumThreads();
+
+// Calls fn(begin,end) for consecutive ranges that cover [0,size) in parallel. Ranges aren't smaller than 'grain' items,
+// work that doesn't exceed one grain is done serially. The calling thread participates, and returns when all ranges are done.
+void parallelFor(size_t size, size_t grain, const std::function<void(size_t,size_t)> &fn);
+
+// Tasks: every pool thread has its own queue of tasks and takes the most recently submitted task from it first,
+// idle threads steal the oldest tasks from other queues. Tasks submitted by other threads go into a shared queue.
+// Threads that wait for tasks to complete should run pending tasks in the meantime: there might be no other pool threads.
+void submit(std::function<void()> task);
+bool runPendingTask(); // runs one pending task on the calling thread, returns false when there are none
+
+}
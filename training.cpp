@@ -446,6 +446,10 @@ std::string verifyDerivatives(
 	OriginalIO originalIO;
 	getModelOriginalIO(trainingModel, originalIO);
 
+	// compile the model once, weights are altered in place so the plan stays valid
+	// all intermediates are kept: after a weight is altered only operators that depend on it are computed again
+	std::unique_ptr<Compute::Plan> plan(Compute::compile(trainingModel, true/*keepAllIntermediates*/));
+
 	std::ostringstream ss;
 	auto wrapLine = [](const std::string &line) {
 		return STR(line << std::endl);
@@ -486,9 +490,10 @@ std::string verifyDerivatives(
 
 		// compute the loss for the center point
 		assert(trainingIO.lossOutputs.size()==1); // only support single-output models for now
-		Compute::compute(trainingModel, tensorData, [](PI::TensorId) {}, [](const std::string&) {});
+		Compute::run(*plan, tensorData, [](PI::TensorId) {}, [](const std::string&) {});
 		auto loss = (*tensorData)[trainingIO.lossOutputs[0]].get()[0];
 
+		std::vector<PI::TensorId> changedTensors; // weights altered since the last computation
 		auto testOnePoint = [&](PI::TensorId parameterTid, const std::vector<unsigned> &pt) {
 			// offset of the weight point
 			auto offset = Tensor::offset(trainingModel->getTensorShape(parameterTid), pt);
@@ -498,11 +503,13 @@ std::string verifyDerivatives(
 			// alter the weight
 			float prevValue = weightValue;
 			weightValue += delta;
+			changedTensors.push_back(parameterTid);
 			// compute loss
-			Compute::compute(trainingModel, tensorData, [](PI::TensorId) {}, [](const std::string&) {});
+			Compute::runIncremental(*plan, tensorData, changedTensors, [](PI::TensorId) {}, [](const std::string&) {});
 			auto lossPlus = (*tensorData)[trainingIO.lossOutputs[0]].get()[0];
-			// bring the weight value back
+			// bring the weight value back, results computed from it are stale now
 			weightValue = prevValue;
+			changedTensors = {parameterTid};
 			// find a derivative value
 			assert(trainingIO.parameterToDerivativeOutputs.find(parameterTid) != trainingIO.parameterToDerivativeOutputs.end());
 			auto derivativeTid = trainingIO.parameterToDerivativeOutputs.find(parameterTid)->second;
@@ -562,6 +569,9 @@ bool runTrainingLoop(
 	OriginalIO originalIO;
 	getModelOriginalIO(trainingModel, originalIO);
 
+	// compile the model once, parameters are updated in place so the plan stays valid
+	std::unique_ptr<Compute::Plan> plan(Compute::compile(trainingModel));
+
 	// allocate tensors
 	std::unique_ptr<std::vector<std::shared_ptr<const float>>> tensorData(new std::vector<std::shared_ptr<const float>>);
 	tensorData->resize(numTensors);
@@ -640,7 +650,7 @@ bool runTrainingLoop(
 			assert(trainingIO.targetInputs.size()==1); // only support single output models for now
 			assignTensor(trainingIO.targetInputs[0], sampleData[1].data(), sampleData[1].size());
 			// compute
-			Compute::compute(trainingModel, tensorData, [](PI::TensorId) {}, [](const std::string&) {});
+			Compute::run(*plan, tensorData, [](PI::TensorId) {}, [](const std::string&) {});
 			// add loss
 			totalLoss += (*tensorData)[trainingIO.lossOutputs[0]].get()[0];
 			// add derivatives to accumulator
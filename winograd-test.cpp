@@ -0,0 +1,86 @@
+// Copyright (C) 2022 by Yuri Victorovich. All rights reserved.
+
+//
+// winograd-test: compares the Winograd convolution with the TF Lite reference convolution on random shapes
+//                the Winograd transforms reorder floating point operations, so results are compared with a tolerance
+//
+
+#include "kernels/winograd.h"
+#include "nn-operators.h"
+#include "nn-types.h"
+#include "misc.h"
+#include "rng.h"
+#include "tensor.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <tuple>
+#include <vector>
+
+static unsigned randomInt(unsigned lo, unsigned hi) { // [lo..hi]
+	return std::uniform_int_distribution<unsigned>(lo, hi)(Rng::generator);
+}
+
+static std::vector<float> randomData(const TensorShape &shape) {
+	std::uniform_real_distribution<float> dist(-1, 1);
+	std::vector<float> data(Tensor::flatSize(shape));
+	for (auto &v : data)
+		v = dist(Rng::generator);
+	return data;
+}
+
+static bool testCase(unsigned N, unsigned H, unsigned W, unsigned I, unsigned O, bool samePadding, unsigned m, bool relu6) {
+	unsigned outH = samePadding ? H : H-2, outW = samePadding ? W : W-2;
+	TensorShape inputShape = {N, H, W, I}, filterShape = {O, 3, 3, I}, biasShape = {O}, outputShape = {N, outH, outW, O};
+
+	auto input = randomData(inputShape), filter = randomData(filterShape), bias = randomData(biasShape);
+	unsigned paddingWidth = std::get<0>(computePaddingValues(1, 1, W, 3, outW));
+	unsigned paddingHeight = std::get<0>(computePaddingValues(1, 1, H, 3, outH));
+
+	std::vector<float> expected(Tensor::flatSize(outputShape)), actual(Tensor::flatSize(outputShape));
+	NnOperators::Reference::Conv2D(
+		inputShape, input.data(),
+		filterShape, filter.data(),
+		biasShape, bias.data(),
+		outputShape, expected.data(),
+		paddingWidth, paddingHeight,
+		1, 1,
+		1, 1,
+		relu6 ? 0 : -std::numeric_limits<float>::infinity(), relu6 ? 6 : std::numeric_limits<float>::infinity()
+	);
+	Kernels::Winograd::Conv2D(
+		inputShape, input.data(),
+		*Kernels::Winograd::transformFilter(filterShape, filter.data(), m),
+		bias.data(),
+		outputShape, actual.data(),
+		paddingWidth, paddingHeight,
+		relu6 ? Kernels::Activation::clamp(0, 6) : Kernels::Activation()
+	);
+
+	// every output sums 9*I products of values in [-1,1], the error of the transforms grows with the length of these sums
+	float tolerance = 1e-4*std::sqrt(float(9*I));
+	for (size_t i = 0, ie = expected.size(); i < ie; i++)
+		if (std::fabs(expected[i] - actual[i]) > tolerance) {
+			PRINT("mismatch: N=" << N << " H=" << H << " W=" << W << " I=" << I << " O=" << O
+			      << " padding=" << (samePadding ? "SAME" : "VALID") << " m=" << m << " relu6=" << relu6
+			      << " at " << i << ": expected=" << expected[i] << " actual=" << actual[i] << " tolerance=" << tolerance)
+			return false;
+		}
+	return true;
+}
+
+int main() {
+	Rng::generator.seed(2022); // fixed seed for reproducible cases
+
+	unsigned numCases = 300, numFailed = 0;
+	for (unsigned c = 0; c < numCases; c++) {
+		bool samePadding = randomInt(0, 1);
+		unsigned minHW = samePadding ? 1 : 3;
+		if (!testCase(randomInt(1, 2), randomInt(minHW, 24), randomInt(minHW, 24), randomInt(1, 48), randomInt(1, 48), samePadding, randomInt(0, 1) ? 4 : 2, randomInt(0, 1)))
+			numFailed++;
+	}
+
+	PRINT("winograd-test: " << numCases-numFailed << " of " << numCases << " cases passed")
+	return numFailed==0 ? 0 : 1;
+}